@@ -0,0 +1,85 @@
+// arbitrator_bench.cpp
+// The flat waiter against the combining-tree waiter (common/arbitrator.h) on rings
+// from 5 to a million philosophers, with and without bounded waiting. Each run steps
+// the table for a fixed number of turns and reports
+//   meals/turn      throughput in the simulation's own time
+//   Mmeals/s        wall-clock throughput of the stepping loop
+//   hottest         items the busiest arbitrator handled per turn: what one waiter
+//                   thread (or lock) would have to get through every turn
+//   root            the same for the top arbitrator
+//   escalated       requests that left their leaf, per turn
+//   longest wait    turns, counting philosophers still hungry at the end
+// Every meal goes through the table's safety checker.
+//
+// Compile: g++ -std=c++17 -O2 arbitrator_bench.cpp -o arbitrator_bench
+// Run:     ./arbitrator_bench [--sizes 5,50,...] [--turns t] [--leaf k] [--fanout f]
+//                            [--bound w]
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <functional>
+#include <cstdlib>
+#include "../common/arbitrator.h"
+
+using Clock = std::chrono::steady_clock;
+
+void usage(const char *prog) {
+    std::cerr << "usage: " << prog << " [--sizes n,n,...] [--turns t>=1] [--leaf k>=2] [--fanout f>=2]"
+              << " [--bound w>=1]\n";
+    std::exit(1);
+}
+
+void row(int n, const std::string &name, arbiter::Arbitrated &t, int turns) {
+    auto start = Clock::now();
+    for (int k = 0; k < turns; k++) t.step();
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+    const arbiter::Load &l = t.load();
+    std::cout << std::setw(8) << n << "  " << std::left << std::setw(14) << name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(12) << (double)t.meals() / turns << std::setw(10)
+              << t.meals() / secs / 1e6 << std::setprecision(1) << std::setw(11) << (double)l.hottest / turns
+              << std::setw(10) << (double)l.root / turns << std::setw(11) << (double)l.escalated / turns
+              << std::setw(14) << t.longest_wait() << "\n";
+}
+
+int main(int argc, char **argv) {
+    std::vector<int> sizes = {5, 50, 500, 5000, 50000, 500000, 1000000};
+    int turns = 100, leaf = 64, fanout = 8, bound = 8;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (a + 1 >= argc) usage(argv[0]);
+        std::string val = argv[++a];
+        if (arg == "--sizes") {
+            sizes.clear();
+            std::stringstream ss(val);
+            std::string s;
+            while (std::getline(ss, s, ',')) sizes.push_back(std::atoi(s.c_str()));
+        } else if (arg == "--turns") turns = std::atoi(val.c_str());
+        else if (arg == "--leaf") leaf = std::atoi(val.c_str());
+        else if (arg == "--fanout") fanout = std::atoi(val.c_str());
+        else if (arg == "--bound") bound = std::atoi(val.c_str());
+        else usage(argv[0]);
+    }
+    if (sizes.empty() || turns < 1 || leaf < 2 || fanout < 2 || bound < 1) usage(argv[0]);
+    for (int n : sizes)
+        if (n < 2) usage(argv[0]);
+
+    std::cout << "Arbitrators: " << turns << " turns, leaves of " << leaf << ", fanout " << fanout
+              << ", bounded wait " << bound << " turns\n"
+              << "       n  arbitrator      meals/turn  Mmeals/s    hottest      root  escalated  longest wait\n";
+    for (int n : sizes) {
+        arbiter::FlatWaiter flat(n);
+        row(n, "flat", flat, turns);
+        arbiter::TreeWaiter tree(n, leaf, fanout, 0);
+        row(n, "tree", tree, turns);
+        arbiter::FlatWaiter flat_bounded(n, bound);
+        row(n, "flat bounded", flat_bounded, turns);
+        arbiter::TreeWaiter tree_bounded(n, leaf, fanout, bound);
+        row(n, "tree bounded", tree_bounded, turns);
+    }
+    return 0;
+}
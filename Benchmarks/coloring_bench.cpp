@@ -0,0 +1,141 @@
+// coloring_bench.cpp
+// Static color-class schedules (common/ring_coloring.h) against the dynamic strategies
+// on saturated tables, where every philosopher is hungry again as soon as it has
+// thought for a turn:
+//   coloring       optimal proper coloring, one class per turn
+//   rotation       optimal k-fold coloring of odd rings
+//   waiter         flat waiter granting in index order (common/arbitrator.h)
+//   waiter-bounded the same with bounded waiting
+//   monitor, semaphore, hierarchy
+//                  the hosted kernels from common/table_kernels.h
+// Meals take one turn. Reported per ring size: meals per turn, the peak number of
+// philosophers eating in one turn, fork checks per meal and the longest wait (the
+// kernels do not track the last two). With --hunger p < 1 a thinker only gets hungry
+// with probability p each turn, which exercises the schedules' dynamic fallback; the
+// kernels, which have no such setting, are left out.
+//
+// The schedules and waiters run a two-turn cycle: a meal, then a turn of thinking. A
+// kernel may spend more turns per meal even with the table to itself (the hierarchy
+// kernel takes its forks the turn after it gets hungry, so its cycle is three turns).
+// Such rows are marked with * and their cycle is printed below the table; their
+// meals/turn is not comparable with the rest.
+//
+// Compile: g++ -std=c++17 -O2 coloring_bench.cpp -o coloring_bench
+// Run:     ./coloring_bench [--sizes 5,6,7,...] [--turns t] [--hunger p] [--seed s]
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include "../common/ring_coloring.h"
+
+void usage(const char *prog) {
+    std::cerr << "usage: " << prog << " [--sizes n,n,...] [--turns t>=1] [--hunger 0<p<=1] [--seed s]\n";
+    std::exit(1);
+}
+
+void header() {
+    std::cout << "       n  strategy         meals/turn  peak eaters  checks/meal  longest wait\n";
+}
+
+void row(int n, const std::string &name, double meals_per_turn, long peak, const std::string &checks,
+         const std::string &wait) {
+    std::cout << std::setw(8) << n << "  " << std::left << std::setw(15) << name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(12) << meals_per_turn << std::setw(13) << peak
+              << std::setw(13) << checks << std::setw(14) << wait << "\n";
+}
+
+void run(int n, const std::string &name, arbiter::Arbitrated &t, int turns, double hunger, unsigned seed) {
+    t.set_hunger(hunger, seed);
+    for (int k = 0; k < turns; k++) t.step();
+    const arbiter::Load &l = t.load();
+    std::ostringstream checks;
+    checks << std::fixed << std::setprecision(2) << (t.meals() ? (double)l.checks / t.meals() : 0);
+    row(n, name, (double)t.meals() / turns, l.peak_eaters, checks.str(), std::to_string(t.longest_wait()));
+}
+
+// Turns between meal starts for philosopher 0 with the table to itself, hungry again
+// as soon as it is thinking.
+int lone_cycle(kernels::Strategy s) {
+    std::unique_ptr<kernels::Table> t = kernels::make_table(s, 3);
+    t->replay();
+    long first = -1;
+    for (int k = 0; k < 16; k++) {
+        if (t->state_of(0) == kernels::THINKING && !t->pending()) t->arrive(0, 1);
+        bool was_eating = t->state_of(0) == kernels::EATING;
+        t->step();
+        if (was_eating || t->state_of(0) != kernels::EATING) continue;
+        if (first >= 0) return (int)(k - first);
+        first = k;
+    }
+    return 0;
+}
+
+void run_kernel(int n, kernels::Strategy s, int turns) {
+    std::unique_ptr<kernels::Table> t = kernels::make_table(s, n);
+    long peak = 0;
+    for (int k = 0; k < turns; k++) {
+        t->step();
+        long eating = 0;
+        for (int i = 0; i < n; i++) eating += t->state_of(i) == kernels::EATING;
+        peak = std::max(peak, eating);
+    }
+    std::string name = kernels::strategy_name(s);
+    row(n, lone_cycle(s) != 2 ? name + "*" : name, (double)t->meals() / turns, peak, "-", "-");
+}
+
+int main(int argc, char **argv) {
+    std::vector<int> sizes = {5, 6, 7, 50, 51, 1000, 1001, 100000, 100001};
+    int turns = 1000;
+    double hunger = 1;
+    unsigned seed = 1;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (a + 1 >= argc) usage(argv[0]);
+        std::string val = argv[++a];
+        if (arg == "--sizes") {
+            sizes.clear();
+            std::stringstream ss(val);
+            std::string s;
+            while (std::getline(ss, s, ',')) sizes.push_back(std::atoi(s.c_str()));
+        } else if (arg == "--turns") turns = std::atoi(val.c_str());
+        else if (arg == "--hunger") hunger = std::atof(val.c_str());
+        else if (arg == "--seed") {
+            char *end;
+            seed = std::strtoul(val.c_str(), &end, 10);
+            if (val.empty() || *end) usage(argv[0]);
+        } else usage(argv[0]);
+    }
+    if (sizes.empty() || turns < 1 || !(hunger > 0 && hunger <= 1)) usage(argv[0]);
+    for (int n : sizes)
+        if (n < 2) usage(argv[0]);
+
+    std::cout << "Schedules: " << turns << " turns, one-turn meals, ";
+    if (hunger < 1) std::cout << "thinkers hungry with probability " << hunger << " per turn\n";
+    else std::cout << "saturated\n";
+    const kernels::Strategy hosted[] = {kernels::Strategy::MONITOR, kernels::Strategy::SEMAPHORE,
+                                        kernels::Strategy::HIERARCHY};
+    header();
+    for (int n : sizes) {
+        coloring::ScheduledTable colored(n, coloring::Schedule::COLORING);
+        run(n, "coloring (" + std::to_string(colored.colors()) + ")", colored, turns, hunger, seed);
+        coloring::ScheduledTable rotation(n, coloring::Schedule::ROTATION);
+        run(n, "rotation", rotation, turns, hunger, seed);
+        arbiter::FlatWaiter waiter(n);
+        run(n, "waiter", waiter, turns, hunger, seed);
+        arbiter::FlatWaiter bounded(n, 8);
+        run(n, "waiter-bounded", bounded, turns, hunger, seed);
+        if (hunger < 1) continue;
+        for (kernels::Strategy s : hosted) run_kernel(n, s, turns);
+    }
+    if (hunger < 1) return 0;
+    for (kernels::Strategy s : hosted)
+        if (lone_cycle(s) != 2)
+            std::cout << "* " << kernels::strategy_name(s) << ": a " << lone_cycle(s)
+                      << "-turn meal cycle against 2 for the schedules; meals/turn not comparable\n";
+    return 0;
+}
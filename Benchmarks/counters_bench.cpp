@@ -0,0 +1,195 @@
+// counters_bench.cpp
+// Why a strategy is slow, not just that it is: every philosopher thread counts its own
+// context switches, cache misses, cycles, instructions and futex syscalls with
+// perf_event_open (common/perf_counters.h) over a run of back-to-back meals, and the
+// totals are reported per meal for
+//   monitor     Monitor::pickup/putdown (Monitor.cpp)
+//   priority    PriorityMonitor with its FIFO waitQ (Monitor_priority.cpp)
+//   semaphore   room of n - 1, then left and right fork semaphores (Semaphore.cpp)
+//   mutex       ordered fork mutexes (Mutex.cpp)
+// Meals have no think or eat delay; with --yield a philosopher holds its forks for one
+// yield, so neighbours contend even on one CPU. Counters the kernel will not open are
+// shown as n/a, with the reason in the header; context switches then come from
+// getrusage (voluntary + involuntary) instead. Counts the kernel had to multiplex are
+// scaled up to the whole run and marked with *.
+//
+// Compile: g++ -std=c++17 -O2 counters_bench.cpp -pthread -o counters_bench
+// Run:     ./counters_bench [--philosophers n] [--meals m] [--yield]
+//                           [--bench monitor,priority,semaphore,mutex]
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
+#include "../common/primitives.h"
+#include "../common/perf_counters.h"
+
+using Clock = std::chrono::steady_clock;
+
+bool hold_yield = false;   // --yield
+
+void eat() {
+    if (hold_yield) std::this_thread::yield();
+}
+
+struct Run {
+    double seconds;
+    perf::Reading total;
+};
+
+// Runs meal(id) `meals` times on each of n threads, released together; every thread
+// counts only its own meals.
+Run run_meals(int n, int meals, const std::function<void(int)> &meal) {
+    std::vector<perf::Reading> readings(n);
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> th;
+    for (int id = 0; id < n; id++) {
+        th.emplace_back([&, id] {
+            perf::ThreadCounters counters;
+            ready++;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            counters.start();
+            for (int m = 0; m < meals; m++) meal(id);
+            readings[id] = counters.stop();
+        });
+    }
+    while (ready.load() < n) std::this_thread::yield();
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto &t : th) t.join();
+    Run r;
+    r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (auto &x : readings) r.total += x;
+    return r;
+}
+
+Run bench_monitor(int n, int meals) {
+    dp::Monitor mon(n);
+    return run_meals(n, meals, [&](int id) {
+        mon.pickup(id);
+        eat();
+        mon.putdown(id);
+    });
+}
+
+Run bench_priority(int n, int meals) {
+    dp::PriorityMonitor mon(n);
+    return run_meals(n, meals, [&](int id) {
+        mon.pickup(id);
+        eat();
+        mon.putdown(id);
+    });
+}
+
+Run bench_semaphore(int n, int meals) {
+    dp::Semaphore room(n - 1);
+    std::vector<std::unique_ptr<dp::Semaphore>> forks;
+    for (int i = 0; i < n; i++) forks.emplace_back(new dp::Semaphore(1));
+    return run_meals(n, meals, [&](int id) {
+        int right = (id + 1) % n;
+        room.wait();
+        forks[id]->wait();
+        forks[right]->wait();
+        eat();
+        forks[right]->signal();
+        forks[id]->signal();
+        room.signal();
+    });
+}
+
+Run bench_mutex(int n, int meals) {
+    dp::OrderedForks forks(n);
+    return run_meals(n, meals, [&](int id) {
+        forks.pickup(id);
+        eat();
+        forks.putdown(id);
+    });
+}
+
+struct Bench {
+    std::string name;
+    std::function<Run(int, int)> run;
+};
+
+void usage(const char *prog) {
+    std::cerr << "usage: " << prog << " [--philosophers n>=2] [--meals m>=1] [--yield]"
+              << " [--bench monitor,priority,semaphore,mutex]\n";
+    std::exit(1);
+}
+
+int main(int argc, char **argv) {
+    int n = 5, meals = 20000;
+    std::vector<Bench> all = {{"monitor", bench_monitor},
+                              {"priority", bench_priority},
+                              {"semaphore", bench_semaphore},
+                              {"mutex", bench_mutex}};
+    std::vector<Bench> chosen = all;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--yield") { hold_yield = true; continue; }
+        if (a + 1 >= argc) usage(argv[0]);
+        std::string val = argv[++a];
+        if (arg == "--philosophers") n = std::atoi(val.c_str());
+        else if (arg == "--meals") meals = std::atoi(val.c_str());
+        else if (arg == "--bench") {
+            chosen.clear();
+            std::stringstream ss(val);
+            std::string name;
+            while (std::getline(ss, name, ',')) {
+                bool found = false;
+                for (const Bench &b : all)
+                    if (b.name == name) {
+                        chosen.push_back(b);
+                        found = true;
+                    }
+                if (!found) usage(argv[0]);
+            }
+        } else usage(argv[0]);
+    }
+    if (n < 2 || meals < 1 || chosen.empty()) usage(argv[0]);
+
+    std::cout << "Counters per meal: " << n << " philosophers x " << meals << " meals"
+              << (hold_yield ? ", forks held for one yield" : "") << "\n";
+    {
+        perf::ThreadCounters probe;
+        for (int c = 0; c < perf::COUNTERS; c++)
+            if (!probe.have(perf::Counter(c)))
+                std::cout << "  " << perf::NAMES[c] << ": n/a (" << probe.unavailable(perf::Counter(c)) << ")\n";
+        if (!probe.have(perf::CONTEXT_SWITCHES))
+            std::cout << "  ctx-switches below are getrusage voluntary + involuntary\n";
+    }
+
+    std::cout << "strategy      meals/s  ctx-switches  voluntary  involuntary  cache-misses      cycles"
+                 "  instructions   futex\n";
+    bool any_scaled = false;
+    for (const Bench &b : chosen) {
+        Run r = b.run(n, meals);
+        const perf::Reading &t = r.total;
+        double m = (double)n * meals;
+        auto cell = [&](perf::Counter c, int width, int digits) {
+            std::ostringstream s;
+            if (t.have[c]) s << std::fixed << std::setprecision(digits) << t.value[c] / m << (t.scaled[c] ? "*" : "");
+            else s << "n/a";
+            any_scaled = any_scaled || (t.have[c] && t.scaled[c]);
+            return std::string(std::max(0, width - (int)s.str().size()), ' ') + s.str();
+        };
+        double switches = t.have[perf::CONTEXT_SWITCHES] ? t.value[perf::CONTEXT_SWITCHES]
+                                                          : t.voluntary + t.involuntary;
+        std::cout << std::left << std::setw(10) << b.name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(11) << m / r.seconds << std::setprecision(3) << std::setw(14) << switches / m
+                  << std::setw(11) << t.voluntary / m << std::setw(13) << t.involuntary / m
+                  << cell(perf::CACHE_MISSES, 14, 2) << cell(perf::CYCLES, 12, 0)
+                  << cell(perf::INSTRUCTIONS, 14, 0) << cell(perf::FUTEX, 8, 2) << "\n";
+    }
+    if (any_scaled) std::cout << "* multiplexed by the kernel, scaled from the time the counter ran\n";
+    return 0;
+}
@@ -0,0 +1,175 @@
+// lease_bench.cpp
+// Fork leases (common/lease.h) against acquiring every meal, for three strategies:
+//   semaphore   room of n - 1, then left and right fork semaphores (Semaphore.cpp)
+//   mutex       ordered fork mutexes (Mutex.cpp)
+//   monitor     Monitor::pickup/putdown (Monitor.cpp)
+// under two loads:
+//   sparse      only every third philosopher eats, so no two eaters share a fork
+//   busy        everyone eats and holds the forks for one yield, so neighbours contend
+//               even on one CPU
+// Meals are back to back, with no thinking. Reported: meals/s, full acquisitions per
+// meal, mean lease length in meals, the share of leases revoked, and the wait in
+// pickup() (p50, p99) over every meal. Every meal goes through the safety checker.
+//
+// Compile: g++ -std=c++17 -O2 lease_bench.cpp -pthread -o lease_bench
+// Run:     ./lease_bench [--philosophers n] [--meals m] [--max-lease k]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
+#include "../common/primitives.h"
+#include "../common/lease.h"
+#include "../common/safety.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Semaphore.cpp's protocol with a pickup/putdown interface.
+class SemaphoreForks {
+    int n;
+    dp::Semaphore room;
+    std::vector<std::unique_ptr<dp::Semaphore>> forks;
+
+public:
+    explicit SemaphoreForks(int n) : n(n), room(n - 1) {
+        for (int i = 0; i < n; i++) forks.emplace_back(new dp::Semaphore(1));
+    }
+    void pickup(int id) {
+        room.wait();
+        forks[id]->wait();
+        forks[(id + 1) % n]->wait();
+    }
+    void putdown(int id) {
+        forks[(id + 1) % n]->signal();
+        forks[id]->signal();
+        room.signal();
+    }
+};
+
+// Acquires every meal; the same interface as lease::Leased.
+template <class Forks>
+struct Direct {
+    Forks &inner;
+    void pickup(int id) { inner.pickup(id); }
+    void putdown(int id) { inner.putdown(id); }
+    void leave(int) {}
+};
+
+struct Result {
+    double seconds;
+    long meals = 0;
+    long acquisitions = 0, leases = 0, revoked = 0;
+    std::vector<double> waits;   // ns
+};
+
+// Each active philosopher eats `meals` meals through t on its own thread.
+template <class Table>
+Result run(Table &t, int n, int meals, bool busy, const char *name) {
+    safety::Checker safe(name, n);
+    std::vector<std::vector<double>> waits(n);
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> th;
+    int active = 0;
+    for (int id = 0; id < n; id++) {
+        if (!busy && (id % 3 != 0 || (id == n - 1 && n % 3 == 1))) continue;   // sparse: no shared forks
+        active++;
+        th.emplace_back([&, id] {
+            waits[id].reserve(meals);
+            ready++;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (int m = 0; m < meals; m++) {
+                auto asked = Clock::now();
+                t.pickup(id);
+                waits[id].push_back(std::chrono::duration<double, std::nano>(Clock::now() - asked).count());
+                safe.eat(id);
+                if (busy) std::this_thread::yield();
+                safe.done(id);
+                t.putdown(id);
+            }
+            t.leave(id);
+        });
+    }
+    while (ready.load() < active) std::this_thread::yield();
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto &x : th) x.join();
+    Result r;
+    r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    r.meals = (long)active * meals;
+    for (auto &w : waits) r.waits.insert(r.waits.end(), w.begin(), w.end());
+    std::sort(r.waits.begin(), r.waits.end());
+    return r;
+}
+
+template <class Forks>
+void compare(const char *strategy, int n, int meals, int max_lease, bool busy,
+             const std::function<std::unique_ptr<Forks>()> &make) {
+    auto print = [&](const char *mode, const Result &r) {
+        auto pct = [&](double p) { return r.waits[std::min(r.waits.size() - 1, (size_t)(p * r.waits.size()))] / 1000; };
+        std::cout << std::left << std::setw(11) << strategy << std::setw(8) << (busy ? "busy" : "sparse")
+                  << std::setw(8) << mode << std::right << std::fixed << std::setprecision(0) << std::setw(11)
+                  << r.meals / r.seconds << std::setprecision(3) << std::setw(12)
+                  << (double)r.acquisitions / r.meals << std::setprecision(1) << std::setw(10)
+                  << (r.leases ? (double)r.meals / r.leases : 1.0) << std::setw(10)
+                  << (r.leases ? 100.0 * r.revoked / r.leases : 0.0) << std::setprecision(2) << std::setw(10)
+                  << pct(0.50) << std::setw(10) << pct(0.99) << "\n";
+    };
+    {
+        std::unique_ptr<Forks> f = make();
+        Direct<Forks> d{*f};
+        Result r = run(d, n, meals, busy, strategy);
+        r.acquisitions = r.leases = r.meals;
+        print("direct", r);
+    }
+    {
+        std::unique_ptr<Forks> f = make();
+        lease::Leased<Forks> l(*f, n, max_lease);
+        Result r = run(l, n, meals, busy, strategy);
+        for (int i = 0; i < n; i++) {
+            r.acquisitions += l.seat(i).acquisitions;
+            r.revoked += l.seat(i).revoked;
+        }
+        r.leases = r.acquisitions;
+        print("lease", r);
+    }
+}
+
+void usage(const char *prog) {
+    std::cerr << "usage: " << prog << " [--philosophers n>=2] [--meals m>=1] [--max-lease k>=1]\n";
+    std::exit(1);
+}
+
+int main(int argc, char **argv) {
+    int n = 5, meals = 20000, max_lease = 64;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (a + 1 >= argc) usage(argv[0]);
+        int v = std::atoi(argv[++a]);
+        if (arg == "--philosophers") n = v;
+        else if (arg == "--meals") meals = v;
+        else if (arg == "--max-lease") max_lease = v;
+        else usage(argv[0]);
+    }
+    if (n < 2 || meals < 1 || max_lease < 1) usage(argv[0]);
+
+    std::cout << "Leases: " << n << " philosophers x " << meals << " meals, leases up to " << max_lease
+              << " meals\n"
+              << "strategy   load    mode        meals/s  acq/meal  lease len  revoked %  wait p50  wait p99 (us)\n";
+    for (bool busy : {false, true}) {
+        compare<SemaphoreForks>("semaphore", n, meals, max_lease, busy,
+                                [&] { return std::make_unique<SemaphoreForks>(n); });
+        compare<dp::OrderedForks>("mutex", n, meals, max_lease, busy,
+                                  [&] { return std::make_unique<dp::OrderedForks>(n); });
+        compare<dp::Monitor>("monitor", n, meals, max_lease, busy,
+                             [&] { return std::make_unique<dp::Monitor>(n); });
+    }
+    return 0;
+}
@@ -0,0 +1,341 @@
+// microbench.cpp
+// Cost of the synchronization primitives every dining-philosophers variant is built on:
+//   sem_uncontended   Semaphore::wait/signal on a private semaphore (Semaphore.cpp)
+//   sem_pingpong      two threads bouncing a token through two Semaphores
+//   fork_mutex        std::mutex fork lock/unlock with the Mutex.cpp ordering
+//   monitor           Monitor::pickup/putdown round trip (Monitor.cpp)
+//   cv_wake           condition_variable notify -> wake latency
+// Each is run at 1, 2, 4, ... threads up to all allowed CPUs, one pinned thread per CPU.
+// Every point gets warmup runs, then repeated trials; trials further than 3 scaled MADs
+// from the median are rejected and the rest are summarised.
+//
+// Compile: g++ -std=c++17 -O2 microbench.cpp -pthread -o microbench
+// Run:     ./microbench [--bench a,b] [--max-threads T] [--trials R] [--warmup W] [--scale S]
+//                       [--save baseline.csv] [--compare baseline.csv] [--threshold pct]
+// --compare exits with status 2 if any point regressed by more than the threshold
+// (default 10%) and by more than the noise of both runs.
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include <cmath>
+#include <cstdlib>
+#include <sched.h>
+#include "../common/primitives.h"
+
+using Clock = std::chrono::steady_clock;
+
+// CPUs this process may run on, in order; thread t is pinned to cpus[t % size].
+std::vector<int> allowed_cpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<int> cpus;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        for (int c = 0; c < CPU_SETSIZE; c++)
+            if (CPU_ISSET(c, &set)) cpus.push_back(c);
+    if (cpus.empty()) cpus.push_back(0);
+    return cpus;
+}
+
+const std::vector<int> &cpus() {
+    static std::vector<int> list = allowed_cpus();
+    return list;
+}
+
+void pin_self(int t) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus()[t % cpus().size()], &set);
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+// Runs body(t) on `threads` pinned threads released together, returns wall-clock ns.
+double run_threads(int threads, const std::function<void(int)> &body) {
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> th;
+    for (int t = 0; t < threads; t++) {
+        th.emplace_back([&, t] {
+            pin_self(t);
+            ready++;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            body(t);
+        });
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto &x : th) x.join();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// A benchmark returns nanoseconds per operation for one trial.
+struct Bench {
+    std::string name;
+    int min_threads;     // pairwise benchmarks need 2
+    long ops;            // operations per thread (or per pair) at scale 1
+    std::function<double(int threads, long ops)> trial;
+};
+
+double sem_uncontended(int threads, long ops) {
+    std::vector<std::unique_ptr<dp::Semaphore>> sems;
+    for (int t = 0; t < threads; t++) sems.emplace_back(new dp::Semaphore(1));
+    double ns = run_threads(threads, [&](int t) {
+        for (long i = 0; i < ops; i++) {
+            sems[t]->wait();
+            sems[t]->signal();
+        }
+    });
+    return ns / ops;
+}
+
+// threads/2 independent pairs; one op is a full round trip of the token.
+double sem_pingpong(int threads, long ops) {
+    int pairs = threads / 2;
+    std::vector<std::unique_ptr<dp::Semaphore>> ping, pong;
+    for (int p = 0; p < pairs; p++) {
+        ping.emplace_back(new dp::Semaphore(0));
+        pong.emplace_back(new dp::Semaphore(0));
+    }
+    double ns = run_threads(pairs * 2, [&](int t) {
+        int p = t / 2;
+        for (long i = 0; i < ops; i++) {
+            if (t % 2 == 0) { ping[p]->signal(); pong[p]->wait(); }
+            else            { ping[p]->wait();   pong[p]->signal(); }
+        }
+    });
+    return ns / ops;
+}
+
+// Ring of max(threads, 2) forks; thread t is philosopher t.
+double fork_mutex(int threads, long ops) {
+    dp::OrderedForks forks(std::max(threads, 2));
+    double ns = run_threads(threads, [&](int t) {
+        for (long i = 0; i < ops; i++) {
+            forks.pickup(t);
+            forks.putdown(t);
+        }
+    });
+    return ns / ops;
+}
+
+double monitor(int threads, long ops) {
+    dp::Monitor mon(std::max(threads, 2));
+    double ns = run_threads(threads, [&](int t) {
+        for (long i = 0; i < ops; i++) {
+            mon.pickup(t);
+            mon.putdown(t);
+        }
+    });
+    return ns / ops;
+}
+
+// threads/2 pairs. The notifier stamps the time and notifies; the waiter measures
+// how long it took to return from wait(), then hands the turn back.
+double cv_wake(int threads, long ops) {
+    struct Pair {
+        std::mutex m;
+        std::condition_variable cv;
+        int turn = 0;                // 0: notifier's turn, 1: waiter's turn
+        Clock::time_point sent;
+        double total_ns = 0;
+    };
+    int pairs = threads / 2;
+    std::vector<std::unique_ptr<Pair>> ps;
+    for (int p = 0; p < pairs; p++) ps.emplace_back(new Pair);
+    run_threads(pairs * 2, [&](int t) {
+        Pair &p = *ps[t / 2];
+        for (long i = 0; i < ops; i++) {
+            std::unique_lock<std::mutex> lk(p.m);
+            if (t % 2 == 0) {
+                p.cv.wait(lk, [&] { return p.turn == 0; });
+                p.turn = 1;
+                p.sent = Clock::now();
+                p.cv.notify_all();
+            } else {
+                p.cv.wait(lk, [&] { return p.turn == 1; });
+                p.total_ns += std::chrono::duration<double, std::nano>(Clock::now() - p.sent).count();
+                p.turn = 0;
+                p.cv.notify_all();
+            }
+        }
+    });
+    double total = 0;
+    for (auto &p : ps) total += p->total_ns;
+    return total / ((double)ops * pairs);
+}
+
+struct Summary {
+    double median, mean, stddev, min, max, mad;
+    int kept, total;
+};
+
+double median_of(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    size_t k = v.size();
+    return k % 2 ? v[k / 2] : (v[k / 2 - 1] + v[k / 2]) / 2;
+}
+
+// Rejects trials more than 3 scaled median absolute deviations from the median.
+// Anything within 1% of the median is kept, so very quiet points are not thinned out.
+Summary summarise(const std::vector<double> &trials) {
+    double med = median_of(trials);
+    std::vector<double> dev;
+    for (double x : trials) dev.push_back(std::fabs(x - med));
+    double mad = 1.4826 * median_of(dev);
+    std::vector<double> kept;
+    for (double x : trials)
+        if (std::fabs(x - med) <= std::max(3 * mad, 0.01 * med)) kept.push_back(x);
+
+    Summary s;
+    s.kept = (int)kept.size();
+    s.total = (int)trials.size();
+    s.median = median_of(kept);
+    s.mean = std::accumulate(kept.begin(), kept.end(), 0.0) / kept.size();
+    double var = 0;
+    for (double x : kept) var += (x - s.mean) * (x - s.mean);
+    s.stddev = kept.size() > 1 ? std::sqrt(var / (kept.size() - 1)) : 0;
+    s.min = *std::min_element(kept.begin(), kept.end());
+    s.max = *std::max_element(kept.begin(), kept.end());
+    s.mad = mad;
+    return s;
+}
+
+struct Baseline {
+    double median, mad;
+};
+
+std::map<std::string, Baseline> load_baseline(const std::string &path) {
+    std::map<std::string, Baseline> out;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream ss(line);
+        std::string bench, threads, median, mad;
+        std::getline(ss, bench, ',');
+        std::getline(ss, threads, ',');
+        std::getline(ss, median, ',');
+        std::getline(ss, mad, ',');
+        out[bench + "/" + threads] = {std::atof(median.c_str()), std::atof(mad.c_str())};
+    }
+    return out;
+}
+
+std::vector<std::string> split(const std::string &s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+int main(int argc, char **argv) {
+    std::vector<Bench> benches = {
+        {"sem_uncontended", 1, 1000000, sem_uncontended},
+        {"sem_pingpong",    2, 20000,   sem_pingpong},
+        {"fork_mutex",      1, 200000,  fork_mutex},
+        {"monitor",         1, 200000,  monitor},
+        {"cv_wake",         2, 20000,   cv_wake},
+    };
+
+    std::vector<std::string> only;
+    int max_threads = (int)cpus().size();
+    int trials = 11, warmup = 2;
+    double scale = 1.0, threshold = 10.0;
+    std::string save_path, compare_path;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        auto next = [&]() -> std::string {
+            if (a + 1 >= argc) { std::cerr << arg << " needs a value\n"; std::exit(1); }
+            return argv[++a];
+        };
+        if (arg == "--bench") only = split(next());
+        else if (arg == "--max-threads") max_threads = std::atoi(next().c_str());
+        else if (arg == "--trials") trials = std::atoi(next().c_str());
+        else if (arg == "--warmup") warmup = std::atoi(next().c_str());
+        else if (arg == "--scale") scale = std::atof(next().c_str());
+        else if (arg == "--save") save_path = next();
+        else if (arg == "--compare") compare_path = next();
+        else if (arg == "--threshold") threshold = std::atof(next().c_str());
+        else {
+            std::cerr << "unknown option " << arg << "\n";
+            return 1;
+        }
+    }
+    if (max_threads < 1 || trials < 1 || warmup < 0 || scale <= 0) {
+        std::cerr << "invalid options\n";
+        return 1;
+    }
+
+    std::vector<int> thread_counts;
+    for (int t = 1; t < max_threads; t *= 2) thread_counts.push_back(t);
+    thread_counts.push_back(max_threads);
+
+    std::map<std::string, Baseline> baseline;
+    if (!compare_path.empty()) baseline = load_baseline(compare_path);
+    std::ofstream save;
+    if (!save_path.empty()) {
+        save.open(save_path);
+        save << "# bench,threads,median_ns,mad_ns\n";
+    }
+
+    std::cout << "CPUs available: " << cpus().size() << ", trials " << trials
+              << " (+" << warmup << " warmup)\n\n";
+    std::cout << std::left << std::setw(16) << "bench" << std::right
+              << std::setw(8) << "threads" << std::setw(12) << "median ns"
+              << std::setw(12) << "mean ns" << std::setw(10) << "stddev"
+              << std::setw(10) << "min" << std::setw(10) << "max"
+              << std::setw(8) << "kept" << (baseline.empty() ? "" : "   vs baseline") << "\n";
+
+    int regressions = 0;
+    for (const Bench &b : benches) {
+        if (!only.empty() && std::find(only.begin(), only.end(), b.name) == only.end()) continue;
+        long ops = std::max(1L, (long)(b.ops * scale));
+        for (int threads : thread_counts) {
+            if (threads < b.min_threads) continue;
+            for (int w = 0; w < warmup; w++) b.trial(threads, ops);
+            std::vector<double> results;
+            for (int r = 0; r < trials; r++) results.push_back(b.trial(threads, ops));
+            Summary s = summarise(results);
+
+            std::cout << std::left << std::setw(16) << b.name << std::right << std::fixed
+                      << std::setprecision(1) << std::setw(8) << threads
+                      << std::setw(12) << s.median << std::setw(12) << s.mean
+                      << std::setw(10) << s.stddev << std::setw(10) << s.min
+                      << std::setw(10) << s.max << std::setw(5) << s.kept << "/" << std::left
+                      << std::setw(2) << s.total << std::right;
+
+            std::string key = b.name + "/" + std::to_string(threads);
+            auto it = baseline.find(key);
+            if (it != baseline.end() && it->second.median > 0) {
+                double delta = 100.0 * (s.median - it->second.median) / it->second.median;
+                double noise = 3 * std::max(s.mad, it->second.mad);
+                bool regressed = delta > threshold && s.median - it->second.median > noise;
+                std::cout << "   " << std::showpos << delta << "%" << std::noshowpos
+                          << (regressed ? "  REGRESSION" : "");
+                if (regressed) regressions++;
+            }
+            std::cout << "\n";
+            if (save.is_open())
+                save << b.name << "," << threads << "," << s.median << "," << s.mad << "\n";
+        }
+    }
+
+    if (!compare_path.empty()) {
+        std::cout << "\n" << regressions << " regression(s) against " << compare_path << "\n";
+        if (regressions) return 2;
+    }
+    return 0;
+}
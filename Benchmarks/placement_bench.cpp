@@ -0,0 +1,171 @@
+// placement_bench.cpp
+// Compares the thread placement policies from common/placement.h on a ring of
+// philosophers, one pinned thread each:
+//   handoff   a baton (standing in for a fork) is passed from philosopher i to i+1
+//             around the ring; reports the per-hop latency distribution
+//   monitor   meals/sec with Monitor::pickup/putdown and no think/eat delay
+//   mutex     meals/sec with the Mutex.cpp ordered fork mutexes
+// for each ring size. By default the sizes are 5, the CPU count and twice it plus
+// one: the policies place small rings on one cache domain or across the machine, and
+// rings larger than the machine either in segments (ring) or wrapped (compact).
+//
+// Compile: g++ -std=c++17 -O2 placement_bench.cpp -pthread -o placement_bench
+// Run:     ./placement_bench [--philosophers n,n,...] [--ms duration] [--policies none,compact,scatter,ring]
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include "../common/primitives.h"
+#include "../common/placement.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct alignas(64) Baton {
+    std::atomic<long> hop{-1};                  // hop number this philosopher may take
+    std::atomic<Clock::rep> sent{0};            // when the previous philosopher passed it
+};
+
+// Passes the baton around the ring until `ms` elapse; returns sorted hop latencies (ns).
+std::vector<double> handoff(const std::vector<int> &cpus, int ms) {
+    int n = (int)cpus.size();
+    std::vector<Baton> batons(n);
+    std::atomic<bool> stop{false};
+    std::vector<std::vector<double>> lat(n);
+
+    std::vector<std::thread> th;
+    for (int i = 0; i < n; i++) {
+        th.emplace_back([&, i] {
+            placement::pin_self(cpus[i]);
+            long expect = i;
+            for (;;) {
+                int spins = 0;
+                while (batons[i].hop.load(std::memory_order_acquire) != expect) {
+                    if (stop.load(std::memory_order_relaxed)) return;
+                    if (++spins > 64) std::this_thread::yield();
+                }
+                auto now = Clock::now().time_since_epoch().count();
+                if (expect > 0)
+                    lat[i].push_back((double)(now - batons[i].sent.load(std::memory_order_relaxed)));
+                int next = (i + 1) % n;
+                batons[next].sent.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+                batons[next].hop.store(expect + 1, std::memory_order_release);
+                expect += n;
+            }
+        });
+    }
+    batons[0].hop.store(0, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    stop = true;
+    for (auto &t : th) t.join();
+
+    std::vector<double> all;
+    for (auto &v : lat) all.insert(all.end(), v.begin(), v.end());
+    std::sort(all.begin(), all.end());
+    return all;
+}
+
+// Every philosopher loops pickup/putdown until `ms` elapse; returns meals/sec.
+template <class Forks>
+double meals_per_sec(const std::vector<int> &cpus, int ms) {
+    int n = (int)cpus.size();
+    Forks forks(n);
+    std::atomic<bool> stop{false};
+    std::vector<long> meals(n, 0);
+    std::vector<std::thread> th;
+    for (int i = 0; i < n; i++) {
+        th.emplace_back([&, i] {
+            placement::pin_self(cpus[i]);
+            long count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                forks.pickup(i);
+                forks.putdown(i);
+                count++;
+            }
+            meals[i] = count;
+        });
+    }
+    auto start = Clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    stop = true;
+    for (auto &t : th) t.join();
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+    long total = 0;
+    for (long m : meals) total += m;
+    return total / secs;
+}
+
+double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+}
+
+int main(int argc, char **argv) {
+    int cpus = (int)placement::topology().size();
+    std::vector<int> sizes = {5, std::max(2, cpus), 2 * cpus + 1};
+    int ms = 500;
+    std::vector<placement::Policy> policies = {placement::Policy::NONE, placement::Policy::COMPACT,
+                                               placement::Policy::SCATTER, placement::Policy::RING};
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (a + 1 >= argc) {
+            std::cerr << arg << " needs a value\n";
+            return 1;
+        }
+        std::string val = argv[++a];
+        if (arg == "--philosophers") {
+            sizes.clear();
+            std::stringstream ss(val);
+            std::string item;
+            while (std::getline(ss, item, ',')) sizes.push_back(std::atoi(item.c_str()));
+        } else if (arg == "--ms") ms = std::atoi(val.c_str());
+        else if (arg == "--policies") {
+            policies.clear();
+            std::stringstream ss(val);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                placement::Policy p;
+                if (!placement::parse_policy(item, p)) {
+                    std::cerr << "unknown policy " << item << "\n";
+                    return 1;
+                }
+                policies.push_back(p);
+            }
+        } else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--philosophers n,n,...] [--ms duration] [--policies none,compact,scatter,ring]\n";
+            return 1;
+        }
+    }
+    std::sort(sizes.begin(), sizes.end());
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+    if (sizes.empty() || sizes.front() < 2 || ms <= 0) {
+        std::cerr << "need at least 2 philosophers and a positive duration\n";
+        return 1;
+    }
+
+    for (int n : sizes) {
+        std::cout << n << " philosophers on " << cpus << " CPUs, " << ms << " ms per measurement\n";
+        for (placement::Policy p : policies) {
+            std::vector<int> placed = placement::plan(p, n);
+            placement::describe(std::cout, p, placed);
+            std::vector<double> hops = handoff(placed, ms);
+            double mean = 0;
+            for (double h : hops) mean += h;
+            mean = hops.empty() ? 0 : mean / hops.size();
+            std::cout << std::fixed << std::setprecision(0)
+                      << "  handoff: " << hops.size() << " hops, mean " << mean
+                      << " ns, p50 " << percentile(hops, 0.50)
+                      << " ns, p99 " << percentile(hops, 0.99) << " ns\n";
+            std::cout << "  monitor: " << meals_per_sec<dp::Monitor>(placed, ms) << " meals/sec\n";
+            std::cout << "  mutex:   " << meals_per_sec<dp::OrderedForks>(placed, ms) << " meals/sec\n";
+        }
+    }
+    return 0;
+}
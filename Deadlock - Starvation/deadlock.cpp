@@ -1,10 +1,38 @@
 // This program simulates a deadlock scenario for the Dining Philosophers Problem
 // in a single-threaded environment. It demonstrates how the state of the system
 // becomes locked in a circular wait, preventing any further progress.
+//
+// With --recover <policy> the simulation does not stop at the deadlock. The wait-for
+// chain is checked after every fork acquisition, so the cycle is found the moment it
+// closes, and a victim is chosen to break it:
+//   preempt          the victim's fork is taken away and handed to the philosopher
+//                    waiting for it, who starts eating; the victim stays hungry
+//   rollback-random  a random philosopher on the cycle puts its fork down and goes
+//                    back to thinking, losing its wait
+//   rollback-lowest  as rollback-random, but the victim is the one with the fewest
+//                    meals (ties: least time invested, then lowest id)
+// How long philosophers think after eating decides how often the table deadlocks again:
+//   --wave w      (the default, w = 2n) everyone thinks until the next multiple of w,
+//                 so hunger comes in synchronous waves; every wave grabs all the left
+//                 forks in one turn and deadlocks, so each policy recovers once a wave
+//   --staggered   think until the next multiple of i + 2, the schedule of the
+//                 simulators in Other 4/, so meals/turn can be set against theirs;
+//                 it rarely lines everyone up again (one or two deadlocks per 10,000
+//                 turns), too few to compare the policies
+//   --think t     think a random 0..t turns (from --seed); also deadlocks only rarely
+//
+// Compile: g++ -std=c++17 -O2 deadlock.cpp -o deadlock
+// Run:     ./deadlock [--recover none|preempt|rollback-random|rollback-lowest]
+//                     [--philosophers n] [--turns t] [--wave w | --staggered | --think t]
+//                     [--seed s] [--quiet]
 
 #include <iostream>
 #include <vector>
 #include <string>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include "../common/safety.h"
 
 const int NUM_PHILOSOPHERS = 5;
 
@@ -21,38 +49,180 @@ enum class ForkState {
     HELD
 };
 
+enum class Recovery {
+    NONE,
+    PREEMPT,
+    ROLLBACK_RANDOM,
+    ROLLBACK_LOWEST
+};
+
+struct Options {
+    Recovery recovery = Recovery::NONE;
+    int philosophers = NUM_PHILOSOPHERS;
+    long max_turns = 100;
+    long think = -1;              // longest random think time, or -1
+    long wave = 0;                // hunger wave period (0: 2n, unless another schedule is set)
+    bool staggered = false;       // the i + 2 schedule
+    unsigned seed = 1;
+    bool quiet = false;
+};
+
 // Represents a philosopher in the simulation
 struct Philosopher {
     int id;
     PhilosopherState state;
+    long hungry_since = 0;    // turn at which the current attempt to eat started
+    long thinks_until = 0;    // recovery mode: first turn it gets hungry again
+    long eating_since = 0;    // turn of the current meal's first bite
+    long meals = 0;
+};
+
+// First turn after `turn` at which a thinking philosopher i becomes hungry again.
+long next_hungry_turn(int i, long turn) {
+    long period = i + 2;
+    return (turn / period + 1) * period;
+}
+
+long think_until(const Options &opt, std::mt19937 &rng, int i, long turn) {
+    if (opt.think >= 0) return turn + 1 + std::uniform_int_distribution<long>(0, opt.think)(rng);
+    if (opt.staggered) return next_hungry_turn(i, turn);
+    return (turn / opt.wave + 1) * opt.wave;
+}
+
+// Follows the wait-for chain from philosopher i, who has just picked up a fork.
+// Philosopher j waits for j + 1 while it holds its left fork and its right fork is
+// taken, and any new cycle must pass through i, so the walk stops at the first
+// philosopher that is not blocked. Returns the cycle, or nothing.
+std::vector<int> closed_cycle(const std::vector<Philosopher> &philosophers,
+                              const std::vector<ForkState> &forks, int i) {
+    const int n = (int)philosophers.size();
+    std::vector<int> cycle;
+    int j = i;
+    do {
+        if (philosophers[j].state != PhilosopherState::HOLDING_LEFT_FORK ||
+            forks[(j + 1) % n] != ForkState::HELD)
+            return {};
+        cycle.push_back(j);
+        j = (j + 1) % n;
+    } while (j != i);
+    return cycle;
+}
+
+// Running totals for --recover.
+struct RecoveryStats {
+    long deadlocks = 0;
+    long lost_turns = 0;          // waiting discarded by the victims
+    long latency_turns = 0;       // detection to the end of the first meal after it, summed
+    double handling_ns = 0;       // cycle check + recovery at the closing acquisition
+    long recovered_at = -1;       // turn of the last recovery, -1 while nobody has eaten since
+    long meals_at_recovery = 0;
+    long window_turns = 0;        // turns and meals between a recovery and the next deadlock
+    long window_meals = 0;
 };
 
 // Main simulation function
-void run_simulation() {
+void run_simulation(const Options &opt) {
+    const int n = opt.philosophers;
+    const bool recover = opt.recovery != Recovery::NONE;
+
     // Initialize philosophers and their states
-    std::vector<Philosopher> philosophers(NUM_PHILOSOPHERS);
-    for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
+    std::vector<Philosopher> philosophers(n);
+    for (int i = 0; i < n; ++i) {
         philosophers[i] = {i, PhilosopherState::HUNGRY}; // All start hungry to induce deadlock
     }
 
     // Initialize forks and their states
-    std::vector<ForkState> forks(NUM_PHILOSOPHERS, ForkState::FREE);
+    std::vector<ForkState> forks(n, ForkState::FREE);
 
-    int turn = 0;
+    std::mt19937 rng(opt.seed);
+    RecoveryStats rs;
+    long meals = 0;
+    long turn = 0;
     bool system_deadlocked = false;
+    bool awaiting_meal = false;   // a recovery happened and no meal has finished since
+    int first_eater = -1;         // the first philosopher to start eating after it
+    long detected_at = 0;
+
+    auto eat = [&](int i) {
+        safety::checker().eat(i, turn);
+        philosophers[i].state = PhilosopherState::EATING;
+        philosophers[i].eating_since = turn;
+        philosophers[i].meals++;
+        meals++;
+        if (awaiting_meal && first_eater < 0) first_eater = i;
+    };
+
+    // Breaks the cycle closed by philosopher i's last acquisition.
+    auto break_cycle = [&](const std::vector<int> &cycle, int i, std::chrono::steady_clock::time_point start) {
+        if (rs.recovered_at >= 0) {
+            rs.window_turns += turn - rs.recovered_at;
+            rs.window_meals += meals - rs.meals_at_recovery;
+        }
+        rs.deadlocks++;
+
+        int victim = cycle[0];
+        if (opt.recovery == Recovery::ROLLBACK_RANDOM) {
+            victim = cycle[std::uniform_int_distribution<int>(0, (int)cycle.size() - 1)(rng)];
+        } else if (opt.recovery == Recovery::ROLLBACK_LOWEST) {
+            for (int j : cycle) {
+                const Philosopher &a = philosophers[j], &b = philosophers[victim];
+                if (a.meals != b.meals ? a.meals < b.meals
+                    : a.hungry_since != b.hungry_since ? a.hungry_since > b.hungry_since
+                    : j < victim)
+                    victim = j;
+            }
+        } else {
+            // Preempt whoever closed the cycle: its wait is the shortest on it.
+            victim = i;
+        }
+
+        Philosopher &v = philosophers[victim];
+        int waiter = (victim + n - 1) % n;
+        rs.lost_turns += turn - v.hungry_since;
+        detected_at = turn;
+        awaiting_meal = true;
+        first_eater = -1;
+        if (opt.recovery == Recovery::PREEMPT) {
+            // The fork goes straight to its waiter, who now has both. The meal counts
+            // from this turn, so the waiter puts the forks down next turn at the earliest.
+            v.state = PhilosopherState::HUNGRY;
+            v.hungry_since = turn;
+            eat(waiter);
+        } else {
+            forks[victim] = ForkState::FREE;
+            v.state = PhilosopherState::THINKING;
+            v.thinks_until = think_until(opt, rng, victim, turn);
+        }
+        rs.handling_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        rs.recovered_at = turn;
+        rs.meals_at_recovery = meals;
+
+        if (opt.quiet) return;
+        std::cout << "Deadlock: philosopher " << i << " closed a cycle of " << cycle.size() << "." << std::endl;
+        if (opt.recovery == Recovery::PREEMPT)
+            std::cout << "Recovery: fork " << victim << " preempted from philosopher " << victim
+                  << "; philosopher " << waiter << " picked it up and is now eating." << std::endl;
+        else
+            std::cout << "Recovery: philosopher " << victim << " rolled back, put down fork " << victim
+                  << " and is thinking." << std::endl;
+    };
 
     // Simulation loop
     while (!system_deadlocked) {
-        std::cout << "\n--- Turn " << turn << " ---" << std::endl;
+        if (!opt.quiet)
+            std::cout << "\n--- Turn " << turn << " ---" << std::endl;
         system_deadlocked = true; // Assume deadlock unless a state change occurs
 
-        for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
+        for (int i = 0; i < n; ++i) {
             int left_fork = i;
-            int right_fork = (i + 1) % NUM_PHILOSOPHERS;
+            int right_fork = (i + 1) % n;
 
             switch (philosophers[i].state) {
                 case PhilosopherState::THINKING:
+                    if (recover && turn < philosophers[i].thinks_until) break;
                     philosophers[i].state = PhilosopherState::HUNGRY;
+                    philosophers[i].hungry_since = turn;
                     system_deadlocked = false;
                     break;
 
@@ -61,8 +231,14 @@ void run_simulation() {
                     if (forks[left_fork] == ForkState::FREE) {
                         forks[left_fork] = ForkState::HELD;
                         philosophers[i].state = PhilosopherState::HOLDING_LEFT_FORK;
-                        std::cout << "Philosopher " << i << " picked up fork " << left_fork << "." << std::endl;
+                        if (!opt.quiet)
+                            std::cout << "Philosopher " << i << " picked up fork " << left_fork << "." << std::endl;
                         system_deadlocked = false;
+                        if (recover) {
+                            auto start = std::chrono::steady_clock::now();
+                            std::vector<int> cycle = closed_cycle(philosophers, forks, i);
+                            if (!cycle.empty()) break_cycle(cycle, i, start);
+                        }
                     }
                     break;
 
@@ -70,34 +246,118 @@ void run_simulation() {
                     // This is the deadlock condition. Check if the right fork is free.
                     if (forks[right_fork] == ForkState::FREE) {
                         forks[right_fork] = ForkState::HELD;
-                        philosophers[i].state = PhilosopherState::EATING;
-                        std::cout << "Philosopher " << i << " picked up fork " << right_fork << " and is now eating." << std::endl;
+                        eat(i);
+                        if (!opt.quiet)
+                            std::cout << "Philosopher " << i << " picked up fork " << right_fork << " and is now eating." << std::endl;
                         system_deadlocked = false;
                     } else {
-                        std::cout << "Philosopher " << i << " is holding fork " << left_fork << " and waiting for fork " << right_fork << "." << std::endl;
+                        if (!opt.quiet)
+                            std::cout << "Philosopher " << i << " is holding fork " << left_fork << " and waiting for fork " << right_fork << "." << std::endl;
                     }
                     break;
 
                 case PhilosopherState::EATING:
-                    std::cout << "Philosopher " << i << " finished eating." << std::endl;
+                    // A waiter granted a preempted fork later in the scan started this turn.
+                    if (philosophers[i].eating_since == turn) break;
+                    if (i == first_eater) {
+                        rs.latency_turns += turn - detected_at;
+                        awaiting_meal = false;
+                        first_eater = -1;
+                    }
+                    if (!opt.quiet)
+                        std::cout << "Philosopher " << i << " finished eating." << std::endl;
+                    safety::checker().done(i, turn);
                     forks[left_fork] = ForkState::FREE;
                     forks[right_fork] = ForkState::FREE;
                     philosophers[i].state = PhilosopherState::THINKING;
+                    philosophers[i].thinks_until = think_until(opt, rng, i, turn);
                     system_deadlocked = false;
                     break;
             }
         }
 
         turn++;
+
+        if (recover) {
+            // Thinking philosophers make no state change, so only the turn limit ends the run.
+            system_deadlocked = false;
+            if (turn > opt.max_turns) {
+                std::cout << "\n--- Simulation ended after " << opt.max_turns << " turns. ---" << std::endl;
+                break;
+            }
+        }
+    }
+
+    if (recover) {
+        if (rs.recovered_at >= 0) {
+            rs.window_turns += turn - rs.recovered_at;
+            rs.window_meals += meals - rs.meals_at_recovery;
+        }
+        long recovered = rs.deadlocks - (awaiting_meal ? 1 : 0);
+        std::cout << "Turns: " << turn << ", meals: " << meals
+                  << ", meals/turn: " << (double)meals / turn << "\n"
+                  << "Deadlocks: " << rs.deadlocks
+                  << ", lost work: " << rs.lost_turns << " turns"
+                  << ", detection+recovery: " << (rs.deadlocks ? rs.handling_ns / rs.deadlocks : 0) << " ns avg"
+                  << ", recovery latency: " << (recovered ? (double)rs.latency_turns / recovered : 0) << " turns avg\n"
+                  << "Post-recovery throughput: "
+                  << (rs.window_turns ? (double)rs.window_meals / rs.window_turns : 0) << " meals/turn\n";
+        return;
     }
 
     std::cout << "\n--- Simulation ended in Deadlock at Turn " << turn - 1 << " ---" << std::endl;
-    for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
-        std::cout << "Philosopher " << i << " is deadlocked, holding fork " << i << " and waiting for fork " << (i + 1) % NUM_PHILOSOPHERS << "." << std::endl;
+    for (int i = 0; i < n; ++i) {
+        std::cout << "Philosopher " << i << " is deadlocked, holding fork " << i << " and waiting for fork " << (i + 1) % n << "." << std::endl;
     }
 }
 
-int main() {
-    run_simulation();
+void usage(const char *prog) {
+    std::cerr << "usage: " << prog << " [--recover none|preempt|rollback-random|rollback-lowest]"
+              << " [--philosophers n] [--turns t] [--wave w | --staggered | --think t] [--seed s] [--quiet]\n";
+    std::exit(1);
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--quiet") {
+            opt.quiet = true;
+            continue;
+        }
+        if (arg == "--staggered") {
+            opt.staggered = true;
+            continue;
+        }
+        if (a + 1 >= argc) usage(argv[0]);
+        std::string val = argv[++a];
+        if (arg == "--recover") {
+            if (val == "none") opt.recovery = Recovery::NONE;
+            else if (val == "preempt") opt.recovery = Recovery::PREEMPT;
+            else if (val == "rollback-random") opt.recovery = Recovery::ROLLBACK_RANDOM;
+            else if (val == "rollback-lowest") opt.recovery = Recovery::ROLLBACK_LOWEST;
+            else usage(argv[0]);
+        } else if (arg == "--philosophers") {
+            opt.philosophers = std::atoi(val.c_str());
+        } else if (arg == "--turns") {
+            opt.max_turns = std::atol(val.c_str());
+        } else if (arg == "--think") {
+            opt.think = std::atol(val.c_str());
+        } else if (arg == "--wave") {
+            opt.wave = std::atol(val.c_str());
+            if (opt.wave < 1) usage(argv[0]);
+        } else if (arg == "--seed") {
+            char *end;
+            opt.seed = (unsigned)std::strtoul(val.c_str(), &end, 10);
+            if (val.empty() || *end) usage(argv[0]);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (opt.philosophers < 2 || opt.max_turns < 0) usage(argv[0]);
+    if ((opt.wave > 0) + opt.staggered + (opt.think >= 0) > 1) usage(argv[0]);
+    if (!opt.wave) opt.wave = 2L * opt.philosophers;
+    safety::checker().open("deadlock", opt.philosophers, safety::Threads::ONE);
+    run_simulation(opt);
     return 0;
 }
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include "../common/safety.h"
 
 const int NUM_PHILOSOPHERS = 5;
 
@@ -71,6 +72,7 @@ void run_simulation() {
                     if (forks[right_fork] == ForkState::FREE) {
                         forks[right_fork] = ForkState::HELD;
                         philosophers[i].state = PhilosopherState::EATING;
+                        safety::checker().eat(i, turn);
                         std::cout << "Philosopher " << i << " picked up fork " << right_fork << " and is now eating." << std::endl;
                         system_deadlocked = false;
                     } else {
@@ -80,6 +82,7 @@ void run_simulation() {
 
                 case PhilosopherState::EATING:
                     std::cout << "Philosopher " << i << " finished eating." << std::endl;
+                    safety::checker().done(i, turn);
                     forks[left_fork] = ForkState::FREE;
                     forks[right_fork] = ForkState::FREE;
                     philosophers[i].state = PhilosopherState::THINKING;
@@ -98,6 +101,7 @@ void run_simulation() {
 }
 
 int main() {
+    safety::checker().open("deadlock_", NUM_PHILOSOPHERS, safety::Threads::ONE);
     run_simulation();
     return 0;
 }
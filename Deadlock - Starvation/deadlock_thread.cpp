@@ -6,6 +6,7 @@
 #include <vector>
 #include <thread>
 #include <mutex>
+#include "../common/safety.h"
 
 // Define the number of philosophers and forks
 const int NUM_PHILOSOPHERS = 5;
@@ -49,18 +50,22 @@ void philosopher(int id) {
         // their right fork, which is the left fork of their neighbor.
         // Since all left forks are already locked, no one can proceed.
         forks[right_fork].lock();
+        safety::checker().eat(id);
 
         std::cout << "Philosopher " << id << " picked up fork " << right_fork << " and is now eating." << std::endl;
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
 
         // Eating is finished, put down the forks
         std::cout << "Philosopher " << id << " finished eating and put down forks " << left_fork << " and " << right_fork << "." << std::endl;
+        safety::checker().done(id);
         forks[right_fork].unlock();
         forks[left_fork].unlock();
     }
 }
 
 int main() {
+    safety::checker().open("deadlock_thread", NUM_PHILOSOPHERS);
+
     // Create an array of threads for each philosopher
     std::vector<std::thread> philosophers;
 
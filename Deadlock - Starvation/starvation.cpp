@@ -1,11 +1,30 @@
 // This program demonstrates a scenario that can lead to starvation in the Dining Philosophers Problem.
 // Starvation occurs when a philosopher is repeatedly denied access to forks while others eat.
 // This is different from deadlock, where no one can proceed.
+//
+// The retry after a failed try_lock() goes through a backoff policy from
+// common/backoff.h (default: the original fixed 50 ms sleep). --bench runs the same
+// loop without output, with think/eat/fixed-backoff times in microseconds instead of
+// milliseconds, and reports throughput, CPU time per meal and hungry-to-eating waits
+// for each policy.
+//
+// Compile: g++ -std=c++17 -O2 starvation.cpp -pthread -o starvation
+// Run:     ./starvation [--backoff fixed|spin|spin-yield|exponential|proportional]
+//          ./starvation --bench seconds [--backoff policy|all]
 
 #include <iostream>
+#include <iomanip>
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <sys/resource.h>
+#include "../common/backoff.h"
+#include "../common/safety.h"
 
 // Define the number of philosophers and forks
 const int NUM_PHILOSOPHERS = 5;
@@ -13,58 +32,186 @@ const int NUM_FORKS = 5;
 
 // An array of mutexes to represent the forks on the table.
 std::vector<std::mutex> forks(NUM_FORKS);
+std::vector<backoff::HoldTimes> hold_times(NUM_FORKS);
+
+using Clock = std::chrono::steady_clock;
+
+struct Run {
+    backoff::Policy policy = backoff::Policy::FIXED;
+    bool quiet = false;
+    std::chrono::nanoseconds unit = std::chrono::milliseconds(1);  // think/eat/fixed-backoff unit
+    std::atomic<bool> stop{false};
+};
+
+// What one philosopher saw during a --bench run.
+struct Tally {
+    long meals = 0;
+    long retries = 0;
+    std::vector<double> waits_us;
+};
+
+long since(Clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t).count();
+}
 
 // The function that each philosopher thread will execute.
-void philosopher(int id) {
+void philosopher(int id, Run &run, Tally &tally) {
     int left_fork = id;
     int right_fork = (id + 1) % NUM_FORKS;
+    long unit = run.unit.count();
+    backoff::Backoff retry(run.policy, {50 * unit, unit, 1000 * unit, 64}, id);
 
-    while (true) {
+    while (!run.stop.load(std::memory_order_relaxed)) {
         // Philosopher is thinking
-        std::cout << "Philosopher " << id << " is thinking." << std::endl;
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (!run.quiet)
+            std::cout << "Philosopher " << id << " is thinking." << std::endl;
+        std::this_thread::sleep_for(100 * run.unit);
 
         // The Starvation Scenario:
         // Instead of blocking, a philosopher uses try_lock() to check for forks.
         // If they can't get BOTH, they immediately release the one they have and retry.
         // This can lead to a "livelock" where they are always busy-waiting.
 
-        std::cout << "Philosopher " << id << " is hungry." << std::endl;
+        if (!run.quiet)
+            std::cout << "Philosopher " << id << " is hungry." << std::endl;
+        auto hungry = Clock::now();
+        retry.reset();
 
         while (true) {
             // Try to acquire the left fork first.
             forks[left_fork].lock();
+            auto left_taken = Clock::now();
 
             // Try to acquire the right fork non-blockingly.
             // This is where starvation can occur. If the right fork is always busy,
             // the philosopher will immediately release the left one and retry.
             if (forks[right_fork].try_lock()) {
                 // Success! Both forks acquired.
-                std::cout << "Philosopher " << id << " is eating." << std::endl;
-                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                auto right_taken = Clock::now();
+                safety::checker().eat(id);
+                if (run.quiet)
+                    tally.waits_us.push_back(std::chrono::duration<double, std::micro>(right_taken - hungry).count());
+                if (!run.quiet)
+                    std::cout << "Philosopher " << id << " is eating." << std::endl;
+                std::this_thread::sleep_for(200 * run.unit);
 
                 // Finished eating, release both forks.
-                std::cout << "Philosopher " << id << " put down forks " << left_fork << " and " << right_fork << "." << std::endl;
+                if (!run.quiet)
+                    std::cout << "Philosopher " << id << " put down forks " << left_fork << " and " << right_fork << "." << std::endl;
+                safety::checker().done(id);
+                hold_times[right_fork].record(since(right_taken));
                 forks[right_fork].unlock();
+                hold_times[left_fork].record(since(left_taken));
                 forks[left_fork].unlock();
+                tally.meals++;
                 break; // Exit the inner loop and go back to thinking.
             } else {
                 // Failed to acquire the right fork. Release the left one immediately.
-                std::cout << "Philosopher " << id << " couldn't get fork " << right_fork << ". Releasing fork " << left_fork << " and trying again." << std::endl;
+                if (!run.quiet)
+                    std::cout << "Philosopher " << id << " couldn't get fork " << right_fork << ". Releasing fork " << left_fork << " and trying again." << std::endl;
+                hold_times[left_fork].record(since(left_taken));
                 forks[left_fork].unlock();
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                tally.retries++;
+                backoff::wait(retry.next_delay(hold_times[right_fork].mean()));
+                if (run.stop.load(std::memory_order_relaxed)) return;
             }
         }
     }
 }
 
-int main() {
+double cpu_seconds() {
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+double percentile(std::vector<double> &v, double p) {
+    if (v.empty()) return 0;
+    size_t k = std::min(v.size() - 1, (size_t)(p * v.size()));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+// Runs the table quietly for `seconds` under one policy and prints a report line.
+void bench(backoff::Policy policy, double seconds) {
+    Run run;
+    run.policy = policy;
+    run.quiet = true;
+    safety::checker().open("starvation", NUM_PHILOSOPHERS);
+    run.unit = std::chrono::microseconds(1);
+    std::vector<Tally> tallies(NUM_PHILOSOPHERS);
+
+    double cpu0 = cpu_seconds();
+    auto start = Clock::now();
+    std::vector<std::thread> philosophers;
+    for (int i = 0; i < NUM_PHILOSOPHERS; ++i)
+        philosophers.emplace_back(philosopher, i, std::ref(run), std::ref(tallies[i]));
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    run.stop = true;
+    for (auto &t : philosophers) t.join();
+    double wall = std::chrono::duration<double>(Clock::now() - start).count();
+    double cpu = cpu_seconds() - cpu0;
+
+    long meals = 0, retries = 0;
+    std::vector<double> waits;
+    for (Tally &t : tallies) {
+        meals += t.meals;
+        retries += t.retries;
+        waits.insert(waits.end(), t.waits_us.begin(), t.waits_us.end());
+    }
+    std::cout << std::left << std::setw(14) << backoff::policy_name(policy) << std::right << std::fixed
+              << std::setprecision(0) << std::setw(10) << meals / wall
+              << std::setprecision(1) << std::setw(14) << (meals ? cpu * 1e6 / meals : 0)
+              << std::setw(14) << (meals ? (double)retries / meals : 0)
+              << std::setw(12) << percentile(waits, 0.50)
+              << std::setw(12) << percentile(waits, 0.99) << "\n";
+}
+
+int main(int argc, char **argv) {
+    backoff::Policy policy = backoff::Policy::FIXED;
+    bool all = false;
+    double bench_seconds = 0;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        std::string val = a + 1 < argc ? argv[++a] : "";
+        bool ok = false;
+        if (arg == "--backoff")
+            ok = (all = val == "all") || backoff::parse_policy(val, policy);
+        else if (arg == "--bench")
+            ok = (bench_seconds = std::atof(val.c_str())) > 0;
+        if (!ok) {
+            std::cerr << "usage: " << argv[0] << " [--backoff fixed|spin|spin-yield|exponential|proportional]\n"
+                      << "       " << argv[0] << " --bench seconds [--backoff policy|all]\n";
+            return 1;
+        }
+    }
+
+    if (bench_seconds > 0) {
+        std::cout << NUM_PHILOSOPHERS << " philosophers, think 100 us, eat 200 us, "
+                  << bench_seconds << " s per policy\n"
+                  << "policy         meals/s   cpu us/meal  retries/meal  p50 wait us  p99 wait us\n";
+        if (all)
+            for (backoff::Policy p : backoff::ALL) bench(p, bench_seconds);
+        else
+            bench(policy, bench_seconds);
+        return 0;
+    }
+    if (all) {
+        std::cerr << "--backoff all needs --bench\n";
+        return 1;
+    }
+
+    safety::checker().open("starvation", NUM_PHILOSOPHERS);
+
     // Create an array of threads for each philosopher
+    Run run;
+    run.policy = policy;
+    std::vector<Tally> tallies(NUM_PHILOSOPHERS);
     std::vector<std::thread> philosophers;
 
     // Start a thread for each philosopher
     for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
-        philosophers.emplace_back(philosopher, i);
+        philosophers.emplace_back(philosopher, i, std::ref(run), std::ref(tallies[i]));
     }
 
     // Wait for all threads to finish (they won't in this case, due to infinite loop)
@@ -1,5 +1,12 @@
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include "../common/backoff.h"
+#include "../common/stats_page.h"
+#include "../common/sim_options.h"
+#include "../common/worklist.h"
+#include "../common/safety.h"
+#include "../common/checkpoint.h"
 
 constexpr int NUM_PHILOSOPHERS = 5;
 
@@ -22,96 +29,212 @@ struct Philosopher {
     PhilosopherState state;
 };
 
-// Main simulation function
-void run_simulation() {
+// First turn after `turn` at which a thinking philosopher i becomes hungry again.
+long next_hungry_turn(int i, long turn) {
+    long period = i + 2;
+    return (turn / period + 1) * period;
+}
+
+// Main simulation function. Without a retry policy a philosopher whose fork is taken
+// tries again every turn; with one it waits as many turns as the policy says and the
+// closing summary adds polls per meal and hungry-to-eating waits. Checkpoints leave
+// the retry state out, so main() does not combine the two.
+void run_simulation(const SimOptions &opt, const backoff::Policy *retry_policy, const ckpt::Options &ck) {
+    const int n = opt.philosophers;
+
     // Initialize philosophers and their states
-    std::vector<Philosopher> philosophers(NUM_PHILOSOPHERS);
-    for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
+    stats::Page &st = stats::page();
+    std::vector<Philosopher> philosophers(n);
+    for (int i = 0; i < n; ++i) {
         philosophers[i] = {i, PhilosopherState::HUNGRY};
+        st.set_state(i, stats::HUNGRY);
     }
 
     // Initialize forks and their states
-    std::vector<ForkState> forks(NUM_PHILOSOPHERS, ForkState::FREE);
+    std::vector<ForkState> forks(n, ForkState::FREE);
 
-    int turn = 0;
+    std::vector<backoff::Backoff> retry;
+    for (int i = 0; retry_policy && i < n; ++i)
+        retry.emplace_back(*retry_policy, backoff::Config{1, 1, 64, 2}, i);
+    std::vector<long> retry_at(n, 0), hungry_since(n, 0), fork_taken_at(n, 0);
+    std::vector<backoff::HoldTimes> hold_turns(n);
+    std::vector<long> waits;
+    long polls = 0;
 
-    // Simulation loop
-    while (true) {
-        std::cout << "\n--- Turn " << turn << " ---" << std::endl;
-        bool all_are_thinking = true;
-
-        for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
-            int left_fork = i;
-            int right_fork = (i + 1) % NUM_PHILOSOPHERS;
-
-            switch (philosophers[i].state) {
-                case PhilosopherState::THINKING: {
-                    // A thinking philosopher sometimes becomes hungry again
-                    if (turn % (i + 2) == 0) {
-                        philosophers[i].state = PhilosopherState::HUNGRY;
+    Worklist work(n);
+    TransitionHash transitions;
+    long meals = 0;
+    int busy = n;   // philosophers that are not THINKING
+    long turn = 0;
+    bool all_are_thinking = true;
+
+    // Queue the other users of fork f: philosopher f (left fork) and f-1 (right fork).
+    auto fork_changed = [&](int f, int position) {
+        work.mark(f, position);
+        work.mark((f + n - 1) % n, position);
+    };
+
+    auto changed_state = [&](int i) {
+        transitions.add(turn, i, (int)philosophers[i].state);
+        work.mark(i, i);
+    };
+
+    // A philosopher found fork f taken: back off per the retry policy.
+    auto fork_busy = [&](int i, int f) {
+        if (!retry_policy) return;
+        retry_at[i] = turn + 1 + retry[i].next_delay(hold_turns[f].mean());
+        work.wake_at(i, retry_at[i]);
+    };
+
+    // Checkpoint: philosopher and fork states and what the loop carries between turns.
+    auto save = [&](ckpt::Writer &w) {
+        w.each<uint8_t>(n, [&](int i) { return (uint8_t)philosophers[i].state; });
+        w.each<uint8_t>(n, [&](int f) { return (uint8_t)forks[f]; });
+        w.put(meals);
+        w.put(busy);
+        work.save(w);
+        transitions.save(w);
+    };
+    if (!ck.resume.empty()) {
+        ckpt::Image image(ck.resume, "asymmetric", n);
+        ckpt::Reader r = image.reader();
+        turn = image.turn();
+        const stats::State shown[] = {stats::THINKING, stats::HUNGRY, stats::HOLDING_ONE_FORK, stats::EATING};
+        r.each<uint8_t>(n, [&](int i, uint8_t v) {
+            philosophers[i].state = PhilosopherState(v);
+            st.set_state(i, shown[v & 3]);
+            if (philosophers[i].state == PhilosopherState::EATING) safety::checker().eat(i, turn - 1);
+        });
+        r.each<uint8_t>(n, [&](int f, uint8_t v) { forks[f] = ForkState(v); });
+        meals = r.get<long>();
+        busy = r.get<int>();
+        work.load(r);
+        transitions.load(r);
+    }
+    ckpt::Saver saver(ck, "asymmetric", n);
+
+    auto take_fork = [&](int i, int f) {
+        forks[f] = ForkState::HELD;
+        fork_taken_at[f] = turn;
+        if (retry_policy) retry[i].reset();
+    };
+
+    auto put_fork = [&](int f) {
+        forks[f] = ForkState::FREE;
+        hold_turns[f].record(turn - fork_taken_at[f]);
+    };
+
+    // Visit philosopher i and queue whoever its changes affect.
+    auto step = [&](int i) {
+        int left_fork = i;
+        int right_fork = (i + 1) % n;
+
+        switch (philosophers[i].state) {
+            case PhilosopherState::THINKING: {
+                // A thinking philosopher sometimes becomes hungry again
+                if (turn % (i + 2) == 0) {
+                    philosophers[i].state = PhilosopherState::HUNGRY;
+                    hungry_since[i] = turn;
+                    st.set_state(i, stats::HUNGRY);
+                    if (!opt.quiet)
                         std::cout << "Philosopher " << i << " is now hungry." << std::endl;
-                        all_are_thinking = false;
-                    }
-                    break;
+                    all_are_thinking = false;
+                    busy++;
+                    changed_state(i);
                 }
+                break;
+            }
 
-                case PhilosopherState::HUNGRY: {
-                    // Asymmetric rule: Odd-numbered philosophers pick up the left fork first.
-                    // Even-numbered philosophers pick up the right fork first.
-                    if (i % 2 != 0) { // Odd philosopher
-                        if (forks[left_fork] == ForkState::FREE) {
-                            forks[left_fork] = ForkState::HELD;
-                            philosophers[i].state = PhilosopherState::HOLDING_FIRST_FORK;
+            case PhilosopherState::HUNGRY: {
+                // Asymmetric rule: Odd-numbered philosophers pick up the left fork first.
+                // Even-numbered philosophers pick up the right fork first.
+                int first = i % 2 != 0 ? left_fork : right_fork;
+                if (turn < retry_at[i]) break;
+                polls++;
+                if (forks[first] == ForkState::FREE) {
+                    take_fork(i, first);
+                    philosophers[i].state = PhilosopherState::HOLDING_FIRST_FORK;
+                    st.fork_held(first);
+                    st.set_state(i, stats::HOLDING_ONE_FORK);
+                    if (!opt.quiet) {
+                        if (i % 2 != 0) // Odd philosopher
                             std::cout << "Philosopher " << i << " (Odd) picked up left fork " << left_fork << "." << std::endl;
-                        }
-                    } else { // Even philosopher
-                        if (forks[right_fork] == ForkState::FREE) {
-                            forks[right_fork] = ForkState::HELD;
-                            philosophers[i].state = PhilosopherState::HOLDING_FIRST_FORK;
+                        else            // Even philosopher
                             std::cout << "Philosopher " << i << " (Even) picked up right fork " << right_fork << "." << std::endl;
-                        }
                     }
-                    all_are_thinking = false;
-                    break;
+                    changed_state(i);
+                    fork_changed(first, i);
+                } else {
+                    fork_busy(i, first);
                 }
+                break;
+            }
 
-                case PhilosopherState::HOLDING_FIRST_FORK: {
-                    // Now, try to pick up the second fork
-                    if (i % 2 != 0) { // Odd philosopher
-                        if (forks[right_fork] == ForkState::FREE) {
-                            forks[right_fork] = ForkState::HELD;
-                            philosophers[i].state = PhilosopherState::EATING;
-                            std::cout << "Philosopher " << i << " picked up right fork " << right_fork
-                                      << " and is now eating." << std::endl;
-                        }
-                    } else { // Even philosopher
-                        if (forks[left_fork] == ForkState::FREE) {
-                            forks[left_fork] = ForkState::HELD;
-                            philosophers[i].state = PhilosopherState::EATING;
-                            std::cout << "Philosopher " << i << " picked up left fork " << left_fork
-                                      << " and is now eating." << std::endl;
-                        }
-                    }
-                    all_are_thinking = false;
-                    break;
+            case PhilosopherState::HOLDING_FIRST_FORK: {
+                // Now, try to pick up the second fork
+                int second = i % 2 != 0 ? right_fork : left_fork;
+                if (turn < retry_at[i]) break;
+                polls++;
+                if (forks[second] == ForkState::FREE) {
+                    take_fork(i, second);
+                    waits.push_back(turn - hungry_since[i]);
+                    philosophers[i].state = PhilosopherState::EATING;
+                    safety::checker().eat(i, turn);
+                    st.fork_held(second);
+                    st.set_state(i, stats::EATING);
+                    if (!opt.quiet)
+                        std::cout << "Philosopher " << i << " picked up " << (i % 2 != 0 ? "right" : "left")
+                                  << " fork " << second << " and is now eating." << std::endl;
+                    changed_state(i);
+                    fork_changed(second, i);
+                } else {
+                    fork_busy(i, second);
                 }
+                break;
+            }
 
-                case PhilosopherState::EATING: {
+            case PhilosopherState::EATING: {
+                safety::checker().done(i, turn);
+                if (!opt.quiet)
                     std::cout << "Philosopher " << i << " finished eating." << std::endl;
-                    forks[left_fork] = ForkState::FREE;
-                    forks[right_fork] = ForkState::FREE;
-                    philosophers[i].state = PhilosopherState::THINKING;
-                    all_are_thinking = false;
-                    break;
-                }
+                put_fork(left_fork);
+                put_fork(right_fork);
+                philosophers[i].state = PhilosopherState::THINKING;
+                st.meal(i);
+                st.set_state(i, stats::THINKING);
+                meals++;
+                busy--;
+                changed_state(i);
+                fork_changed(left_fork, i);
+                fork_changed(right_fork, i);
+                work.wake_at(i, next_hungry_turn(i, turn));
+                break;
             }
         }
+    };
+
+    // Simulation loop
+    while (true) {
+        if (!opt.quiet)
+            std::cout << "\n--- Turn " << turn << " ---" << std::endl;
+        st.set_turn(turn);
+        // Only a philosopher's own visit changes its state, so anyone not THINKING
+        // now will be seen in a non-thinking state by this turn's scan.
+        all_are_thinking = busy == 0;
+        work.begin_turn(turn);
+
+        if (opt.worklist) {
+            int i;
+            while (work.pop(i)) step(i);
+        } else {
+            for (int i = 0; i < n; ++i) step(i);
+        }
 
         turn++;
 
         // End simulation after a certain number of turns to prevent infinite loop
-        if (turn > 50) {
-            std::cout << "\n--- Simulation ended after 50 turns. ---" << std::endl;
+        if (turn > opt.max_turns) {
+            std::cout << "\n--- Simulation ended after " << opt.max_turns << " turns. ---" << std::endl;
             break;
         }
 
@@ -119,10 +242,38 @@ void run_simulation() {
             std::cout << "\n--- Simulation ended because all philosophers are thinking. ---" << std::endl;
             break;
         }
+        saver.tick(turn, save);
+    }
+    if (opt.quiet)
+        std::cout << "Turns: " << turn << ", meals: " << meals << ", transition hash: "
+                  << std::hex << transitions.value() << std::dec << "\n";
+    if (retry_policy) {
+        std::sort(waits.begin(), waits.end());
+        auto pct = [&](double p) { return waits.empty() ? 0 : waits[std::min(waits.size() - 1, (size_t)(p * waits.size()))]; };
+        std::cout << "Backoff " << backoff::policy_name(*retry_policy) << ": meals/turn "
+                  << (double)meals / turn << ", polls/meal " << (meals ? (double)polls / meals : 0)
+                  << ", wait p50 " << pct(0.50) << " turns, p99 " << pct(0.99) << " turns\n";
     }
 }
 
-int main() {
-    run_simulation();
+// Run: ./asymmetric [--philosophers n] [--turns t] [--stepping full|worklist] [--quiet]
+//                   [--backoff fixed|spin|spin-yield|exponential|proportional]
+//                   [--checkpoint file] [--checkpoint-every t] [--resume file]   (not with --backoff)
+// DP_STATS=1 publishes live counters (see Tools/stats_watch.cpp).
+int main(int argc, char **argv) {
+    backoff::Policy policy;
+    bool use_backoff = false;
+    ckpt::Options ck;
+    const std::string usage = " [--backoff fixed|spin|spin-yield|exponential|proportional]" + std::string(ckpt::USAGE);
+    SimOptions opt = parse_sim_options(argc, argv, NUM_PHILOSOPHERS, 50,
+        [&](const std::string &flag, const std::string &value) {
+            if (ckpt::parse_option(flag, value, ck)) return true;
+            return flag == "--backoff" && (use_backoff = backoff::parse_policy(value, policy));
+        },
+        usage.c_str());
+    if (use_backoff && (!ck.path.empty() || !ck.resume.empty())) sim_usage(argv[0], usage.c_str());
+    stats::page().open("asymmetric", opt.philosophers);
+    safety::checker().open("asymmetric", opt.philosophers, safety::Threads::ONE);
+    run_simulation(opt, use_backoff ? &policy : nullptr, ck);
     return 0;
 }
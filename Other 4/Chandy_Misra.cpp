@@ -1,6 +1,11 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include "../common/stats_page.h"
+#include "../common/sim_options.h"
+#include "../common/worklist.h"
+#include "../common/safety.h"
+#include "../common/checkpoint.h"
 
 constexpr int NUM_PHILOSOPHERS = 5;
 
@@ -25,135 +30,267 @@ struct Philosopher {
     bool has_requested_right;
 };
 
+// First turn after `turn` at which a thinking philosopher i becomes hungry again.
+long next_hungry_turn(int i, long turn) {
+    long period = i + 2;
+    return (turn / period + 1) * period;
+}
+
 // Simulation function
-void run_simulation() {
-    std::vector<Philosopher> philosophers(NUM_PHILOSOPHERS);
-    std::vector<Fork> forks(NUM_PHILOSOPHERS);
+void run_simulation(const SimOptions &opt, const ckpt::Options &ck) {
+    const int n = opt.philosophers;
+    std::vector<Philosopher> philosophers(n);
+    std::vector<Fork> forks(n);
 
     // Initialize philosophers and forks
-    for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
+    for (int i = 0; i < n; ++i) {
         philosophers[i] = {i, PhilosopherState::THINKING, false, false};
         // Simplified initialization: each fork initially belongs to the philosopher with the same id
         forks[i] = {true, i};
     }
 
-    int turn = 0;
+    stats::Page &st = stats::page();
+    // Worklist stepping: `work` holds the philosophers to visit, `dirty_forks` the forks
+    // whose transfer rule has to be re-checked at the start of the next turn. A fork's
+    // rule reads its owner (and whether the owner is eating), the left user's
+    // has_requested_left and the next philosopher's has_requested_right.
+    Worklist work(n);
+    DirtySet dirty_forks(n, true);
+    TransitionHash transitions;
+    long meals = 0;
+    int busy = 0;   // philosophers that are not THINKING
+    long turn = 0;
 
-    while (true) {
-        std::cout << "\n--- Turn " << turn << " ---" << std::endl;
+    // Owners of fork k are always k-1, k or k+1, so a change in philosopher i's
+    // state or requests can only matter to forks i-1, i and i+1. On a scan turn every
+    // fork is re-checked next turn anyway (a scan or the turn after it).
+    auto dirty_fork = [&](int k) {
+        if (!work.scan()) dirty_forks.add(k);
+    };
+    auto forks_near = [&](int i) {
+        dirty_fork((i + n - 1) % n);
+        dirty_fork(i);
+        dirty_fork((i + 1) % n);
+    };
 
-        // Print fork owners (helps to debug/see progress)
-        for (int f = 0; f < NUM_PHILOSOPHERS; ++f) {
-            std::cout << "Fork " << f << " owner: " << forks[f].owner_id
-                      << (forks[f].is_clean ? " (clean)" : " (dirty)") << std::endl;
-        }
+    auto changed_state = [&](int i) {
+        transitions.add(turn, i, (int)philosophers[i].state);
+        work.mark(i, i);
+        forks_near(i);
+    };
 
-        // Allow passive transfers: if a fork owner is not eating and a neighbor requested it,
-        // transfer the fork to the requester. This simple transfer rule helps the single-threaded
-        // simulation make progress (it is a simulation, not a full distributed runtime).
-        for (int k = 0; k < NUM_PHILOSOPHERS; ++k) {
-            int owner = forks[k].owner_id;
-            int left = k;
-            int right = (k + 1) % NUM_PHILOSOPHERS;
-
-            if (philosophers[owner].state != PhilosopherState::EATING) {
-                if (owner != left && philosophers[left].has_requested_left) {
-                    forks[k].owner_id = left;
-                    philosophers[left].has_requested_left = false;
-                    forks[k].is_clean = true; // passed fork becomes clean
-                    std::cout << "Fork " << k << " passed to Philosopher " << left << " (requested)." << std::endl;
-                } else if (owner != right && philosophers[right].has_requested_right) {
-                    forks[k].owner_id = right;
-                    philosophers[right].has_requested_right = false;
-                    forks[k].is_clean = true;
-                    std::cout << "Fork " << k << " passed to Philosopher " << right << " (requested)." << std::endl;
-                }
+    // Checkpoint: philosopher states with their request flags, fork owners and clean
+    // bits, and what the loop carries from one turn to the next.
+    auto save = [&](ckpt::Writer &w) {
+        w.each<uint8_t>(n, [&](int i) {
+            const Philosopher &p = philosophers[i];
+            return (uint8_t)((int)p.state | p.has_requested_left << 2 | p.has_requested_right << 3);
+        });
+        w.each<int32_t>(n, [&](int k) { return forks[k].owner_id; });
+        w.each<uint8_t>(n, [&](int k) { return forks[k].is_clean; });
+        w.put(meals);
+        w.put(busy);
+        work.save(w);
+        dirty_forks.save(w);
+        transitions.save(w);
+    };
+    if (!ck.resume.empty()) {
+        ckpt::Image image(ck.resume, "chandy_misra", n);
+        ckpt::Reader r = image.reader();
+        turn = image.turn();
+        r.each<uint8_t>(n, [&](int i, uint8_t v) {
+            philosophers[i] = {i, PhilosopherState(v & 3), (v & 4) != 0, (v & 8) != 0};
+            st.set_state(i, philosophers[i].state == PhilosopherState::EATING   ? stats::EATING
+                            : philosophers[i].state == PhilosopherState::HUNGRY ? stats::HUNGRY
+                                                                                : stats::THINKING);
+            if (philosophers[i].state == PhilosopherState::EATING) safety::checker().eat(i, turn - 1);
+        });
+        r.each<int32_t>(n, [&](int k, int32_t owner) { forks[k].owner_id = owner; });
+        r.each<uint8_t>(n, [&](int k, uint8_t clean) { forks[k].is_clean = clean; });
+        meals = r.get<long>();
+        busy = r.get<int>();
+        work.load(r);
+        dirty_forks.load(r);
+        transitions.load(r);
+    }
+    ckpt::Saver saver(ck, "chandy_misra", n);
+
+    // Transfer rule for fork k; queues the philosophers it can affect this turn.
+    auto transfer = [&](int k) {
+        int owner = forks[k].owner_id;
+        int left = k;
+        int right = (k + 1) % n;
+
+        if (philosophers[owner].state != PhilosopherState::EATING) {
+            int to = -1;
+            if (owner != left && philosophers[left].has_requested_left) {
+                forks[k].owner_id = left;
+                philosophers[left].has_requested_left = false;
+                forks[k].is_clean = true; // passed fork becomes clean
+                to = left;
+            } else if (owner != right && philosophers[right].has_requested_right) {
+                forks[k].owner_id = right;
+                philosophers[right].has_requested_right = false;
+                forks[k].is_clean = true;
+                to = right;
+            }
+            if (to >= 0) {
+                transitions.add(turn, n + k, to);
+                if (!opt.quiet)
+                    std::cout << "Fork " << k << " passed to Philosopher " << to << " (requested)." << std::endl;
+                dirty_fork(k);
+                work.mark((k + n - 1) % n, -1);
+                work.mark(k, -1);
+                work.mark(right, -1);
             }
         }
+    };
 
-        bool all_are_thinking = true;
+    // Visit philosopher i and queue whoever its changes affect.
+    auto step = [&](int i) {
+        int left_fork_id = i;
+        int right_fork_id = (i + 1) % n;
 
-        for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
-            int left_fork_id = i;
-            int right_fork_id = (i + 1) % NUM_PHILOSOPHERS;
-
-            switch (philosophers[i].state) {
-                case PhilosopherState::THINKING: {
-                    // A thinking philosopher sometimes becomes hungry (staggered by index)
-                    if (turn % (i + 2) == 0) {
-                        philosophers[i].state = PhilosopherState::HUNGRY;
+        switch (philosophers[i].state) {
+            case PhilosopherState::THINKING: {
+                // A thinking philosopher sometimes becomes hungry (staggered by index)
+                if (turn % (i + 2) == 0) {
+                    philosophers[i].state = PhilosopherState::HUNGRY;
+                    st.set_state(i, stats::HUNGRY);
+                    if (!opt.quiet)
                         std::cout << "Philosopher " << i << " is now hungry." << std::endl;
-                    }
-                    break;
+                    busy++;
+                    changed_state(i);
                 }
+                break;
+            }
 
-                case PhilosopherState::HUNGRY: {
-                    // Try to acquire forks from neighbors based on ownership
-                    bool has_left = (forks[left_fork_id].owner_id == i);
-                    bool has_right = (forks[right_fork_id].owner_id == i);
+            case PhilosopherState::HUNGRY: {
+                // Try to acquire forks from neighbors based on ownership
+                bool has_left = (forks[left_fork_id].owner_id == i);
+                bool has_right = (forks[right_fork_id].owner_id == i);
 
-                    if (has_left && has_right) {
-                        philosophers[i].state = PhilosopherState::EATING;
+                if (has_left && has_right) {
+                    philosophers[i].state = PhilosopherState::EATING;
+                    safety::checker().eat(i, turn);
+                    st.fork_held(left_fork_id);
+                    st.fork_held(right_fork_id);
+                    st.set_state(i, stats::EATING);
+                    if (!opt.quiet)
                         std::cout << "Philosopher " << i << " is eating." << std::endl;
-                        forks[left_fork_id].is_clean = false; // forks become dirty after use
-                        forks[right_fork_id].is_clean = false;
-                    } else {
-                        // Request forks they don't have
-                        if (!has_left && !philosophers[i].has_requested_left) {
+                    forks[left_fork_id].is_clean = false; // forks become dirty after use
+                    forks[right_fork_id].is_clean = false;
+                    changed_state(i);
+                } else {
+                    // Request forks they don't have
+                    if (!has_left && !philosophers[i].has_requested_left) {
+                        if (!opt.quiet)
                             std::cout << "Philosopher " << i << " requesting fork " << left_fork_id
                                       << " from Philosopher " << forks[left_fork_id].owner_id << "." << std::endl;
-                            philosophers[i].has_requested_left = true;
-                        }
-                        if (!has_right && !philosophers[i].has_requested_right) {
+                        philosophers[i].has_requested_left = true;
+                        forks_near(i);
+                    }
+                    if (!has_right && !philosophers[i].has_requested_right) {
+                        if (!opt.quiet)
                             std::cout << "Philosopher " << i << " requesting fork " << right_fork_id
                                       << " from Philosopher " << forks[right_fork_id].owner_id << "." << std::endl;
-                            philosophers[i].has_requested_right = true;
-                        }
+                        philosophers[i].has_requested_right = true;
+                        forks_near(i);
                     }
-                    break;
                 }
+                break;
+            }
 
-                case PhilosopherState::EATING: {
-                    // A philosopher finishes eating and releases forks (goes back to thinking)
+            case PhilosopherState::EATING: {
+                safety::checker().done(i, turn);
+                // A philosopher finishes eating and releases forks (goes back to thinking)
+                if (!opt.quiet)
                     std::cout << "Philosopher " << i << " finished eating." << std::endl;
-                    philosophers[i].state = PhilosopherState::THINKING;
+                philosophers[i].state = PhilosopherState::THINKING;
+                st.meal(i);
+                st.set_state(i, stats::THINKING);
+                meals++;
+                busy--;
 
-                    // Pass forks to neighbors if they were requested while eating
-                    int left_neighbor = (i + NUM_PHILOSOPHERS - 1) % NUM_PHILOSOPHERS;
-                    int right_neighbor = (i + 1) % NUM_PHILOSOPHERS;
+                // Pass forks to neighbors if they were requested while eating
+                int left_neighbor = (i + n - 1) % n;
+                int right_neighbor = (i + 1) % n;
 
-                    if (philosophers[left_neighbor].has_requested_right) {
-                        forks[left_fork_id].owner_id = left_neighbor;
-                        philosophers[left_neighbor].has_requested_right = false;
-                        forks[left_fork_id].is_clean = true;
+                if (philosophers[left_neighbor].has_requested_right) {
+                    forks[left_fork_id].owner_id = left_neighbor;
+                    philosophers[left_neighbor].has_requested_right = false;
+                    forks[left_fork_id].is_clean = true;
+                    if (!opt.quiet)
                         std::cout << "Philosopher " << i << " passed fork " << left_fork_id
                                   << " to Philosopher " << left_neighbor << "." << std::endl;
-                    }
-                    if (philosophers[right_neighbor].has_requested_left) {
-                        forks[right_fork_id].owner_id = right_neighbor;
-                        philosophers[right_neighbor].has_requested_left = false;
-                        forks[right_fork_id].is_clean = true;
+                }
+                if (philosophers[right_neighbor].has_requested_left) {
+                    forks[right_fork_id].owner_id = right_neighbor;
+                    philosophers[right_neighbor].has_requested_left = false;
+                    forks[right_fork_id].is_clean = true;
+                    if (!opt.quiet)
                         std::cout << "Philosopher " << i << " passed fork " << right_fork_id
                                   << " to Philosopher " << right_neighbor << "." << std::endl;
-                    }
-
-                    // Clear this philosopher's outstanding requests (they were served or are no longer relevant)
-                    philosophers[i].has_requested_left = false;
-                    philosophers[i].has_requested_right = false;
-                    break;
                 }
+
+                // Clear this philosopher's outstanding requests (they were served or are no longer relevant)
+                philosophers[i].has_requested_left = false;
+                philosophers[i].has_requested_right = false;
+
+                changed_state(i);
+                forks_near(left_neighbor);
+                forks_near(right_neighbor);
+                work.mark(left_neighbor, i);
+                work.mark(right_neighbor, i);
+                work.wake_at(i, next_hungry_turn(i, turn));
+                break;
             }
+        }
+    };
+
+    while (true) {
+        if (!opt.quiet)
+            std::cout << "\n--- Turn " << turn << " ---" << std::endl;
+        st.set_turn(turn);
 
-            if (philosophers[i].state != PhilosopherState::THINKING) {
-                all_are_thinking = false;
+        // Print fork owners (helps to debug/see progress)
+        if (!opt.quiet) {
+            for (int f = 0; f < n; ++f) {
+                std::cout << "Fork " << f << " owner: " << forks[f].owner_id
+                          << (forks[f].is_clean ? " (clean)" : " (dirty)") << std::endl;
             }
         }
 
+        work.begin_turn(turn);
+
+        // Allow passive transfers: if a fork owner is not eating and a neighbor requested it,
+        // transfer the fork to the requester. This simple transfer rule helps the single-threaded
+        // simulation make progress (it is a simulation, not a full distributed runtime).
+        // Each rule only touches its own fork and requests, so forks are independent here.
+        // Busy turns (see common/worklist.h) check every fork.
+        if (opt.worklist && !work.everyone()) {
+            for (int k : dirty_forks.drain()) transfer(k);
+        } else {
+            dirty_forks.clear();
+            for (int k = 0; k < n; ++k) transfer(k);
+        }
+
+        if (opt.worklist) {
+            int i;
+            while (work.pop(i)) step(i);
+        } else {
+            for (int i = 0; i < n; ++i) step(i);
+        }
+
+        // A philosopher's state only changes on its own visit, so this is the same as
+        // checking each one right after it was visited.
+        bool all_are_thinking = busy == 0;
+
         turn++;
 
         // End simulation after a certain number of turns to prevent an infinite loop
-        if (turn > 50) {
-            std::cout << "\n--- Simulation ended after 50 turns. ---" << std::endl;
+        if (turn > opt.max_turns) {
+            std::cout << "\n--- Simulation ended after " << opt.max_turns << " turns. ---" << std::endl;
             break;
         }
 
@@ -161,10 +298,23 @@ void run_simulation() {
             std::cout << "\n--- Simulation ended because all philosophers are thinking. ---" << std::endl;
             break;
         }
+        saver.tick(turn, save);
     }
+    if (opt.quiet)
+        std::cout << "Turns: " << turn << ", meals: " << meals << ", transition hash: "
+                  << std::hex << transitions.value() << std::dec << "\n";
 }
 
-int main() {
-    run_simulation();
+// Run: ./chandy_misra [--philosophers n] [--turns t] [--stepping full|worklist] [--quiet]
+//                     [--checkpoint file] [--checkpoint-every t] [--resume file]
+// DP_STATS=1 publishes live counters (see Tools/stats_watch.cpp).
+int main(int argc, char **argv) {
+    ckpt::Options ck;
+    SimOptions opt = parse_sim_options(argc, argv, NUM_PHILOSOPHERS, 50,
+        [&](const std::string &flag, const std::string &value) { return ckpt::parse_option(flag, value, ck); },
+        ckpt::USAGE);
+    stats::page().open("chandy_misra", opt.philosophers);
+    safety::checker().open("chandy_misra", opt.philosophers, safety::Threads::ONE);
+    run_simulation(opt, ck);
     return 0;
 }
@@ -0,0 +1,440 @@
+// Dining Philosophers - Chandy-Misra across processes
+// Chandy_Misra.cpp simulates fork passing in one address space. Here the protocol
+// runs for real: the ring is cut into segments, each segment is a separate process,
+// and neighbouring segments talk over a Unix-domain socketpair (SOCK_SEQPACKET).
+// Inside a segment, tokens are handed over in memory.
+//
+// Protocol (hygienic forks): every fork starts dirty with the lower-numbered neighbour
+// (fork 0 with philosopher 0), and the other neighbour holds the request token for it.
+// A hungry philosopher sends the request token for each fork it lacks. A request for a
+// dirty fork is served at once unless the holder is eating; a clean fork is kept.
+// Eating dirties both forks, and afterwards every deferred request gets its fork
+// (cleaned in transit). A hungry philosopher that gives a fork away asks for it back
+// in the same message.
+//
+// Wire format: the link between two segments carries a single fork, so a token needs
+// no address: it is one byte (REQUEST or FORK), in order. Tokens produced while
+// handling one batch of events are coalesced into one packet per link, written once
+// per pass of the event loop (--no-batch writes every token on its own).
+//
+// The launcher (main) forks one process per segment and releases them together. Each
+// segment reports when its philosophers have eaten their meals and keeps serving
+// requests until every segment has. It then sends its counters and latency samples
+// back to the launcher.
+//
+// Run: ./chandy_misra_distributed [--philosophers n] [--processes p] [--meals m]
+//                                  [--think-us t] [--no-batch]
+//   defaults: 5 philosophers, one process each, 2000 meals, 50 us of thinking after
+//   each meal (a meal lasts one pass of the segment's event loop). Without thinking,
+//   a segment on a busy CPU can eat all its meals before its neighbours even ask.
+// Reports meals/s, hungry -> eating latency per meal, and messages, packets, bytes and
+// syscalls per meal. The safety checker in each segment only sees that segment; a fork
+// arriving where one already is, or a request where the token already is, counts as a
+// protocol error.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../common/safety.h"
+
+using Clock = std::chrono::steady_clock;
+
+enum Token : uint8_t { REQUEST = 1, FORK = 2 };
+enum Side { LEFT = 0, RIGHT = 1 };   // fork i is philosopher i's left fork, fork i+1 its right
+
+// Launcher <-> segment control bytes.
+const char GO = 'G', DONE = 'D', STOP = 'S';
+
+long now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+struct Options {
+    int philosophers = 5;
+    int processes = 0;   // 0: one per philosopher
+    int meals = 2000;
+    int think_us = 50;
+    bool batch = true;
+};
+
+// Sent from each segment to the launcher at the end, followed by `meals` latency samples.
+struct Counters {
+    long meals = 0;
+    long messages = 0;          // tokens sent to another process
+    long local_tokens = 0;      // tokens handed over inside the segment
+    long packets = 0;           // write() calls on the links
+    long bytes = 0;
+    long syscalls = 0;          // link reads and writes, and poll()
+    long protocol_errors = 0;
+};
+
+bool write_all(int fd, const void *p, size_t len) {
+    const char *c = static_cast<const char *>(p);
+    while (len) {
+        ssize_t k = write(fd, c, len);
+        if (k <= 0) return false;
+        c += k;
+        len -= k;
+    }
+    return true;
+}
+
+bool read_all(int fd, void *p, size_t len) {
+    char *c = static_cast<char *>(p);
+    while (len) {
+        ssize_t k = read(fd, c, len);
+        if (k <= 0) return false;
+        c += k;
+        len -= k;
+    }
+    return true;
+}
+
+class Segment {
+    enum State { THINKING, HUNGRY, EATING };
+
+    struct Hand {
+        bool fork, dirty, token;
+    };
+
+    struct Philosopher {
+        State state = THINKING;
+        int meals = 0;
+        long hungry_since = 0;
+        Hand hand[2];
+    };
+
+    struct Link {
+        int fd = -1;
+        std::vector<uint8_t> out;
+    };
+
+    struct Delivery {
+        int to;
+        Side side;
+        Token token;
+    };
+
+    const Options &opt;
+    int n, lo, hi;                    // this segment hosts philosophers [lo, hi)
+    std::vector<Philosopher> ph;      // indexed by i - lo
+    Link link[2];                     // to the previous and the next segment; -1 if none
+    std::deque<Delivery> local;
+    std::vector<int> eating;
+    std::deque<std::pair<long, int>> thinking;   // (hungry again at, philosopher), in time order
+    int full = 0;
+    safety::Checker safe;
+
+public:
+    Counters c;
+    std::vector<long> latency;
+
+private:
+    Philosopher &at(int i) { return ph[i - lo]; }
+    bool hosted(int i) const { return i >= lo && i < hi; }
+
+    // Token from philosopher i's `side` to the neighbour on that side.
+    void send(int i, Side side, Token t) {
+        int to = side == LEFT ? (i + n - 1) % n : (i + 1) % n;
+        Side arrives = side == LEFT ? RIGHT : LEFT;
+        if (hosted(to)) {
+            c.local_tokens++;
+            local.push_back({to, arrives, t});
+            return;
+        }
+        Link &l = link[side];
+        l.out.push_back(t);
+        c.messages++;
+        if (!opt.batch) flush(l);
+    }
+
+    void flush(Link &l) {
+        if (l.out.empty()) return;
+        write_all(l.fd, l.out.data(), l.out.size());
+        c.packets++;
+        c.bytes += l.out.size();
+        c.syscalls++;
+        l.out.clear();
+    }
+
+    void give(int i, Side s) {
+        Hand &h = at(i).hand[s];
+        h.fork = false;
+        send(i, s, FORK);
+        if (at(i).state == HUNGRY && h.token) {
+            h.token = false;
+            send(i, s, REQUEST);
+        }
+    }
+
+    void try_eat(int i) {
+        Philosopher &p = at(i);
+        if (p.state != HUNGRY || !p.hand[LEFT].fork || !p.hand[RIGHT].fork) return;
+        p.state = EATING;
+        safe.eat(i);
+        latency.push_back(now_ns() - p.hungry_since);
+        eating.push_back(i);
+    }
+
+    void become_hungry(int i) {
+        Philosopher &p = at(i);
+        p.state = HUNGRY;
+        p.hungry_since = now_ns();
+        for (Side s : {LEFT, RIGHT}) {
+            Hand &h = p.hand[s];
+            if (!h.fork && h.token) {
+                h.token = false;
+                send(i, s, REQUEST);
+            }
+        }
+        try_eat(i);
+    }
+
+    void finish(int i) {
+        Philosopher &p = at(i);
+        safe.done(i);
+        p.state = THINKING;
+        p.hand[LEFT].dirty = p.hand[RIGHT].dirty = true;
+        c.meals++;
+        for (Side s : {LEFT, RIGHT})
+            if (p.hand[s].token) give(i, s);
+        if (++p.meals == opt.meals) full++;
+        else thinking.push_back({now_ns() + opt.think_us * 1000L, i});
+    }
+
+    void receive(int i, Side s, Token t) {
+        Philosopher &p = at(i);
+        Hand &h = p.hand[s];
+        if (t == REQUEST) {
+            if (h.token) c.protocol_errors++;
+            h.token = true;
+            if (h.fork && h.dirty && p.state != EATING) give(i, s);
+        } else {
+            if (h.fork) c.protocol_errors++;
+            h.fork = true;
+            h.dirty = false;
+            try_eat(i);
+        }
+    }
+
+    void deliver_local() {
+        while (!local.empty()) {
+            Delivery d = local.front();
+            local.pop_front();
+            receive(d.to, d.side, d.token);
+        }
+    }
+
+    // Everything waiting on link s; the fork on it belongs to philosopher `edge`.
+    void read_link(Side s) {
+        int edge = s == LEFT ? lo : hi - 1;
+        uint8_t buf[4096];
+        for (;;) {
+            ssize_t k = recv(link[s].fd, buf, sizeof buf, MSG_DONTWAIT);
+            c.syscalls++;
+            if (k <= 0) return;
+            for (ssize_t b = 0; b < k; b++) receive(edge, s, Token(buf[b]));
+        }
+    }
+
+public:
+    Segment(const Options &opt, int lo, int hi, int left_fd, int right_fd)
+        : opt(opt), n(opt.philosophers), lo(lo), hi(hi), ph(hi - lo),
+          safe("chandy_misra_distributed", opt.philosophers, safety::Threads::ONE) {
+        link[LEFT].fd = left_fd;
+        link[RIGHT].fd = right_fd;
+        for (int i = lo; i < hi; i++) {
+            // Fork k starts (dirty) with the lower-numbered of its two users.
+            at(i).hand[LEFT] = {i == 0, true, i != 0};
+            at(i).hand[RIGHT] = {i != n - 1, true, i == n - 1};
+        }
+    }
+
+    void run(int control) {
+        char cmd;
+        if (!read_all(control, &cmd, 1) || cmd != GO) return;
+        for (int i = lo; i < hi; i++) thinking.push_back({0, i});
+        bool reported = false, stopping = false;
+        std::vector<pollfd> fds = {{control, POLLIN, 0}};
+        for (Side s : {LEFT, RIGHT})
+            if (link[s].fd >= 0) fds.push_back({link[s].fd, POLLIN, 0});
+
+        while (!stopping) {
+            // A meal lasts until the next pass.
+            std::vector<int> done;
+            done.swap(eating);
+            for (int i : done) finish(i);
+            long t = now_ns();
+            while (!thinking.empty() && thinking.front().first <= t) {
+                int i = thinking.front().second;
+                thinking.pop_front();
+                become_hungry(i);
+            }
+            deliver_local();
+            for (Link &l : link)
+                if (l.fd >= 0) flush(l);
+            if (!reported && full == hi - lo) {
+                write_all(control, &DONE, 1);
+                reported = true;
+            }
+
+            // Sleep until a message, the next thinker gets hungry, or at once if someone eats.
+            timespec wait = {0, 0}, *timeout = &wait;
+            if (eating.empty()) {
+                if (thinking.empty()) timeout = nullptr;
+                else wait.tv_nsec = std::max(0L, thinking.front().first - now_ns());
+            }
+            c.syscalls++;
+            if (ppoll(fds.data(), fds.size(), timeout, nullptr) < 0) continue;
+            for (Side s : {LEFT, RIGHT})
+                if (link[s].fd >= 0) read_link(s);
+            deliver_local();
+            if (fds[0].revents & (POLLIN | POLLHUP)) stopping = !read_all(control, &cmd, 1) || cmd == STOP;
+        }
+        write_all(control, &c, sizeof c);
+        long k = latency.size();
+        write_all(control, &k, sizeof k);
+        write_all(control, latency.data(), k * sizeof(long));
+    }
+};
+
+long percentile(std::vector<long> &v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+void usage(const char *prog) {
+    std::cerr << "usage: " << prog << " [--philosophers n] [--processes p] [--meals m] [--think-us t]"
+              << " [--no-batch]\n";
+    std::exit(1);
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--no-batch") { opt.batch = false; continue; }
+        if (a + 1 >= argc) usage(argv[0]);
+        int val = std::atoi(argv[++a]);
+        if (arg == "--philosophers") opt.philosophers = val;
+        else if (arg == "--processes") opt.processes = val;
+        else if (arg == "--meals") opt.meals = val;
+        else if (arg == "--think-us") opt.think_us = val;
+        else usage(argv[0]);
+    }
+    if (opt.processes == 0) opt.processes = opt.philosophers;
+    const int n = opt.philosophers, P = opt.processes;
+    if (n < 2 || P < 1 || P > n || opt.meals < 1 || opt.think_us < 0 || opt.think_us >= 1000000) usage(argv[0]);
+
+    // Segment p hosts [first[p], first[p + 1]). Link p joins segment p to segment p + 1.
+    std::vector<int> first(P + 1);
+    for (int p = 0; p <= P; p++) first[p] = (int)((long)n * p / P);
+    std::vector<int> control(P), child_control(P);
+    std::vector<int> link_right(P, -1), link_left(P, -1);
+    for (int p = 0; p < P; p++) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+            std::perror("socketpair");
+            return 1;
+        }
+        control[p] = sv[0];
+        child_control[p] = sv[1];
+        if (P == 1) continue;
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) != 0) {
+            std::perror("socketpair");
+            return 1;
+        }
+        link_right[p] = sv[0];
+        link_left[(p + 1) % P] = sv[1];
+    }
+
+    std::cout << "Chandy-Misra across processes: " << n << " philosophers in " << P << " processes, "
+              << opt.meals << " meals each, " << (opt.batch ? "batched" : "unbatched") << " messages"
+              << std::endl;
+    std::vector<pid_t> pids;
+    for (int p = 0; p < P; p++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            for (int q = 0; q < P; q++) {
+                close(control[q]);
+                if (q == p) continue;
+                close(child_control[q]);
+                if (link_left[q] >= 0) close(link_left[q]);
+                if (link_right[q] >= 0) close(link_right[q]);
+            }
+            Segment seg(opt, first[p], first[p + 1], link_left[p], link_right[p]);
+            seg.run(child_control[p]);
+            _exit(0);
+        }
+        pids.push_back(pid);
+    }
+    for (int p = 0; p < P; p++) {
+        close(child_control[p]);
+        if (link_left[p] >= 0) close(link_left[p]);
+        if (link_right[p] >= 0) close(link_right[p]);
+    }
+
+    auto start = Clock::now();
+    for (int p = 0; p < P; p++) write_all(control[p], &GO, 1);
+    bool ok = true;
+    for (int p = 0; p < P; p++) {
+        char cmd = 0;
+        ok = read_all(control[p], &cmd, 1) && cmd == DONE && ok;
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+    Counters total;
+    std::vector<long> latency;
+    for (int p = 0; p < P; p++) {
+        write_all(control[p], &STOP, 1);
+        Counters c;
+        long k = 0;
+        if (!read_all(control[p], &c, sizeof c) || !read_all(control[p], &k, sizeof k)) {
+            ok = false;
+            continue;
+        }
+        std::vector<long> v(k);
+        ok = read_all(control[p], v.data(), k * sizeof(long)) && ok;
+        latency.insert(latency.end(), v.begin(), v.end());
+        total.meals += c.meals;
+        total.messages += c.messages;
+        total.local_tokens += c.local_tokens;
+        total.packets += c.packets;
+        total.bytes += c.bytes;
+        total.syscalls += c.syscalls;
+        total.protocol_errors += c.protocol_errors;
+    }
+    for (pid_t pid : pids) waitpid(pid, nullptr, 0);
+    if (!ok) {
+        std::cerr << "a segment did not report back\n";
+        return 1;
+    }
+
+    double m = total.meals;
+    std::cout << std::fixed << std::setprecision(0) << total.meals << " meals in " << std::setprecision(3) << secs
+              << " s (" << std::setprecision(0) << m / secs << " meals/s)\n"
+              << "hungry -> eating: p50 " << percentile(latency, 0.50) << " ns, p99 "
+              << percentile(latency, 0.99) << " ns\n"
+              << std::setprecision(2) << "per meal: " << total.messages / m << " messages, " << total.packets / m
+              << " packets, " << total.bytes / m << " bytes, " << total.syscalls / m << " syscalls, "
+              << total.local_tokens / m << " in-process tokens\n"
+              << "protocol errors: " << total.protocol_errors << "\n";
+    return 0;
+}
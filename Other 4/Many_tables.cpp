@@ -0,0 +1,241 @@
+// Dining Philosophers - many tables on a fixed pool of workers
+// Hosts thousands of independent tables, one per tenant, each of its own size and
+// strategy (any kernel from common/table_kernels.h). Tables are sharded across worker
+// threads, one worker per CPU, by longest-processing-time-first on table size. A shard
+// builds its own tables on its own (pinned) thread and nothing is shared between
+// shards except the stop flag, so workers never touch each other's cache lines.
+// Each worker steps its tables round-robin, one turn each, until time is up.
+//
+// Run: ./many_tables [--tables T] [--sizes lo-hi] [--strategy name|mixed] [--workers W]
+//                    [--seconds s] [--seed s] [--per-table] [--scaling]
+//   --strategy  waiter|hierarchy|asymmetric|chandy-misra|monitor|semaphore, or mixed
+//               (tables cycle through all of them; the default)
+//   --scaling   repeat the run at 1, 2, 4, ... workers up to the CPU count and report
+//               speedup and per-worker efficiency against one worker
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sched.h>
+#include "../common/table_kernels.h"
+#include "../common/placement.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct TableSpec {
+    int id;
+    kernels::Strategy strategy;
+    int size;
+};
+
+struct TableResult {
+    long turns = 0;
+    long meals = 0;
+};
+
+// One worker's tables and results; only that worker writes here until it is joined.
+struct alignas(64) Shard {
+    std::vector<TableSpec> specs;
+    std::vector<TableResult> results;
+    long philosopher_turns = 0;
+};
+
+struct Options {
+    int tables = 1000;
+    int min_size = 5, max_size = 50;
+    bool mixed = true;
+    kernels::Strategy strategy = kernels::Strategy::WAITER;
+    int workers = 0;   // 0: one per CPU
+    double seconds = 1;
+    unsigned seed = 1;
+    bool per_table = false;
+    bool scaling = false;
+};
+
+std::vector<TableSpec> make_specs(const Options &opt) {
+    std::mt19937 rng(opt.seed);
+    std::uniform_int_distribution<int> size(opt.min_size, opt.max_size);
+    std::vector<TableSpec> specs;
+    for (int t = 0; t < opt.tables; t++) {
+        kernels::Strategy s = opt.mixed ? kernels::ALL[t % std::size(kernels::ALL)] : opt.strategy;
+        specs.push_back({t, s, size(rng)});
+    }
+    return specs;
+}
+
+// Longest processing time first: biggest table to the least loaded shard.
+std::vector<Shard> shard(const std::vector<TableSpec> &specs, int workers) {
+    std::vector<TableSpec> order = specs;
+    std::stable_sort(order.begin(), order.end(),
+                     [](const TableSpec &a, const TableSpec &b) { return a.size > b.size; });
+    std::vector<Shard> shards(workers);
+    std::vector<long> load(workers, 0);
+    for (const TableSpec &t : order) {
+        int w = std::min_element(load.begin(), load.end()) - load.begin();
+        shards[w].specs.push_back(t);
+        load[w] += t.size;
+    }
+    return shards;
+}
+
+void worker(Shard &sh, int cpu, const std::atomic<bool> &stop) {
+    placement::pin_self(cpu);
+    std::vector<std::unique_ptr<kernels::Table>> tables;
+    for (const TableSpec &t : sh.specs)
+        tables.push_back(kernels::make_table(t.strategy, t.size));
+
+    while (!stop.load(std::memory_order_relaxed))
+        for (auto &t : tables) t->step();
+
+    sh.results.resize(tables.size());
+    for (size_t k = 0; k < tables.size(); k++) {
+        sh.results[k] = {tables[k]->turn(), tables[k]->meals()};
+        sh.philosopher_turns += tables[k]->turn() * tables[k]->size();
+    }
+}
+
+struct RunReport {
+    double seconds;
+    long meals = 0;
+    long philosopher_turns = 0;
+    double slowest_worker, fastest_worker;   // philosopher-turns/s
+};
+
+RunReport run(const Options &opt, const std::vector<TableSpec> &specs, int workers, bool print) {
+    std::vector<Shard> shards = shard(specs, workers);
+    std::vector<int> cpus = placement::plan(placement::Policy::COMPACT, workers);
+    std::atomic<bool> stop{false};
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int w = 0; w < workers; w++)
+        threads.emplace_back(worker, std::ref(shards[w]), cpus[w], std::cref(stop));
+    std::this_thread::sleep_for(std::chrono::duration<double>(opt.seconds));
+    stop = true;
+    for (auto &t : threads) t.join();
+
+    RunReport r;
+    r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    r.slowest_worker = 1e300;
+    r.fastest_worker = 0;
+    std::vector<double> rates;
+    std::vector<std::pair<const TableSpec *, std::pair<int, TableResult>>> rows;
+    for (int w = 0; w < workers; w++) {
+        const Shard &sh = shards[w];
+        double rate = sh.philosopher_turns / r.seconds;
+        r.slowest_worker = std::min(r.slowest_worker, rate);
+        r.fastest_worker = std::max(r.fastest_worker, rate);
+        r.philosopher_turns += sh.philosopher_turns;
+        for (size_t k = 0; k < sh.specs.size(); k++) {
+            r.meals += sh.results[k].meals;
+            rates.push_back(sh.results[k].meals / r.seconds);
+            rows.push_back({&sh.specs[k], {w, sh.results[k]}});
+        }
+    }
+    if (!print) return r;
+
+    if (opt.per_table) {
+        std::sort(rows.begin(), rows.end(), [](auto &a, auto &b) { return a.first->id < b.first->id; });
+        std::cout << " table  strategy       size  worker       turns       meals     meals/s\n";
+        for (auto &row : rows)
+            std::cout << std::setw(6) << row.first->id << "  " << std::left << std::setw(13)
+                      << kernels::strategy_name(row.first->strategy) << std::right << std::setw(6)
+                      << row.first->size << std::setw(8) << row.second.first << std::setw(12)
+                      << row.second.second.turns << std::setw(12) << row.second.second.meals
+                      << std::setw(12) << (long)(row.second.second.meals / r.seconds) << "\n";
+    }
+
+    std::sort(rates.begin(), rates.end());
+    auto pct = [&](double p) { return rates[std::min(rates.size() - 1, (size_t)(p * rates.size()))]; };
+    std::cout << std::fixed << std::setprecision(0)
+              << "Aggregate: " << r.meals / r.seconds << " meals/s, " << r.philosopher_turns / r.seconds
+              << " philosopher-turns/s over " << std::setprecision(2) << r.seconds << " s\n"
+              << std::setprecision(0) << "Per table meals/s: min " << rates.front() << ", p50 " << pct(0.5)
+              << ", p99 " << pct(0.99) << ", max " << rates.back() << "\n"
+              << "Per worker philosopher-turns/s: slowest " << r.slowest_worker << ", fastest "
+              << r.fastest_worker << "\n";
+
+    // Meals per turn depend only on strategy and size; this shows which kernels carry the load.
+    std::cout << "strategy       tables  meals/s\n";
+    for (kernels::Strategy s : kernels::ALL) {
+        long count = 0, meals = 0;
+        for (auto &row : rows)
+            if (row.first->strategy == s) {
+                count++;
+                meals += row.second.second.meals;
+            }
+        if (count)
+            std::cout << std::left << std::setw(13) << kernels::strategy_name(s) << std::right
+                      << std::setw(8) << count << std::setw(9) << (long)(meals / r.seconds) << "\n";
+    }
+    return r;
+}
+
+void usage(const char *prog) {
+    std::cerr << "usage: " << prog << " [--tables T] [--sizes lo-hi] [--strategy name|mixed]"
+              << " [--workers W] [--seconds s] [--seed s] [--per-table] [--scaling]\n";
+    std::exit(1);
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--per-table") { opt.per_table = true; continue; }
+        if (arg == "--scaling") { opt.scaling = true; continue; }
+        if (a + 1 >= argc) usage(argv[0]);
+        std::string val = argv[++a];
+        if (arg == "--tables") opt.tables = std::atoi(val.c_str());
+        else if (arg == "--sizes") {
+            if (std::sscanf(val.c_str(), "%d-%d", &opt.min_size, &opt.max_size) != 2) usage(argv[0]);
+        } else if (arg == "--strategy") {
+            opt.mixed = val == "mixed";
+            if (!opt.mixed && !kernels::parse_strategy(val, opt.strategy)) usage(argv[0]);
+        } else if (arg == "--workers") opt.workers = std::atoi(val.c_str());
+        else if (arg == "--seconds") opt.seconds = std::atof(val.c_str());
+        else if (arg == "--seed") {
+            char *end;
+            opt.seed = std::strtoul(val.c_str(), &end, 10);
+            if (val.empty() || *end) usage(argv[0]);
+        } else usage(argv[0]);
+    }
+    cpu_set_t allowed;
+    int cpus = sched_getaffinity(0, sizeof(allowed), &allowed) == 0 ? CPU_COUNT(&allowed) : 1;
+    if (opt.workers == 0) opt.workers = cpus;
+    if (opt.tables < 1 || opt.min_size < 2 || opt.max_size < opt.min_size || opt.workers < 1 || opt.seconds <= 0)
+        usage(argv[0]);
+
+    std::vector<TableSpec> specs = make_specs(opt);
+    std::cout << opt.tables << " tables of " << opt.min_size << "-" << opt.max_size << " philosophers ("
+              << (opt.mixed ? "mixed" : kernels::strategy_name(opt.strategy)) << ")\n";
+
+    if (!opt.scaling) {
+        std::cout << opt.workers << " workers, " << opt.seconds << " s\n";
+        run(opt, specs, opt.workers, true);
+        return 0;
+    }
+
+    std::vector<int> counts;
+    for (int w = 1; w < cpus; w *= 2) counts.push_back(w);
+    counts.push_back(cpus);
+    std::cout << "workers       meals/s  philosopher-turns/s  speedup  efficiency  slowest/fastest worker\n";
+    double base = 0;
+    for (int w : counts) {
+        RunReport r = run(opt, specs, w, false);
+        double rate = r.philosopher_turns / r.seconds;
+        if (w == 1) base = rate;
+        std::cout << std::setw(7) << w << std::fixed << std::setprecision(0) << std::setw(14)
+                  << r.meals / r.seconds << std::setw(21) << rate << std::setprecision(2)
+                  << std::setw(9) << rate / base << std::setw(12) << rate / base / w
+                  << std::setw(24) << r.slowest_worker / r.fastest_worker << "\n";
+    }
+    return 0;
+}
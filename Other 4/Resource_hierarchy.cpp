@@ -1,9 +1,16 @@
 // Dining Philosophers - Resource Hierarchy (Ordered Forks) Solution
 // Improved readable output
+// Run: ./resource_hierarchy [--philosophers n] [--turns t] [--stepping full|worklist] [--quiet]
+//                           [--checkpoint file] [--checkpoint-every t] [--resume file]
 
 #include <iostream>
 #include <vector>
 #include <string>
+#include "../common/stats_page.h"
+#include "../common/sim_options.h"
+#include "../common/worklist.h"
+#include "../common/safety.h"
+#include "../common/checkpoint.h"
 #include <algorithm> // For std::min and std::max
 
 const int NUM_PHILOSOPHERS = 5;
@@ -41,79 +48,163 @@ void print_forks(const std::vector<ForkState>& forks) {
 }
 
 // Main simulation function
-void run_simulation() {
+void run_simulation(const SimOptions &opt, const ckpt::Options &ck) {
+    const int n = opt.philosophers;
+
     // Initialize philosophers
-    std::vector<Philosopher> philosophers(NUM_PHILOSOPHERS);
-    for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
+    std::vector<Philosopher> philosophers(n);
+    for (int i = 0; i < n; ++i) {
         philosophers[i] = {i, PhilosopherState::THINKING, 0};
     }
 
     // Initialize forks
-    std::vector<ForkState> forks(NUM_PHILOSOPHERS, ForkState::FREE);
+    std::vector<ForkState> forks(n, ForkState::FREE);
 
-    int turn = 0;
+    stats::Page &st = stats::page();
+    Worklist work(n);
+    TransitionHash transitions;
+    long meals = 0;
+    long turn = 0;
     bool all_are_thinking = false;
-
-    // Simulation loop
-    while (!all_are_thinking) {
-        std::cout << "\n=== Turn " << turn << " ===\n";
-        all_are_thinking = true;
-
-        for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
-            // Fork indices (ordered to avoid deadlock)
-            int fork1_idx = std::min(i, (i + 1) % NUM_PHILOSOPHERS);
-            int fork2_idx = std::max(i, (i + 1) % NUM_PHILOSOPHERS);
-
-            switch (philosophers[i].state) {
-                case PhilosopherState::THINKING:
-                    philosophers[i].state = PhilosopherState::HUNGRY;
+    bool cut_off = false;
+
+    // Visit philosopher i. Returns true if it changed state, after queueing itself and
+    // both neighbours (the other users of its forks) for another look.
+    auto step = [&](int i) -> bool {
+        // Fork indices (ordered to avoid deadlock)
+        int fork1_idx = std::min(i, (i + 1) % n);
+        int fork2_idx = std::max(i, (i + 1) % n);
+
+        switch (philosophers[i].state) {
+            case PhilosopherState::THINKING:
+                philosophers[i].state = PhilosopherState::HUNGRY;
+                st.set_state(i, stats::HUNGRY);
+                if (!opt.quiet)
                     std::cout << "[Philosopher " << i << "] was THINKING -> now HUNGRY.\n";
-                    all_are_thinking = false;
-                    break;
-
-                case PhilosopherState::HUNGRY:
-                    if (forks[fork1_idx] == ForkState::FREE && forks[fork2_idx] == ForkState::FREE) {
-                        forks[fork1_idx] = ForkState::HELD;
-                        forks[fork2_idx] = ForkState::HELD;
-                        philosophers[i].state = PhilosopherState::EATING;
-                        philosophers[i].forks_held_count = 2;
+                break;
+
+            case PhilosopherState::HUNGRY:
+                if (forks[fork1_idx] == ForkState::FREE && forks[fork2_idx] == ForkState::FREE) {
+                    forks[fork1_idx] = ForkState::HELD;
+                    forks[fork2_idx] = ForkState::HELD;
+                    philosophers[i].state = PhilosopherState::EATING;
+                    safety::checker().eat(i, turn);
+                    philosophers[i].forks_held_count = 2;
+                    st.fork_held(fork1_idx);
+                    st.fork_held(fork2_idx);
+                    st.set_state(i, stats::EATING);
+                    if (!opt.quiet)
                         std::cout << "[Philosopher " << i << "] picked up forks "
                                   << fork1_idx << " & " << fork2_idx
                                   << " -> now EATING.\n";
-                        all_are_thinking = false;
-                    } else {
-                        std::cout << "[Philosopher " << i << "] is HUNGRY, waiting for forks "
-                                  << fork1_idx << " & " << fork2_idx << ".\n";
-                    }
                     break;
-
-                case PhilosopherState::EATING:
+                }
+                if (!opt.quiet)
+                    std::cout << "[Philosopher " << i << "] is HUNGRY, waiting for forks "
+                              << fork1_idx << " & " << fork2_idx << ".\n";
+                return false;
+
+            case PhilosopherState::EATING:
+                safety::checker().done(i, turn);
+                if (!opt.quiet)
                     std::cout << "[Philosopher " << i << "] finished EATING -> back to THINKING.\n";
-                    forks[fork1_idx] = ForkState::FREE;
-                    forks[fork2_idx] = ForkState::FREE;
-                    philosophers[i].forks_held_count = 0;
-                    philosophers[i].state = PhilosopherState::THINKING;
-                    all_are_thinking = false;
-                    break;
+                forks[fork1_idx] = ForkState::FREE;
+                forks[fork2_idx] = ForkState::FREE;
+                philosophers[i].forks_held_count = 0;
+                philosophers[i].state = PhilosopherState::THINKING;
+                st.meal(i);
+                st.set_state(i, stats::THINKING);
+                meals++;
+                break;
+        }
+        transitions.add(turn, i, (int)philosophers[i].state);
+        work.mark(i, i);
+        work.mark((i + n - 1) % n, i);
+        work.mark((i + 1) % n, i);
+        return true;
+    };
+
+    // Checkpoint: philosopher and fork states and what the loop carries between turns.
+    auto save = [&](ckpt::Writer &w) {
+        w.each<uint8_t>(n, [&](int i) { return (uint8_t)philosophers[i].state; });
+        w.each<uint8_t>(n, [&](int f) { return (uint8_t)forks[f]; });
+        w.put(meals);
+        work.save(w);
+        transitions.save(w);
+    };
+    if (!ck.resume.empty()) {
+        ckpt::Image image(ck.resume, "resource_hierarchy", n);
+        ckpt::Reader r = image.reader();
+        turn = image.turn();
+        r.each<uint8_t>(n, [&](int i, uint8_t v) {
+            philosophers[i].state = PhilosopherState(v);
+            philosophers[i].forks_held_count = philosophers[i].state == PhilosopherState::EATING ? 2 : 0;
+            st.set_state(i, philosophers[i].state == PhilosopherState::EATING   ? stats::EATING
+                            : philosophers[i].state == PhilosopherState::HUNGRY ? stats::HUNGRY
+                                                                                : stats::THINKING);
+            if (philosophers[i].state == PhilosopherState::EATING) safety::checker().eat(i, turn - 1);
+        });
+        r.each<uint8_t>(n, [&](int f, uint8_t v) { forks[f] = ForkState(v); });
+        meals = r.get<long>();
+        work.load(r);
+        transitions.load(r);
+    }
+    ckpt::Saver saver(ck, "resource_hierarchy", n);
+
+    // Simulation loop
+    while (!all_are_thinking) {
+        st.set_turn(turn);
+        if (!opt.quiet)
+            std::cout << "\n=== Turn " << turn << " ===\n";
+        all_are_thinking = true;
+        work.begin_turn(turn);
+
+        if (opt.worklist && opt.quiet) {
+            int i;
+            while (work.pop(i))
+                if (step(i)) all_are_thinking = false;
+        } else {
+            for (int i = 0; i < n; ++i) {
+                if (!opt.worklist || work.queued(i)) {
+                    if (step(i)) all_are_thinking = false;
+                } else {
+                    // Not queued: still HUNGRY and neither fork changed since last turn.
+                    std::cout << "[Philosopher " << i << "] is HUNGRY, waiting for forks "
+                              << std::min(i, (i + 1) % n) << " & " << std::max(i, (i + 1) % n) << ".\n";
+                }
             }
         }
 
         // Show fork ownership at end of turn
-        print_forks(forks);
+        if (!opt.quiet)
+            print_forks(forks);
 
         turn++;
 
-        // Stop after 20 turns (safety cutoff)
-        if (turn > 20) {
-            std::cout << "\n=== Simulation ended after 20 turns. ===\n";
-            return;
+        // Stop after the turn limit (safety cutoff)
+        if (turn > opt.max_turns) {
+            std::cout << "\n=== Simulation ended after " << opt.max_turns << " turns. ===\n";
+            cut_off = true;
+            break;
         }
+        if (!all_are_thinking) saver.tick(turn, save);
     }
 
-    std::cout << "\n=== Simulation ended as all philosophers are THINKING. ===\n";
+    if (!cut_off)
+        std::cout << "\n=== Simulation ended as all philosophers are THINKING. ===\n";
+    if (opt.quiet)
+        std::cout << "Turns: " << turn << ", meals: " << meals << ", transition hash: "
+                  << std::hex << transitions.value() << std::dec << "\n";
 }
 
-int main() {
-    run_simulation();
+// Run with DP_STATS=1 to publish live counters (see Tools/stats_watch.cpp).
+int main(int argc, char **argv) {
+    ckpt::Options ck;
+    SimOptions opt = parse_sim_options(argc, argv, NUM_PHILOSOPHERS, 20,
+        [&](const std::string &flag, const std::string &value) { return ckpt::parse_option(flag, value, ck); },
+        ckpt::USAGE);
+    stats::page().open("resource_hierarchy", opt.philosophers);
+    safety::checker().open("resource_hierarchy", opt.philosophers, safety::Threads::ONE);
+    run_simulation(opt, ck);
     return 0;
 }
@@ -1,9 +1,38 @@
 // Dining Philosophers - Waiter (Arbitrator) Solution
 // Improved readable output in single-threaded simulation
+// Run: ./waiter [--philosophers n] [--turns t] [--stepping full|worklist] [--quiet]
+//      ./waiter --policy index|sjf|mwis|fair [--service uniform|mixed] [--seed s] [...]
+//      either with [--checkpoint file] [--checkpoint-every t] [--resume file]
+//
+// With --policy (or --service) meals take several turns and the waiter hands out forks
+// once per turn, after the finished eaters have put theirs down, choosing among the
+// hungry philosophers whose forks are both free:
+//   index  lowest index first (what the plain simulation amounts to)
+//   sjf    shortest expected meal first, longest-waiting first among equals
+//   mwis   a maximum-weight independent set of the candidates, weighing each by its
+//          meals per turn (1 / expected meal length); exact, by dynamic programming
+//          over the ring
+//   fair   weighted fair share: least table time received per unit of class weight
+// Meal lengths are drawn per meal, uniformly around the philosopher's class mean (see
+// common/service.h). The run lasts --turns turns and ends with throughput and
+// fairness figures per service class. --stepping does not apply to these runs.
+// Their checkpoints carry the meal-length generator, so a resumed run draws the same
+// meals; policy and service mix are part of the checkpoint's name and must match.
 
 #include <iostream>
 #include <vector>
 #include <string>
+#include <random>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include "../common/stats_page.h"
+#include "../common/sim_options.h"
+#include "../common/worklist.h"
+#include "../common/safety.h"
+#include "../common/checkpoint.h"
+#include "../common/service.h"
 
 const int NUM_PHILOSOPHERS = 5;
 
@@ -38,71 +67,417 @@ void print_forks(const std::vector<ForkState>& forks) {
 }
 
 // Simulation
-void run_simulation() {
-    std::vector<Philosopher> philosophers(NUM_PHILOSOPHERS);
-    for (int i = 0; i < NUM_PHILOSOPHERS; i++) {
+void run_simulation(const SimOptions &opt, const ckpt::Options &ck) {
+    const int n = opt.philosophers;
+    std::vector<Philosopher> philosophers(n);
+    for (int i = 0; i < n; i++) {
         philosophers[i] = {i, PhilosopherState::THINKING};
     }
 
-    std::vector<ForkState> forks(NUM_PHILOSOPHERS, ForkState::FREE);
+    std::vector<ForkState> forks(n, ForkState::FREE);
 
-    int turn = 0;
+    stats::Page &st = stats::page();
+    Worklist work(n);
+    TransitionHash transitions;
+    long meals = 0;
+    long turn = 0;
     bool all_are_thinking = false;
+    bool cut_off = false;
 
-    while (!all_are_thinking) {
-        std::cout << "\n=== Turn " << turn << " ===\n";
-        all_are_thinking = true;
+    // Visit philosopher i. Returns true if it changed state, after queueing itself and
+    // both neighbours (the other users of its forks) for another look.
+    auto step = [&](int i) -> bool {
+        int left = i;
+        int right = (i + 1) % n;
 
-        for (int i = 0; i < NUM_PHILOSOPHERS; i++) {
-            int left = i;
-            int right = (i + 1) % NUM_PHILOSOPHERS;
-
-            switch (philosophers[i].state) {
-                case PhilosopherState::THINKING:
-                    philosophers[i].state = PhilosopherState::HUNGRY;
+        switch (philosophers[i].state) {
+            case PhilosopherState::THINKING:
+                philosophers[i].state = PhilosopherState::HUNGRY;
+                st.set_state(i, stats::HUNGRY);
+                if (!opt.quiet)
                     std::cout << "[Philosopher " << i << "] was THINKING -> now HUNGRY.\n";
-                    all_are_thinking = false;
-                    break;
+                break;
 
-                case PhilosopherState::HUNGRY:
-                    // Waiter ensures safety: only lets philosopher eat if both forks free
-                    if (forks[left] == ForkState::FREE && forks[right] == ForkState::FREE) {
-                        forks[left] = ForkState::HELD;
-                        forks[right] = ForkState::HELD;
-                        philosophers[i].state = PhilosopherState::EATING;
+            case PhilosopherState::HUNGRY:
+                // Waiter ensures safety: only lets philosopher eat if both forks free
+                if (forks[left] == ForkState::FREE && forks[right] == ForkState::FREE) {
+                    forks[left] = ForkState::HELD;
+                    forks[right] = ForkState::HELD;
+                    philosophers[i].state = PhilosopherState::EATING;
+                    safety::checker().eat(i, turn);
+                    st.fork_held(left);
+                    st.fork_held(right);
+                    st.set_state(i, stats::EATING);
+                    if (!opt.quiet)
                         std::cout << "[Philosopher " << i << "] got permission, picked up forks "
                                   << left << " & " << right << " -> now EATING.\n";
-                        all_are_thinking = false;
-                    } else {
-                        std::cout << "[Philosopher " << i << "] is HUNGRY, waiting for forks "
-                                  << left << " & " << right << ".\n";
-                    }
                     break;
+                }
+                if (!opt.quiet)
+                    std::cout << "[Philosopher " << i << "] is HUNGRY, waiting for forks "
+                              << left << " & " << right << ".\n";
+                return false;
 
-                case PhilosopherState::EATING:
+            case PhilosopherState::EATING:
+                safety::checker().done(i, turn);
+                if (!opt.quiet)
                     std::cout << "[Philosopher " << i << "] finished EATING -> back to THINKING.\n";
-                    forks[left] = ForkState::FREE;
-                    forks[right] = ForkState::FREE;
-                    philosophers[i].state = PhilosopherState::THINKING;
-                    all_are_thinking = false;
-                    break;
+                forks[left] = ForkState::FREE;
+                forks[right] = ForkState::FREE;
+                philosophers[i].state = PhilosopherState::THINKING;
+                st.meal(i);
+                st.set_state(i, stats::THINKING);
+                meals++;
+                break;
+        }
+        transitions.add(turn, i, (int)philosophers[i].state);
+        work.mark(i, i);
+        work.mark((i + n - 1) % n, i);
+        work.mark((i + 1) % n, i);
+        return true;
+    };
+
+    // Checkpoint: philosopher and fork states and what the loop carries between turns.
+    auto save = [&](ckpt::Writer &w) {
+        w.each<uint8_t>(n, [&](int i) { return (uint8_t)philosophers[i].state; });
+        w.each<uint8_t>(n, [&](int f) { return (uint8_t)forks[f]; });
+        w.put(meals);
+        work.save(w);
+        transitions.save(w);
+    };
+    if (!ck.resume.empty()) {
+        ckpt::Image image(ck.resume, "waiter", n);
+        ckpt::Reader r = image.reader();
+        turn = image.turn();
+        r.each<uint8_t>(n, [&](int i, uint8_t v) {
+            philosophers[i].state = PhilosopherState(v);
+            st.set_state(i, philosophers[i].state == PhilosopherState::EATING   ? stats::EATING
+                            : philosophers[i].state == PhilosopherState::HUNGRY ? stats::HUNGRY
+                                                                                : stats::THINKING);
+            if (philosophers[i].state == PhilosopherState::EATING) safety::checker().eat(i, turn - 1);
+        });
+        r.each<uint8_t>(n, [&](int f, uint8_t v) { forks[f] = ForkState(v); });
+        meals = r.get<long>();
+        work.load(r);
+        transitions.load(r);
+    }
+    ckpt::Saver saver(ck, "waiter", n);
+
+    while (!all_are_thinking) {
+        st.set_turn(turn);
+        if (!opt.quiet)
+            std::cout << "\n=== Turn " << turn << " ===\n";
+        all_are_thinking = true;
+        work.begin_turn(turn);
+
+        if (opt.worklist && opt.quiet) {
+            int i;
+            while (work.pop(i))
+                if (step(i)) all_are_thinking = false;
+        } else {
+            for (int i = 0; i < n; i++) {
+                if (!opt.worklist || work.queued(i)) {
+                    if (step(i)) all_are_thinking = false;
+                } else {
+                    // Not queued: still HUNGRY and neither fork changed since last turn.
+                    std::cout << "[Philosopher " << i << "] is HUNGRY, waiting for forks "
+                              << i << " & " << (i + 1) % n << ".\n";
+                }
             }
         }
 
         // Show fork ownership at end of turn
-        print_forks(forks);
+        if (!opt.quiet)
+            print_forks(forks);
 
         turn++;
-        if (turn > 20) {
-            std::cout << "\n=== Simulation ended after 20 turns. ===\n";
-            return;
+        if (turn > opt.max_turns) {
+            std::cout << "\n=== Simulation ended after " << opt.max_turns << " turns. ===\n";
+            cut_off = true;
+            break;
+        }
+        if (!all_are_thinking) saver.tick(turn, save);
+    }
+
+    if (!cut_off)
+        std::cout << "\n=== Simulation ended as all philosophers are THINKING. ===\n";
+    if (opt.quiet)
+        std::cout << "Turns: " << turn << ", meals: " << meals << ", transition hash: "
+                  << std::hex << transitions.value() << std::dec << "\n";
+}
+
+enum class Policy { INDEX, SJF, MWIS, FAIR };
+
+bool parse_policy(const std::string &s, Policy &out) {
+    if (s == "index")      out = Policy::INDEX;
+    else if (s == "sjf")   out = Policy::SJF;
+    else if (s == "mwis")  out = Policy::MWIS;
+    else if (s == "fair")  out = Policy::FAIR;
+    else return false;
+    return true;
+}
+
+const char *policy_name(Policy p) {
+    switch (p) {
+        case Policy::INDEX: return "index";
+        case Policy::SJF:   return "sjf";
+        case Policy::MWIS:  return "mwis";
+        case Policy::FAIR:  return "fair";
+    }
+    return "";
+}
+
+struct Schedule {
+    Policy policy = Policy::INDEX;
+    service::Mix mix = service::Mix::UNIFORM;
+    unsigned seed = 1;
+};
+
+// Maximum-weight set of candidates with no two adjacent on the ring. Non-candidates
+// cannot be chosen, so starting the scan just after one turns the ring into a path;
+// if everyone is a candidate, the better of "0 left out" and "0 taken, 1 and n-1 left
+// out" wins.
+std::vector<int> max_weight_independent_set(const std::vector<bool> &candidate,
+                                            const std::vector<double> &weight) {
+    const int n = candidate.size();
+
+    // Best set along positions start, start+1, ... (len of them, wrapping).
+    auto path = [&](int start, int len, std::vector<int> &out) {
+        std::vector<double> best(len + 1, 0);
+        for (int k = 0; k < len; k++) {
+            int i = (start + k) % n;
+            double take = candidate[i] ? weight[i] + (k ? best[k - 1] : 0) : -1;
+            best[k + 1] = std::max(best[k], take);
+        }
+        for (int k = len; k > 0;) {
+            int i = (start + k - 1) % n;
+            if (best[k] != best[k - 1] && candidate[i]) {
+                out.push_back(i);
+                k -= 2;
+            } else {
+                k--;
+            }
+        }
+        return best[len];
+    };
+
+    std::vector<int> chosen;
+    int gap = std::find(candidate.begin(), candidate.end(), false) - candidate.begin();
+    if (gap < n) {
+        path((gap + 1) % n, n, chosen);
+        return chosen;
+    }
+    std::vector<int> without_0, with_0 = {0};
+    double a = path(1, n - 1, without_0);
+    double b = weight[0] + (n > 3 ? path(2, n - 3, with_0) : 0);
+    return b > a ? with_0 : without_0;
+}
+
+// Multi-turn meals with a waiter that grants once per turn under `sched.policy`.
+void run_scheduled(const SimOptions &opt, const Schedule &sched, const ckpt::Options &ck) {
+    const int n = opt.philosophers;
+    std::vector<PhilosopherState> state(n, PhilosopherState::THINKING);
+    std::vector<ForkState> forks(n, ForkState::FREE);
+    std::vector<const service::Class *> cls(n);
+    for (int i = 0; i < n; i++) cls[i] = &service::class_of(sched.mix, i);
+
+    std::vector<long> remaining(n, 0), hungry_since(n, 0), meals(n, 0), eat_turns(n, 0),
+        longest_wait(n, 0), total_wait(n, 0);
+    std::mt19937 rng(sched.seed);
+    stats::Page &st = stats::page();
+    long eater_turns = 0;
+
+    auto meal_length = [&](int i) {
+        int mean = cls[i]->scale;
+        return std::uniform_int_distribution<long>(1, 2 * mean - 1)(rng);
+    };
+
+    long turn = 0;
+
+    // Checkpoint: states, forks, the per-philosopher counters behind the closing
+    // figures, and the generator's state in its standard text form.
+    const std::string program = std::string("waiter/") + policy_name(sched.policy) + "/" + service::mix_name(sched.mix);
+    auto save = [&](ckpt::Writer &w) {
+        w.each<uint8_t>(n, [&](int i) { return (uint8_t)state[i]; });
+        w.each<uint8_t>(n, [&](int f) { return (uint8_t)forks[f]; });
+        for (const std::vector<long> *v : {&remaining, &hungry_since, &meals, &eat_turns, &longest_wait, &total_wait})
+            w.array(*v);
+        w.put(eater_turns);
+        std::ostringstream gen;
+        gen << rng;
+        w.text(gen.str());
+    };
+    if (!ck.resume.empty()) {
+        ckpt::Image image(ck.resume, program.c_str(), n);
+        ckpt::Reader r = image.reader();
+        turn = image.turn();
+        r.each<uint8_t>(n, [&](int i, uint8_t v) {
+            state[i] = PhilosopherState(v);
+            st.set_state(i, state[i] == PhilosopherState::EATING   ? stats::EATING
+                            : state[i] == PhilosopherState::HUNGRY ? stats::HUNGRY
+                                                                   : stats::THINKING);
+            if (state[i] == PhilosopherState::EATING) safety::checker().eat(i, turn - 1);
+        });
+        r.each<uint8_t>(n, [&](int f, uint8_t v) { forks[f] = ForkState(v); });
+        for (std::vector<long> *v : {&remaining, &hungry_since, &meals, &eat_turns, &longest_wait, &total_wait})
+            r.array(*v);
+        eater_turns = r.get<long>();
+        std::istringstream gen(r.text());
+        gen >> rng;
+    }
+    ckpt::Saver saver(ck, program.c_str(), n);
+
+    for (; turn < opt.max_turns; turn++) {
+        st.set_turn(turn);
+        if (!opt.quiet)
+            std::cout << "\n=== Turn " << turn << " ===\n";
+
+        // Eaters count down; whoever is done puts the forks back. Thinkers get hungry.
+        for (int i = 0; i < n; i++) {
+            if (state[i] == PhilosopherState::EATING) {
+                eat_turns[i]++;
+                if (--remaining[i] > 0) continue;
+                safety::checker().done(i, turn);
+                forks[i] = ForkState::FREE;
+                forks[(i + 1) % n] = ForkState::FREE;
+                state[i] = PhilosopherState::THINKING;
+                meals[i]++;
+                st.meal(i);
+                st.set_state(i, stats::THINKING);
+                if (!opt.quiet)
+                    std::cout << "[Philosopher " << i << "] finished EATING -> back to THINKING.\n";
+            } else if (state[i] == PhilosopherState::THINKING) {
+                state[i] = PhilosopherState::HUNGRY;
+                hungry_since[i] = turn;
+                st.set_state(i, stats::HUNGRY);
+                if (!opt.quiet)
+                    std::cout << "[Philosopher " << i << "] was THINKING -> now HUNGRY.\n";
+            }
+        }
+
+        // The waiter's choice among hungry philosophers whose forks are both free.
+        std::vector<bool> candidate(n);
+        std::vector<int> order;
+        for (int i = 0; i < n; i++) {
+            candidate[i] = state[i] == PhilosopherState::HUNGRY && forks[i] == ForkState::FREE &&
+                           forks[(i + 1) % n] == ForkState::FREE;
+            if (candidate[i]) order.push_back(i);
+        }
+        if (sched.policy == Policy::MWIS) {
+            std::vector<double> weight(n);
+            for (int i = 0; i < n; i++) weight[i] = 1.0 / cls[i]->scale;
+            order = max_weight_independent_set(candidate, weight);
+            std::sort(order.begin(), order.end());
+        } else if (sched.policy == Policy::SJF) {
+            std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+                if (cls[a]->scale != cls[b]->scale) return cls[a]->scale < cls[b]->scale;
+                return hungry_since[a] < hungry_since[b];
+            });
+        } else if (sched.policy == Policy::FAIR) {
+            std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+                return eat_turns[a] * cls[b]->weight < eat_turns[b] * cls[a]->weight;
+            });
+        }
+        for (int i : order) {
+            int left = i, right = (i + 1) % n;
+            if (forks[left] != ForkState::FREE || forks[right] != ForkState::FREE) continue;
+            forks[left] = ForkState::HELD;
+            forks[right] = ForkState::HELD;
+            state[i] = PhilosopherState::EATING;
+            safety::checker().eat(i, turn);
+            remaining[i] = meal_length(i);
+            long waited = turn - hungry_since[i];
+            total_wait[i] += waited;
+            longest_wait[i] = std::max(longest_wait[i], waited);
+            st.fork_held(left);
+            st.fork_held(right);
+            st.set_state(i, stats::EATING);
+            if (!opt.quiet)
+                std::cout << "[Philosopher " << i << "] got permission, picked up forks " << left
+                          << " & " << right << " -> now EATING for " << remaining[i] << " turns.\n";
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (state[i] == PhilosopherState::EATING) eater_turns++;
+            if (state[i] == PhilosopherState::HUNGRY && !opt.quiet)
+                std::cout << "[Philosopher " << i << "] is HUNGRY, waiting for forks "
+                          << i << " & " << (i + 1) % n << ".\n";
         }
+        if (!opt.quiet)
+            print_forks(forks);
+        saver.tick(turn + 1, save);
+    }
+
+    // Philosophers still hungry at the cutoff count their wait so far.
+    for (int i = 0; i < n; i++)
+        if (state[i] == PhilosopherState::HUNGRY)
+            longest_wait[i] = std::max(longest_wait[i], turn - hungry_since[i]);
+
+    long all_meals = 0, starved = 0, worst_wait = 0;
+    std::vector<double> meal_share(n), time_share(n);
+    for (int i = 0; i < n; i++) {
+        all_meals += meals[i];
+        starved += meals[i] == 0;
+        worst_wait = std::max(worst_wait, longest_wait[i]);
+        meal_share[i] = meals[i];
+        time_share[i] = (double)eat_turns[i] / cls[i]->weight;
     }
 
-    std::cout << "\n=== Simulation ended as all philosophers are THINKING. ===\n";
+    std::cout << "\n=== Simulation ended after " << turn << " turns. ===\n"
+              << "Policy: " << policy_name(sched.policy) << ", service: " << service::mix_name(sched.mix)
+              << ", seed: " << sched.seed << "\n"
+              << std::fixed << std::setprecision(3)
+              << "Meals: " << all_meals << " (" << (turn ? (double)all_meals / turn : 0)
+              << " per turn), mean eaters per turn: " << (turn ? (double)eater_turns / turn : 0) << "\n"
+              << "Fairness: Jain(meals) " << service::jain(meal_share)
+              << ", Jain(table time / weight) " << service::jain(time_share)
+              << ", starved " << starved << ", longest wait " << worst_wait << " turns\n"
+              << "class   philosophers   meals/philosopher   table time %   mean wait   longest wait\n";
+    for (const service::Class *c : {&service::UNIT, &service::SHORT, &service::MEDIUM, &service::LONG}) {
+        long members = 0, m = 0, eat = 0, waits = 0, wait_sum = 0, longest = 0;
+        for (int i = 0; i < n; i++) {
+            if (cls[i] != c) continue;
+            members++;
+            m += meals[i];
+            eat += eat_turns[i];
+            waits += meals[i] + (state[i] != PhilosopherState::THINKING);
+            wait_sum += total_wait[i];
+            longest = std::max(longest, longest_wait[i]);
+        }
+        if (!members) continue;
+        std::cout << std::left << std::setw(8) << c->name << std::right << std::setw(12) << members
+                  << std::setprecision(2) << std::setw(20) << (double)m / members
+                  << std::setw(15) << (eater_turns ? 100.0 * eat / eater_turns : 0)
+                  << std::setw(12) << (waits ? (double)wait_sum / waits : 0)
+                  << std::setw(15) << longest << "\n";
+    }
 }
 
-int main() {
-    run_simulation();
+// Run with DP_STATS=1 to publish live counters (see Tools/stats_watch.cpp).
+int main(int argc, char **argv) {
+    Schedule sched;
+    bool scheduled = false;
+    ckpt::Options ck;
+    const std::string usage = " [--policy index|sjf|mwis|fair] [--service uniform|mixed] [--seed s]" + std::string(ckpt::USAGE);
+    SimOptions opt = parse_sim_options(
+        argc, argv, NUM_PHILOSOPHERS, 20,
+        [&](const std::string &flag, const std::string &value) {
+            if (ckpt::parse_option(flag, value, ck)) return true;
+            if (flag == "--policy") return scheduled = parse_policy(value, sched.policy);
+            if (flag == "--service") return scheduled = service::parse_mix(value, sched.mix);
+            if (flag == "--seed") {
+                char *end;
+                sched.seed = std::strtoul(value.c_str(), &end, 10);
+                return scheduled = !value.empty() && !*end;
+            }
+            return false;
+        },
+        usage.c_str());
+    stats::page().open("waiter", opt.philosophers);
+    safety::checker().open("waiter", opt.philosophers, safety::Threads::ONE);
+    if (scheduled)
+        run_scheduled(opt, sched, ck);
+    else
+        run_simulation(opt, ck);
     return 0;
 }
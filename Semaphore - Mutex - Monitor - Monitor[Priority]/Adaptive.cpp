@@ -0,0 +1,345 @@
+// adaptive.cpp
+// Dining Philosophers with an adaptive fork manager
+// One pickup()/putdown() interface over three of the strategies in this directory:
+//   hierarchy   ordered fork mutexes (Mutex.cpp)
+//   arbitrator  room semaphore of n - 1 plus a semaphore per fork (Semaphore.cpp)
+//   monitor     Monitor::pickup/putdown (Monitor.cpp)
+// Every pickup records whether a neighbour was already hungry or eating (contention),
+// how many philosophers were already waiting (queue depth), and every meal how long
+// the forks were held. A controller thread looks at these once per window and moves the
+// table to the mode its rules pick. A switch closes the gate to new pickups, waits until
+// every philosopher that entered under the old mode has put its forks down (quiescence),
+// then reopens the gate under the new mode, so no two modes ever hold forks at once.
+// Each switch is logged with the numbers that caused it.
+//
+// Compile: g++ -std=c++17 -O2 Adaptive.cpp -pthread -o adaptive
+// Run:     ./adaptive                                    (demo: load rises, then falls)
+//          ./adaptive --bench [philosophers] [ms per load]
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <functional>
+#include <cstdlib>
+#include "../common/primitives.h"
+#include "../common/safety.h"
+using namespace std;
+using Clock = chrono::steady_clock;
+
+enum Mode { HIERARCHY, ARBITRATOR, MONITOR, SWITCHING };
+
+const char *mode_name(int m) {
+    switch (m) {
+        case HIERARCHY:  return "hierarchy";
+        case ARBITRATOR: return "arbitrator";
+        case MONITOR:    return "monitor";
+    }
+    return "switching";
+}
+
+// Semaphore.cpp's waiter solution, sized at runtime.
+class Arbitrator {
+    int n;
+    dp::Semaphore room;
+    vector<unique_ptr<dp::Semaphore>> forks;
+
+public:
+    explicit Arbitrator(int n) : n(n), room(n - 1) {
+        for (int i = 0; i < n; i++) forks.emplace_back(new dp::Semaphore(1));
+    }
+    void pickup(int i) {
+        room.wait();
+        forks[i]->wait();
+        forks[(i + 1) % n]->wait();
+    }
+    void putdown(int i) {
+        forks[(i + 1) % n]->signal();
+        forks[i]->signal();
+        room.signal();
+    }
+};
+
+// What the controller sees for one window.
+struct Sample {
+    long pickups;
+    double contention;    // share of pickups that found a neighbour hungry or eating
+    double queue;         // philosophers already waiting, averaged over pickups
+    double hold_us;       // mean time between pickup returning and putdown
+};
+
+class AdaptiveForks {
+    int n;
+    dp::OrderedForks hierarchy;
+    Arbitrator arbitrator;
+    dp::Monitor monitor;
+
+    atomic<int> mode;
+    atomic<int> inflight{0};          // philosophers between entering pickup and leaving putdown
+    mutex gate_m;
+    condition_variable gate_cv;
+
+    vector<int> held_mode;            // mode philosopher i entered under (its own slot)
+    vector<Clock::time_point> eat_start;
+    unique_ptr<atomic<int>[]> busy;   // 1 while hungry or eating
+    atomic<int> waiting{0};
+
+    atomic<long> pickups{0}, contended{0}, queue_sum{0}, hold_ns{0};
+    safety::Checker safe;             // across modes too: a bad switch would show here
+
+    void enter(int i) {
+        for (;;) {
+            int m = mode.load();
+            if (m != SWITCHING) {
+                inflight.fetch_add(1);
+                if (mode.load() == m) {
+                    held_mode[i] = m;
+                    return;
+                }
+                leave();   // a switch started in between
+            }
+            unique_lock<mutex> lk(gate_m);
+            gate_cv.wait(lk, [this] { return mode.load() != SWITCHING; });
+        }
+    }
+
+    void leave() {
+        if (inflight.fetch_sub(1) == 1 && mode.load() == SWITCHING) {
+            lock_guard<mutex> lk(gate_m);
+            gate_cv.notify_all();
+        }
+    }
+
+public:
+    AdaptiveForks(int n, Mode initial)
+        : n(n), hierarchy(n), arbitrator(n), monitor(n), mode(initial),
+          held_mode(n), eat_start(n), busy(new atomic<int>[n]), safe("adaptive", n) {
+        for (int i = 0; i < n; i++) busy[i] = 0;
+    }
+
+    void pickup(int i) {
+        enter(i);
+        busy[i] = 1;
+        if (busy[(i + n - 1) % n].load(memory_order_relaxed) || busy[(i + 1) % n].load(memory_order_relaxed))
+            contended.fetch_add(1, memory_order_relaxed);
+        queue_sum.fetch_add(waiting.fetch_add(1, memory_order_relaxed), memory_order_relaxed);
+        pickups.fetch_add(1, memory_order_relaxed);
+
+        switch (held_mode[i]) {
+            case HIERARCHY:  hierarchy.pickup(i); break;
+            case ARBITRATOR: arbitrator.pickup(i); break;
+            case MONITOR:    monitor.pickup(i); break;
+        }
+        waiting.fetch_sub(1, memory_order_relaxed);
+        safe.eat(i);
+        eat_start[i] = Clock::now();
+    }
+
+    void putdown(int i) {
+        hold_ns.fetch_add(chrono::duration_cast<chrono::nanoseconds>(Clock::now() - eat_start[i]).count(),
+                          memory_order_relaxed);
+        safe.done(i);
+        switch (held_mode[i]) {
+            case HIERARCHY:  hierarchy.putdown(i); break;
+            case ARBITRATOR: arbitrator.putdown(i); break;
+            case MONITOR:    monitor.putdown(i); break;
+        }
+        busy[i] = 0;
+        leave();
+    }
+
+    // Quiescent handoff; returns how long the table was closed.
+    chrono::nanoseconds switch_to(Mode next) {
+        auto start = Clock::now();
+        mode.store(SWITCHING);
+        {
+            unique_lock<mutex> lk(gate_m);
+            gate_cv.wait(lk, [this] { return inflight.load() == 0; });
+            mode.store(next);
+        }
+        gate_cv.notify_all();
+        return Clock::now() - start;
+    }
+
+    // Reads and clears the counters for the window that just ended.
+    Sample sample() {
+        long p = pickups.exchange(0);
+        long c = contended.exchange(0), q = queue_sum.exchange(0), h = hold_ns.exchange(0);
+        if (p == 0) return {0, 0, 0, 0};
+        return {p, (double)c / p, (double)q / p, h / 1e3 / p};
+    }
+
+    Mode current() const { return (Mode)mode.load(); }
+    int size() const { return n; }
+};
+
+// Picks a mode from one window's sample.
+//   - little contention: ordered mutexes, nothing to arbitrate and the cheapest path
+//   - long waiting queues: the monitor, which only wakes a philosopher that can eat
+//   - in between: the arbitrator, which keeps one seat free so the ring never fills
+// Leaving a mode takes a clearer signal than entering it, so a load that sits near a
+// threshold does not flap.
+Mode choose(const Sample &s, int n, Mode now) {
+    if (s.contention < (now == HIERARCHY ? 0.35 : 0.15)) return HIERARCHY;
+    if (s.queue >= (now == MONITOR ? 0.25 : 0.4) * n) return MONITOR;
+    return ARBITRATOR;
+}
+
+// Samples the table every `period` and switches when two windows in a row agree on a
+// different mode. Each decision goes to `log`.
+class Controller {
+    AdaptiveForks &forks;
+    chrono::milliseconds period;
+    atomic<bool> stop{false};
+    thread th;
+    Clock::time_point start = Clock::now();
+
+public:
+    vector<string> log;
+    bool echo;
+
+    Controller(AdaptiveForks &forks, chrono::milliseconds period, bool echo)
+        : forks(forks), period(period), echo(echo) {
+        th = thread([this] { run(); });
+    }
+    ~Controller() { finish(); }
+
+    // Stops sampling; `log` is stable afterwards.
+    void finish() {
+        stop = true;
+        if (th.joinable()) th.join();
+    }
+
+    void run() {
+        Mode pending = forks.current();
+        while (!stop) {
+            this_thread::sleep_for(period);
+            Sample s = forks.sample();
+            if (s.pickups == 0) continue;
+            Mode now = forks.current();
+            Mode want = choose(s, forks.size(), now);
+            if (want == now || want != pending) {
+                pending = want;
+                continue;
+            }
+            auto closed = forks.switch_to(want);
+            ostringstream line;
+            line << fixed << setprecision(2) << "[" << setw(6)
+                 << chrono::duration<double, milli>(Clock::now() - start).count() << " ms] "
+                 << mode_name(now) << " -> " << mode_name(want) << " (contention " << s.contention
+                 << ", queue " << s.queue << ", hold " << s.hold_us << " us; handoff "
+                 << chrono::duration<double, micro>(closed).count() << " us)";
+            log.push_back(line.str());
+            if (echo) cout << line.str() << endl;
+        }
+    }
+};
+
+void spin_for(chrono::nanoseconds d) {
+    auto until = Clock::now() + d;
+    while (Clock::now() < until) {}
+}
+
+// --bench: the four managers at rising load; think time (busy work) shrinks per level.
+double meals_per_sec(int n, int ms, chrono::nanoseconds think, chrono::nanoseconds eat,
+                     int fixed_mode, size_t *switches) {
+    AdaptiveForks forks(n, fixed_mode < 0 ? HIERARCHY : (Mode)fixed_mode);
+    unique_ptr<Controller> ctl;
+    if (fixed_mode < 0) ctl.reset(new Controller(forks, chrono::milliseconds(20), false));
+    atomic<bool> stop{false};
+    vector<long> meals(n, 0);
+    vector<thread> th;
+    for (int i = 0; i < n; i++)
+        th.emplace_back([&, i] {
+            long count = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                spin_for(think);
+                forks.pickup(i);
+                spin_for(eat);
+                forks.putdown(i);
+                count++;
+            }
+            meals[i] = count;
+        });
+    auto t0 = Clock::now();
+    this_thread::sleep_for(chrono::milliseconds(ms));
+    stop = true;
+    for (auto &t : th) t.join();
+    double secs = chrono::duration<double>(Clock::now() - t0).count();
+    if (ctl) {
+        ctl->finish();
+        *switches = ctl->log.size();
+    }
+    long total = 0;
+    for (long m : meals) total += m;
+    return total / secs;
+}
+
+void run_bench(int n, int ms) {
+    cout << "Benchmark: " << n << " philosophers, eat 2 us, " << ms << " ms per load (meals/sec)\n"
+         << "think us    hierarchy   arbitrator      monitor     adaptive  switches\n";
+    for (int think_us : {200, 50, 10, 2, 0}) {
+        auto think = chrono::microseconds(think_us), eat = chrono::microseconds(2);
+        cout << setw(8) << think_us;
+        for (int m = HIERARCHY; m <= MONITOR; m++)
+            cout << fixed << setprecision(0) << setw(13) << meals_per_sec(n, ms, think, eat, m, nullptr);
+        size_t switches = 0;
+        cout << setw(13) << meals_per_sec(n, ms, think, eat, -1, &switches) << setw(10) << switches << "\n";
+    }
+}
+
+const int N = 5;
+const int ROUNDS = 400;
+
+// Demo: the first and last quarter of the rounds think for a long time, the middle
+// half barely at all, so the controller has a load change in each direction to follow.
+void philosopher(AdaptiveForks &forks, int i) {
+    for (int r = 0; r < ROUNDS; r++) {
+        bool calm = r < ROUNDS / 4 || r >= 3 * ROUNDS / 4;
+        this_thread::sleep_for(chrono::microseconds(calm ? 2000 : 0));
+        forks.pickup(i);
+        this_thread::sleep_for(chrono::microseconds(200));
+        forks.putdown(i);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        int n = argc > 2 ? atoi(argv[2]) : (int)max(2u, thread::hardware_concurrency());
+        int ms = argc > 3 ? atoi(argv[3]) : 300;
+        if (n < 2 || ms < 1) {
+            cerr << "usage: " << argv[0] << " --bench [philosophers>=2] [ms per load>=1]\n";
+            return 1;
+        }
+        run_bench(n, ms);
+        return 0;
+    }
+    if (argc > 1) {
+        cerr << "usage: " << argv[0] << " [--bench [philosophers] [ms per load]]\n";
+        return 1;
+    }
+
+    cout << "Dining Philosophers (adaptive fork manager), " << N << " philosophers x "
+         << ROUNDS << " meals\n";
+    AdaptiveForks forks(N, HIERARCHY);
+    size_t switches;
+    {
+        Controller ctl(forks, chrono::milliseconds(20), true);
+        vector<thread> th;
+        for (int i = 0; i < N; i++)
+            th.emplace_back(philosopher, ref(forks), i);
+        for (auto &t : th) t.join();
+        ctl.finish();
+        switches = ctl.log.size();
+    }
+    cout << switches << " switches, finished in " << mode_name(forks.current()) << " mode.\n";
+    cout << "All philosophers are full and the program has completed.\n";
+    return 0;
+}
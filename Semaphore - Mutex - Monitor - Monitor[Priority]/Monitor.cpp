@@ -1,6 +1,11 @@
 // monitor_output.cpp
 // Dining Philosophers with Monitor (Condition Variables)
 // Compile: g++ -std=c++17 monitor_output.cpp -pthread -o monitor_output
+// Run:     ./monitor_output [--sample-ms <period>] [--placement none|compact|scatter|ring]
+//          --sample-ms starts a sampler thread that records the number of concurrent
+//          eaters through the lock-free snapshot API and prints the time series.
+//          --placement pins philosophers to CPUs by topology (see common/placement.h).
+//          DP_STATS=1 publishes live counters (see Tools/stats_watch.cpp).
 
 #include <iostream>
 #include <thread>
@@ -8,17 +13,50 @@
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdlib>
+#include "../common/stats_page.h"
+#include "../common/placement.h"
+#include "../common/safety.h"
 using namespace std;
 
 const int N = 5;
 const int EAT_COUNT = 1;   // each philosopher eats once for clarity
 enum State { THINKING, HUNGRY, EATING };
 
+// Consistent copy of every philosopher's state, taken without touching m.
+struct Snapshot {
+    unsigned version;   // even seqlock value the copy was taken at
+    State state[N];
+    int eating;         // concurrent eaters
+};
+
 class Monitor {
     mutex m;
     condition_variable self[N];
     State state[N];
 
+    // Seqlock mirror of state[] for observers. Writers already hold m, so seq is
+    // only ever bumped by one thread at a time: odd while an update is in flight,
+    // even once it is complete. Readers only load, so sampling never writes to a
+    // line the philosophers use.
+    atomic<unsigned> seq{0};
+    atomic<int> published[N];
+
+    void begin_update() {
+        seq.store(seq.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+    void end_update() {
+        seq.store(seq.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+    void set_state(int i, State s) {
+        state[i] = s;
+        published[i].store(s, memory_order_relaxed);
+    }
+
     int left(int i) { return (i + N - 1) % N; }
     int right(int i) { return (i + 1) % N; }
 
@@ -26,18 +64,20 @@ class Monitor {
         if (state[i] == HUNGRY &&
             state[left(i)] != EATING &&
             state[right(i)] != EATING) {
-            state[i] = EATING;
+            set_state(i, EATING);
             self[i].notify_one();
         }
     }
 
 public:
-    Monitor() { for (int i = 0; i < N; i++) state[i] = THINKING; }
+    Monitor() { for (int i = 0; i < N; i++) set_state(i, THINKING); }
 
     void pickup(int i) {
         unique_lock<mutex> lk(m);
-        state[i] = HUNGRY;
+        begin_update();
+        set_state(i, HUNGRY);
         test(i);
+        end_update();
         while (state[i] != EATING)
             self[i].wait(lk);
         cout << "Philosopher " << i << " picked up left fork " << i << ".\n";
@@ -46,30 +86,126 @@ public:
 
     void putdown(int i) {
         unique_lock<mutex> lk(m);
-        state[i] = THINKING;
         cout << "Philosopher " << i << " put down right fork " << (i+1)%N << ".\n";
         cout << "Philosopher " << i << " put down left fork " << i << ".\n";
         cout << "Philosopher " << i << " is full and has finished eating.\n";
+        begin_update();
+        set_state(i, THINKING);
         test(left(i));
         test(right(i));
+        end_update();
+    }
+
+    // Retries until it copies a version no writer touched mid-read.
+    Snapshot snapshot() const {
+        Snapshot snap;
+        for (;;) {
+            unsigned before = seq.load(memory_order_acquire);
+            if (before & 1) { this_thread::yield(); continue; }
+            for (int i = 0; i < N; i++)
+                snap.state[i] = (State)published[i].load(memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            if (seq.load(memory_order_relaxed) == before) {
+                snap.version = before;
+                break;
+            }
+        }
+        snap.eating = 0;
+        for (int i = 0; i < N; i++)
+            if (snap.state[i] == EATING) snap.eating++;
+        return snap;
+    }
+};
+
+// Records the number of concurrent eaters at a fixed rate using snapshot() only.
+class EaterSampler {
+    const Monitor &mon;
+    chrono::milliseconds period;
+    atomic<bool> stopping{false};
+    vector<pair<double, int>> series;   // (ms since start, eaters)
+    thread worker;
+
+    void run() {
+        auto start = chrono::steady_clock::now();
+        auto next = start;
+        while (!stopping.load(memory_order_relaxed)) {
+            Snapshot snap = mon.snapshot();
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            series.emplace_back(ms, snap.eating);
+            next += period;
+            this_thread::sleep_until(next);
+        }
+    }
+
+public:
+    EaterSampler(const Monitor &mon, chrono::milliseconds period) : mon(mon), period(period) {
+        worker = thread(&EaterSampler::run, this);
+    }
+
+    void stop() {
+        stopping = true;
+        if (worker.joinable()) worker.join();
+    }
+
+    void print() const {
+        cout << "Concurrent eaters sampled every " << period.count() << " ms:\n";
+        for (auto &s : series)
+            cout << "  t=" << (long)s.first << "ms eaters=" << s.second << "\n";
     }
 };
 
 void philosopher(Monitor &mon, int id) {
+    stats::Page &st = stats::page();
+    st.set_state(id, stats::HUNGRY);
     mon.pickup(id);
+    safety::checker().eat(id);
+    st.fork_held(id);
+    st.fork_held((id + 1) % N);
+    st.set_state(id, stats::EATING);
     cout << "Philosopher " << id << " is eating.\n";
     this_thread::sleep_for(chrono::milliseconds(200));
+    st.meal(id);
+    st.set_state(id, stats::THINKING);
+    safety::checker().done(id);
     mon.putdown(id);
 }
 
-int main() {
+int main(int argc, char **argv) {
+    int sample_ms = 0;
+    placement::Policy policy = placement::Policy::NONE;
+    for (int a = 1; a < argc; a += 2) {
+        string opt = argv[a];
+        if (a + 1 < argc && opt == "--sample-ms")
+            sample_ms = atoi(argv[a + 1]);
+        else if (!(a + 1 < argc && opt == "--placement" && placement::parse_policy(argv[a + 1], policy))) {
+            cerr << "usage: " << argv[0] << " [--sample-ms <period>] [--placement none|compact|scatter|ring]\n";
+            return 1;
+        }
+    }
+    vector<int> cpus = placement::plan(policy, N);
+    if (policy != placement::Policy::NONE)
+        placement::describe(cout, policy, cpus);
+    stats::page().open("monitor", N);
+    safety::checker().open("monitor", N);
+
     Monitor mon;
+    unique_ptr<EaterSampler> sampler;
+    if (sample_ms > 0)
+        sampler.reset(new EaterSampler(mon, chrono::milliseconds(sample_ms)));
+
     vector<thread> th;
-    for (int i = 0; i < N; i++)
+    for (int i = 0; i < N; i++) {
         th.emplace_back(philosopher, ref(mon), i);
+        placement::pin(th.back(), cpus[i]);
+    }
 
     for (auto &t : th) t.join();
 
+    if (sampler) {
+        sampler->stop();
+        sampler->print();
+    }
+
     cout << "All philosophers are full and the program has completed.\n";
     return 0;
 }
@@ -0,0 +1,265 @@
+// monitor_flat_combining.cpp
+// Dining Philosophers with a flat-combining Monitor
+// Philosophers publish pickup/putdown requests in per-philosopher slots. Whichever
+// thread holds the combiner lock applies the whole batch of state transitions and
+// test() calls in one pass, so state[] stays hot in one cache instead of migrating
+// with mutex m on every call. Grants are signalled back through per-slot flags.
+// Compile: g++ -std=c++17 -O2 Monitor_flat_combining.cpp -pthread -o monitor_flat_combining
+// Run:     ./monitor_flat_combining                          (demo, same story as Monitor.cpp)
+//          ./monitor_flat_combining --bench [philosophers] [meals]
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include "../common/safety.h"
+using namespace std;
+
+const int N = 5;
+const int EAT_COUNT = 1;   // each philosopher eats once for clarity
+enum State { THINKING, HUNGRY, EATING };
+
+// Same algorithm as Monitor.cpp, without console output and sized at runtime,
+// so it can be benchmarked against the flat-combining version.
+class Monitor {
+    int n;
+    mutex m;
+    vector<condition_variable> self;
+    vector<State> state;
+
+    int left(int i) { return (i + n - 1) % n; }
+    int right(int i) { return (i + 1) % n; }
+
+    void test(int i) {
+        if (state[i] == HUNGRY &&
+            state[left(i)] != EATING &&
+            state[right(i)] != EATING) {
+            state[i] = EATING;
+            self[i].notify_one();
+        }
+    }
+
+public:
+    explicit Monitor(int n = N) : n(n), self(n), state(n, THINKING) {}
+
+    void pickup(int i) {
+        unique_lock<mutex> lk(m);
+        state[i] = HUNGRY;
+        test(i);
+        while (state[i] != EATING)
+            self[i].wait(lk);
+    }
+
+    void putdown(int i) {
+        unique_lock<mutex> lk(m);
+        state[i] = THINKING;
+        test(left(i));
+        test(right(i));
+    }
+};
+
+// API-compatible with Monitor: pickup(i) blocks until philosopher i may eat,
+// putdown(i) returns once its forks have been handed back.
+class FlatCombiningMonitor {
+    enum Op { NONE, PICKUP, PUTDOWN };
+
+    // One slot per philosopher, each on its own cache line. The owner writes op,
+    // the combiner clears it and sets granted; mtx/cv are only touched when the
+    // owner gives up spinning and goes to sleep.
+    struct alignas(64) Slot {
+        atomic<int> op{NONE};
+        atomic<bool> granted{false};
+        atomic<bool> sleeping{false};
+        mutex mtx;
+        condition_variable cv;
+    };
+
+    static const int SPIN_LIMIT = 256;   // polls before a waiter blocks on its slot
+    static const int MAX_PASSES = 4;     // scans per combining session
+
+    int n;
+    unique_ptr<Slot[]> slots;
+    alignas(64) atomic<bool> combining{false};
+    // Only ever touched by the combiner: whole cache lines of its own, rounded up so
+    // that no other data shares the last one.
+    unique_ptr<State[], void (*)(void *)> state;
+
+    int left(int i) { return (i + n - 1) % n; }
+    int right(int i) { return (i + 1) % n; }
+
+    void grant(int i) {
+        Slot &s = slots[i];
+        s.granted.store(true, memory_order_seq_cst);
+        if (s.sleeping.load(memory_order_seq_cst)) {
+            lock_guard<mutex> lk(s.mtx);
+            s.cv.notify_one();
+        }
+    }
+
+    void test(int i) {
+        if (state[i] == HUNGRY &&
+            state[left(i)] != EATING &&
+            state[right(i)] != EATING) {
+            state[i] = EATING;
+            grant(i);
+        }
+    }
+
+    // Apply every published request. Called with the combiner lock held.
+    void combine() {
+        for (int pass = 0; pass < MAX_PASSES; pass++) {
+            bool applied = false;
+            for (int i = 0; i < n; i++) {
+                int op = slots[i].op.load(memory_order_acquire);
+                if (op == NONE) continue;
+                if (op == PICKUP) {
+                    state[i] = HUNGRY;
+                    test(i);
+                } else {
+                    state[i] = THINKING;
+                    test(left(i));
+                    test(right(i));
+                }
+                slots[i].op.store(NONE, memory_order_release);
+                applied = true;
+            }
+            if (!applied) break;
+        }
+    }
+
+    // Publish op in slot i and return once some combiner (possibly us) applied it.
+    void submit(int i, Op op) {
+        Slot &s = slots[i];
+        s.op.store(op, memory_order_release);
+        while (s.op.load(memory_order_acquire) != NONE) {
+            if (!combining.load(memory_order_relaxed) &&
+                !combining.exchange(true, memory_order_acquire)) {
+                combine();
+                combining.store(false, memory_order_release);
+            } else {
+                this_thread::yield();
+            }
+        }
+    }
+
+    void wait_granted(int i) {
+        Slot &s = slots[i];
+        for (int spin = 0; spin < SPIN_LIMIT; spin++) {
+            if (s.granted.load(memory_order_acquire)) return;
+            this_thread::yield();
+        }
+        unique_lock<mutex> lk(s.mtx);
+        s.sleeping.store(true, memory_order_seq_cst);
+        while (!s.granted.load(memory_order_seq_cst))
+            s.cv.wait(lk);
+        s.sleeping.store(false, memory_order_relaxed);
+    }
+
+public:
+    explicit FlatCombiningMonitor(int n = N)
+        : n(n), slots(new Slot[n]),
+          state(static_cast<State *>(aligned_alloc(64, (n * sizeof(State) + 63) / 64 * 64)), free) {
+        if (!state) {
+            perror("aligned_alloc");
+            exit(1);
+        }
+        for (int i = 0; i < n; i++) state[i] = THINKING;
+    }
+
+    void pickup(int i) {
+        slots[i].granted.store(false, memory_order_relaxed);
+        submit(i, PICKUP);
+        wait_granted(i);
+    }
+
+    void putdown(int i) {
+        submit(i, PUTDOWN);
+    }
+};
+
+mutex cout_mtx;
+
+void philosopher(FlatCombiningMonitor &mon, int id) {
+    for (int meal = 0; meal < EAT_COUNT; meal++) {
+        mon.pickup(id);
+        safety::checker().eat(id);
+        {
+            lock_guard<mutex> lk(cout_mtx);
+            cout << "Philosopher " << id << " picked up left fork " << id << ".\n";
+            cout << "Philosopher " << id << " picked up right fork " << (id+1)%N << ".\n";
+            cout << "Philosopher " << id << " is eating.\n";
+        }
+        this_thread::sleep_for(chrono::milliseconds(200));
+        {
+            lock_guard<mutex> lk(cout_mtx);
+            cout << "Philosopher " << id << " put down right fork " << (id+1)%N << ".\n";
+            cout << "Philosopher " << id << " put down left fork " << id << ".\n";
+            cout << "Philosopher " << id << " is full and has finished eating.\n";
+        }
+        safety::checker().done(id);
+        mon.putdown(id);
+    }
+}
+
+// Every philosopher eats `meals` times back to back with no thinking or eating
+// delay, so the run is dominated by pickup/putdown. The safety checker stays on,
+// as it would in production (DP_SAFETY=count to count instead of aborting).
+template <class MonitorT>
+void run_bench(const char *name, int n, int meals) {
+    MonitorT mon(n);
+    safety::Checker safe(name, n);
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> th;
+    for (int id = 0; id < n; id++) {
+        th.emplace_back([&, id] {
+            for (int meal = 0; meal < meals; meal++) {
+                mon.pickup(id);
+                safe.eat(id);
+                safe.done(id);
+                mon.putdown(id);
+            }
+        });
+    }
+    for (auto &t : th) t.join();
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    long total = (long)n * meals;
+    cout << name << ": " << total << " meals in " << secs << " s, "
+         << (long)(total / secs) << " meals/sec, "
+         << (secs * 1e9 / total) << " ns/meal, "
+         << safe.violations() << " adjacency violations\n";
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        int n = argc > 2 ? atoi(argv[2]) : (int)max(2u, thread::hardware_concurrency());
+        int meals = argc > 3 ? atoi(argv[3]) : 100000;
+        if (n < 2 || meals < 1) {
+            cerr << "usage: " << argv[0] << " --bench [philosophers>=2] [meals>=1]\n";
+            return 1;
+        }
+        cout << "Benchmark: " << n << " philosophers x " << meals << " meals\n";
+        run_bench<Monitor>("Monitor             ", n, meals);
+        run_bench<FlatCombiningMonitor>("FlatCombiningMonitor", n, meals);
+        return 0;
+    }
+
+    safety::checker().open("monitor_flat_combining", N);
+    FlatCombiningMonitor mon;
+    vector<thread> th;
+    for (int i = 0; i < N; i++)
+        th.emplace_back(philosopher, ref(mon), i);
+
+    for (auto &t : th) t.join();
+
+    cout << "All philosophers are full and the program has completed.\n";
+    return 0;
+}
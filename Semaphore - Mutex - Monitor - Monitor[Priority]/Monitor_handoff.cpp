@@ -0,0 +1,247 @@
+// monitor_handoff.cpp
+// Dining Philosophers with a direct-handoff Monitor
+// In Monitor.cpp, test() sets state[i] = EATING and calls notify_one() while m is still
+// held: the woken philosopher runs only to block on m again, then re-checks a state that
+// was already decided for it. Here the grant is handed over instead: test() decides
+// under m as before, but the philosopher is woken through its own slot after m has
+// been released, and it returns from pickup() without touching m again. The grant is
+// written to the slot under the slot's mutex before the notify, so a waiter that has
+// not gone to sleep yet still sees it.
+// Compile: g++ -std=c++17 -O2 Monitor_handoff.cpp -pthread -o monitor_handoff
+// Run:     ./monitor_handoff                          (demo, same story as Monitor.cpp)
+//          ./monitor_handoff --bench [philosophers] [meals]
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <sys/resource.h>
+#include "../common/primitives.h"
+#include "../common/safety.h"
+using namespace std;
+using Clock = chrono::steady_clock;
+
+const int N = 5;
+const int EAT_COUNT = 1;   // each philosopher eats once for clarity
+enum State { THINKING, HUNGRY, EATING };
+
+long now_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// API-compatible with dp::Monitor (common/primitives.h).
+class HandoffMonitor {
+    // Where a granted philosopher is woken. Only the owner and its granter touch it.
+    struct alignas(64) Slot {
+        mutex mtx;
+        condition_variable cv;
+        bool granted = false;
+    };
+
+    int n;
+    mutex m;
+    vector<State> state;
+    unique_ptr<Slot[]> slots;
+
+    int left(int i) { return (i + n - 1) % n; }
+    int right(int i) { return (i + 1) % n; }
+
+    // Decides under m; the caller hands the grant over once m is released.
+    bool test(int i) {
+        if (state[i] == HUNGRY &&
+            state[left(i)] != EATING &&
+            state[right(i)] != EATING) {
+            state[i] = EATING;
+            return true;
+        }
+        return false;
+    }
+
+    void hand_over(int i) {
+        Slot &s = slots[i];
+        {
+            lock_guard<mutex> lk(s.mtx);
+            s.granted = true;
+        }
+        s.cv.notify_one();
+    }
+
+public:
+    explicit HandoffMonitor(int n = N) : n(n), state(n, THINKING), slots(new Slot[n]) {}
+
+    void pickup(int i) {
+        Slot &s = slots[i];
+        {
+            unique_lock<mutex> lk(m);
+            state[i] = HUNGRY;
+            if (test(i)) return;
+        }
+        unique_lock<mutex> lk(s.mtx);
+        s.cv.wait(lk, [&s] { return s.granted; });
+        s.granted = false;
+    }
+
+    void putdown(int i) {
+        bool wake_left, wake_right;
+        {
+            unique_lock<mutex> lk(m);
+            state[i] = THINKING;
+            wake_left = test(left(i));
+            wake_right = test(right(i));
+        }
+        if (wake_left) hand_over(left(i));
+        if (wake_right) hand_over(right(i));
+    }
+};
+
+// Times a monitor's hand-over from outside: a philosopher that had to wait is granted by
+// the later of its neighbours' putdown() calls, which stamp themselves first. The same
+// clock reads go into both monitors, so the difference is the hand-over itself.
+template <class MonitorT>
+class Timed {
+    int n;
+    MonitorT mon;
+    unique_ptr<atomic<long>[]> put_at;
+    vector<long> wake_ns;
+
+public:
+    explicit Timed(int n) : n(n), mon(n), put_at(new atomic<long>[n]), wake_ns(n, -1) {
+        for (int i = 0; i < n; i++) put_at[i] = 0;
+    }
+
+    void pickup(int i) {
+        long asked = now_ns();
+        mon.pickup(i);
+        long granted = max(put_at[(i + n - 1) % n].load(), put_at[(i + 1) % n].load());
+        wake_ns[i] = granted > asked ? now_ns() - granted : -1;
+    }
+
+    void putdown(int i) {
+        put_at[i] = now_ns();
+        mon.putdown(i);
+    }
+
+    // Putdown-to-return latency of i's last pickup, or -1 if it did not have to wait.
+    long last_wake_ns(int i) const { return wake_ns[i]; }
+};
+
+mutex cout_mtx;
+
+void philosopher(HandoffMonitor &mon, int id) {
+    for (int meal = 0; meal < EAT_COUNT; meal++) {
+        mon.pickup(id);
+        safety::checker().eat(id);
+        {
+            lock_guard<mutex> lk(cout_mtx);
+            cout << "Philosopher " << id << " picked up left fork " << id << ".\n";
+            cout << "Philosopher " << id << " picked up right fork " << (id+1)%N << ".\n";
+            cout << "Philosopher " << id << " is eating.\n";
+        }
+        this_thread::sleep_for(chrono::milliseconds(200));
+        {
+            lock_guard<mutex> lk(cout_mtx);
+            cout << "Philosopher " << id << " put down right fork " << (id+1)%N << ".\n";
+            cout << "Philosopher " << id << " put down left fork " << id << ".\n";
+            cout << "Philosopher " << id << " is full and has finished eating.\n";
+        }
+        safety::checker().done(id);
+        mon.putdown(id);
+    }
+}
+
+long context_switches() {
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_nvcsw + ru.ru_nivcsw;
+}
+
+// Every philosopher eats `meals` times back to back, holding the forks for ~1 us so
+// that neighbours really wait. Prints throughput, context switches per meal and a
+// log2 histogram of putdown() -> pickup() return latency over the pickups that waited.
+template <class MonitorT>
+void run_bench(const char *name, int n, int meals) {
+    Timed<MonitorT> mon(n);
+    safety::Checker safe(name, n);
+    vector<vector<long>> lat(n);
+
+    long csw0 = context_switches();
+    auto start = Clock::now();
+    vector<thread> th;
+    for (int id = 0; id < n; id++) {
+        th.emplace_back([&, id] {
+            lat[id].reserve(meals);
+            for (int meal = 0; meal < meals; meal++) {
+                mon.pickup(id);
+                long w = mon.last_wake_ns(id);
+                if (w >= 0) lat[id].push_back(w);
+                safe.eat(id);
+                auto until = Clock::now() + chrono::microseconds(1);
+                while (Clock::now() < until) {}
+                safe.done(id);
+                mon.putdown(id);
+            }
+        });
+    }
+    for (auto &t : th) t.join();
+    double secs = chrono::duration<double>(Clock::now() - start).count();
+    long csw = context_switches() - csw0;
+
+    vector<long> all;
+    for (auto &v : lat) all.insert(all.end(), v.begin(), v.end());
+    sort(all.begin(), all.end());
+    auto pct = [&](double p) { return all.empty() ? 0 : all[min(all.size() - 1, (size_t)(p * all.size()))]; };
+
+    long total = (long)n * meals;
+    cout << name << ": " << (long)(total / secs) << " meals/sec, "
+         << fixed << setprecision(2) << (double)csw / total << " context switches/meal, "
+         << safe.violations() << " adjacency violations\n"
+         << "  wake-to-eat over " << all.size() << " waits: p50 " << pct(0.50) << " ns, p90 "
+         << pct(0.90) << " ns, p99 " << pct(0.99) << " ns\n";
+
+    vector<long> buckets(40, 0);
+    for (long v : all) {
+        int b = 0;
+        while ((2L << b) <= v && b < 39) b++;
+        buckets[b]++;
+    }
+    for (int b = 0; b < 40; b++) {
+        if (!buckets[b]) continue;
+        cout << "  " << setw(9) << (b ? 1L << b : 0) << " - " << setw(9) << (2L << b) - 1 << " ns "
+             << setw(8) << buckets[b] << " "
+             << string((size_t)(50.0 * buckets[b] / all.size() + 0.5), '#') << "\n";
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        int n = argc > 2 ? atoi(argv[2]) : (int)max(2u, thread::hardware_concurrency());
+        int meals = argc > 3 ? atoi(argv[3]) : 20000;
+        if (n < 2 || meals < 1) {
+            cerr << "usage: " << argv[0] << " --bench [philosophers>=2] [meals>=1]\n";
+            return 1;
+        }
+        cout << "Benchmark: " << n << " philosophers x " << meals << " meals\n";
+        run_bench<dp::Monitor>("Monitor       ", n, meals);
+        run_bench<HandoffMonitor>("HandoffMonitor", n, meals);
+        return 0;
+    }
+
+    safety::checker().open("monitor_handoff", N);
+    HandoffMonitor mon;
+    vector<thread> th;
+    for (int i = 0; i < N; i++)
+        th.emplace_back(philosopher, ref(mon), i);
+
+    for (auto &t : th) t.join();
+
+    cout << "All philosophers are full and the program has completed.\n";
+    return 0;
+}
@@ -1,6 +1,11 @@
 // monitor_priority_output.cpp
 // Dining Philosophers with Monitor + FIFO fairness
 // Compile: g++ -std=c++17 monitor_priority_output.cpp -pthread -o monitor_priority_output
+// Run:     ./monitor_priority_output [--sample-ms <period>] [--placement none|compact|scatter|ring]
+//          --sample-ms starts a sampler thread that records concurrent eaters and
+//          queue depth through the lock-free snapshot API and prints the time series.
+//          --placement pins philosophers to CPUs by topology (see common/placement.h).
+//          DP_STATS=1 publishes live counters (see Tools/stats_watch.cpp).
 
 #include <iostream>
 #include <thread>
@@ -9,18 +14,52 @@
 #include <condition_variable>
 #include <deque>
 #include <chrono>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdlib>
+#include "../common/stats_page.h"
+#include "../common/placement.h"
+#include "../common/safety.h"
 using namespace std;
 
 const int N = 5;
 const int EAT_COUNT = 1;
 enum State { THINKING, HUNGRY, EATING };
 
+// Consistent copy of the monitor's state, taken without touching m.
+struct Snapshot {
+    unsigned version;   // even seqlock value the copy was taken at
+    State state[N];
+    int queued;         // waitQ depth
+    int eating;         // concurrent eaters
+};
+
 class PriorityMonitor {
     mutex m;
     condition_variable cond[N];
     State state[N];
     deque<int> waitQ;
 
+    // Seqlock mirror of state[] and waitQ.size(), see Monitor.cpp. Only written
+    // with m held; readers never store.
+    atomic<unsigned> seq{0};
+    atomic<int> published[N];
+    atomic<int> published_queued{0};
+
+    void begin_update() {
+        seq.store(seq.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+    void end_update() {
+        published_queued.store((int)waitQ.size(), memory_order_relaxed);
+        seq.store(seq.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+    void set_state(int i, State s) {
+        state[i] = s;
+        published[i].store(s, memory_order_relaxed);
+    }
+
     int left(int i) { return (i + N - 1) % N; }
     int right(int i) { return (i + 1) % N; }
 
@@ -31,23 +70,29 @@ class PriorityMonitor {
     }
 
 public:
-    PriorityMonitor() { for (int i = 0; i < N; i++) state[i] = THINKING; }
+    PriorityMonitor() { for (int i = 0; i < N; i++) set_state(i, THINKING); }
 
     void pickup(int i) {
         unique_lock<mutex> lk(m);
-        state[i] = HUNGRY;
+        begin_update();
+        set_state(i, HUNGRY);
         waitQ.push_back(i);
+        end_update();
         while (!(waitQ.front() == i && canEat(i)))
             cond[i].wait(lk);
+        begin_update();
         waitQ.pop_front();
-        state[i] = EATING;
+        set_state(i, EATING);
+        end_update();
         cout << "Philosopher " << i << " picked up left fork " << i << ".\n";
         cout << "Philosopher " << i << " picked up right fork " << (i+1)%N << ".\n";
     }
 
     void putdown(int i) {
         unique_lock<mutex> lk(m);
-        state[i] = THINKING;
+        begin_update();
+        set_state(i, THINKING);
+        end_update();
         cout << "Philosopher " << i << " put down right fork " << (i+1)%N << ".\n";
         cout << "Philosopher " << i << " put down left fork " << i << ".\n";
         cout << "Philosopher " << i << " is full and has finished eating.\n";
@@ -58,23 +103,119 @@ public:
             }
         }
     }
+
+    // Retries until it copies a version no writer touched mid-read.
+    Snapshot snapshot() const {
+        Snapshot snap;
+        for (;;) {
+            unsigned before = seq.load(memory_order_acquire);
+            if (before & 1) { this_thread::yield(); continue; }
+            for (int i = 0; i < N; i++)
+                snap.state[i] = (State)published[i].load(memory_order_relaxed);
+            snap.queued = published_queued.load(memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            if (seq.load(memory_order_relaxed) == before) {
+                snap.version = before;
+                break;
+            }
+        }
+        snap.eating = 0;
+        for (int i = 0; i < N; i++)
+            if (snap.state[i] == EATING) snap.eating++;
+        return snap;
+    }
+};
+
+// Records concurrent eaters and queue depth at a fixed rate using snapshot() only.
+class EaterSampler {
+    const PriorityMonitor &mon;
+    chrono::milliseconds period;
+    atomic<bool> stopping{false};
+    struct Sample { double ms; int eating; int queued; };
+    vector<Sample> series;
+    thread worker;
+
+    void run() {
+        auto start = chrono::steady_clock::now();
+        auto next = start;
+        while (!stopping.load(memory_order_relaxed)) {
+            Snapshot snap = mon.snapshot();
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            series.push_back({ms, snap.eating, snap.queued});
+            next += period;
+            this_thread::sleep_until(next);
+        }
+    }
+
+public:
+    EaterSampler(const PriorityMonitor &mon, chrono::milliseconds period) : mon(mon), period(period) {
+        worker = thread(&EaterSampler::run, this);
+    }
+
+    void stop() {
+        stopping = true;
+        if (worker.joinable()) worker.join();
+    }
+
+    void print() const {
+        cout << "Concurrent eaters sampled every " << period.count() << " ms:\n";
+        for (auto &s : series)
+            cout << "  t=" << (long)s.ms << "ms eaters=" << s.eating << " queued=" << s.queued << "\n";
+    }
 };
 
 void philosopher(PriorityMonitor &mon, int id) {
+    stats::Page &st = stats::page();
+    st.set_state(id, stats::HUNGRY);
     mon.pickup(id);
+    safety::checker().eat(id);
+    st.fork_held(id);
+    st.fork_held((id + 1) % N);
+    st.set_state(id, stats::EATING);
     cout << "Philosopher " << id << " is eating.\n";
     this_thread::sleep_for(chrono::milliseconds(200));
+    st.meal(id);
+    st.set_state(id, stats::THINKING);
+    safety::checker().done(id);
     mon.putdown(id);
 }
 
-int main() {
+int main(int argc, char **argv) {
+    int sample_ms = 0;
+    placement::Policy policy = placement::Policy::NONE;
+    for (int a = 1; a < argc; a += 2) {
+        string opt = argv[a];
+        if (a + 1 < argc && opt == "--sample-ms")
+            sample_ms = atoi(argv[a + 1]);
+        else if (!(a + 1 < argc && opt == "--placement" && placement::parse_policy(argv[a + 1], policy))) {
+            cerr << "usage: " << argv[0] << " [--sample-ms <period>] [--placement none|compact|scatter|ring]\n";
+            return 1;
+        }
+    }
+    vector<int> cpus = placement::plan(policy, N);
+    if (policy != placement::Policy::NONE)
+        placement::describe(cout, policy, cpus);
+    stats::page().open("monitor_priority", N);
+    safety::checker().open("monitor_priority", N);
+
     PriorityMonitor mon;
+    unique_ptr<EaterSampler> sampler;
+    if (sample_ms > 0)
+        sampler.reset(new EaterSampler(mon, chrono::milliseconds(sample_ms)));
+
     vector<thread> th;
-    for (int i = 0; i < N; i++)
+    for (int i = 0; i < N; i++) {
         th.emplace_back(philosopher, ref(mon), i);
+        placement::pin(th.back(), cpus[i]);
+    }
 
     for (auto &t : th) t.join();
 
+    if (sampler) {
+        sampler->stop();
+        sampler->print();
+    }
+
     cout << "All philosophers are full and the program has completed.\n";
     return 0;
 }
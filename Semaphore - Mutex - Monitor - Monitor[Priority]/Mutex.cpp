@@ -3,6 +3,10 @@
 #include <mutex>
 #include <vector>
 #include <chrono>
+#include <string>
+#include "../common/stats_page.h"
+#include "../common/placement.h"
+#include "../common/safety.h"
 using namespace std;
 
 const int N = 5;   // number of philosophers
@@ -12,37 +16,50 @@ mutex cout_mtx;    // extra mutex to protect console output
 void philosopher(int id) {
     int left = id;
     int right = (id + 1) % N;
+    stats::Page &st = stats::page();
+    st.set_state(id, stats::HUNGRY);
 
     // Deadlock prevention: last philosopher picks right fork first
     if (id == N - 1) {
         forks[right].lock();
+        st.fork_held(right);
+        st.set_state(id, stats::HOLDING_ONE_FORK);
         {
             lock_guard<mutex> lock(cout_mtx);
             cout << "Philosopher " << id << " picked up right fork " << right << ".\n";
         }
         forks[left].lock();
+        st.fork_held(left);
         {
             lock_guard<mutex> lock(cout_mtx);
             cout << "Philosopher " << id << " picked up left fork " << left << ".\n";
         }
     } else {
         forks[left].lock();
+        st.fork_held(left);
+        st.set_state(id, stats::HOLDING_ONE_FORK);
         {
             lock_guard<mutex> lock(cout_mtx);
             cout << "Philosopher " << id << " picked up left fork " << left << ".\n";
         }
         forks[right].lock();
+        st.fork_held(right);
         {
             lock_guard<mutex> lock(cout_mtx);
             cout << "Philosopher " << id << " picked up right fork " << right << ".\n";
         }
     }
+    safety::checker().eat(id);
+    st.set_state(id, stats::EATING);
 
     {
         lock_guard<mutex> lock(cout_mtx);
         cout << "Philosopher " << id << " is eating.\n";
     }
     this_thread::sleep_for(chrono::milliseconds(500));
+    st.meal(id);
+    st.set_state(id, stats::THINKING);
+    safety::checker().done(id);
 
     forks[left].unlock();
     {
@@ -57,10 +74,26 @@ void philosopher(int id) {
     }
 }
 
-int main() {
+// Run: ./mutex [--placement none|compact|scatter|ring]
+// DP_STATS=1 publishes live counters (see Tools/stats_watch.cpp).
+int main(int argc, char **argv) {
+    placement::Policy policy = placement::Policy::NONE;
+    if (argc > 1 && !(argc == 3 && string(argv[1]) == "--placement" &&
+                      placement::parse_policy(argv[2], policy))) {
+        cerr << "usage: " << argv[0] << " [--placement none|compact|scatter|ring]\n";
+        return 1;
+    }
+    vector<int> cpus = placement::plan(policy, N);
+    if (policy != placement::Policy::NONE)
+        placement::describe(cout, policy, cpus);
+    stats::page().open("mutex", N);
+    safety::checker().open("mutex", N);
+
     vector<thread> th;
-    for (int i = 0; i < N; i++)
+    for (int i = 0; i < N; i++) {
         th.emplace_back(philosopher, i);
+        placement::pin(th.back(), cpus[i]);
+    }
 
     for (auto &t : th) t.join();
 
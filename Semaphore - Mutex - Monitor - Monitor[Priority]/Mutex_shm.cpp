@@ -0,0 +1,229 @@
+// mutex_shm.cpp
+// Dining Philosophers with the forks in shared memory, one process per philosopher
+// Mutex.cpp's algorithm (a mutex per fork, the last philosopher takes its right fork
+// first), but the forks live in a POSIX shared-memory segment (common/shm_forks.h) as
+// process-shared robust mutexes. main() creates the table and forks one process per
+// philosopher; each attaches to the table by name and eats. If a philosopher dies
+// holding its forks, the neighbour that locks them next takes them over (EOWNERDEAD)
+// and the table keeps going.
+//
+// Compile: g++ -std=c++17 -O2 Mutex_shm.cpp -pthread -o mutex_shm
+// Run:     ./mutex_shm [--crash id]          (demo: 5 processes, 3 meals each)
+//          ./mutex_shm --bench [philosophers] [meals]
+//
+// --crash id   philosopher id is killed (SIGKILL) while it holds both forks
+// --bench      the same table as N processes and as N threads in one process, and
+//              Mutex.cpp's std::mutex forks as N threads. Meals hold the forks for one
+//              sched_yield(). Reports meals/s, and attach times for the processes.
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../common/shm_forks.h"
+#include "../common/primitives.h"
+using namespace std;
+using Clock = chrono::steady_clock;
+
+const int N = 5;
+const int EAT_COUNT = 3;
+
+// One write() per line, so lines from different processes do not interleave and
+// nothing sits in a stdio buffer across fork().
+void say(const string &line) {
+    string s = line + "\n";
+    if (write(STDOUT_FILENO, s.data(), s.size()) < 0) {}
+}
+
+long since_ns(Clock::time_point t) {
+    return chrono::duration_cast<chrono::nanoseconds>(Clock::now() - t).count();
+}
+
+// Body of a philosopher process; never returns.
+void philosopher(const string &name, int id, int crash) {
+    auto t0 = Clock::now();
+    shm::Table table;
+    if (!table.attach(name.c_str())) _exit(1);
+    table.set_attach_ns(id, since_ns(t0));
+    string me = "Philosopher " + to_string(id) + " (pid " + to_string(getpid()) + ")";
+
+    for (int meal = 0; meal < EAT_COUNT; meal++) {
+        table.pickup(id);
+        say(me + " picked up forks " + to_string(id) + " and " + to_string((id + 1) % N) + ".");
+        if (id == crash) {
+            say(me + " crashes while eating.");
+            raise(SIGKILL);
+        }
+        say(me + " is eating (meal " + to_string(meal + 1) + ").");
+        this_thread::sleep_for(chrono::milliseconds(100));
+        table.putdown(id);
+        say(me + " put down both forks.");
+        this_thread::sleep_for(chrono::milliseconds(50));
+    }
+    say(me + " is full and has finished eating.");
+    _exit(0);
+}
+
+// Forks one process per philosopher, each running body(name, id), which must not return.
+template <class Body>
+vector<pid_t> spawn(const string &name, int n, Body body) {
+    cout.flush();
+    vector<pid_t> pids;
+    for (int id = 0; id < n; id++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            exit(1);
+        }
+        if (pid == 0) body(name, id);
+        pids.push_back(pid);
+    }
+    return pids;
+}
+
+// Waits for every philosopher process; returns how many were killed by a signal.
+int reap(const vector<pid_t> &pids) {
+    int killed = 0;
+    for (size_t id = 0; id < pids.size(); id++) {
+        int status;
+        waitpid(pids[id], &status, 0);
+        if (WIFSIGNALED(status)) {
+            killed++;
+            say("Philosopher " + to_string(id) + " (pid " + to_string(pids[id]) + ") was killed by signal " +
+                to_string(WTERMSIG(status)) + ".");
+        }
+    }
+    return killed;
+}
+
+void demo(int crash) {
+    string name = "/dp_forks_" + to_string(getpid());
+    shm::Table table;
+    if (!table.create(name.c_str(), N)) exit(1);
+    cout << "Dining Philosophers (Mutex, forks in shared memory " << name << ")\n"
+         << N << " processes, " << EAT_COUNT << " meals each\n";
+
+    int killed = reap(spawn(name, N, [crash](const string &nm, int id) { philosopher(nm, id, crash); }));
+
+    shm::Header &h = table.header();
+    cout << "Meals:";
+    for (int i = 0; i < N; i++) cout << " " << table.seat(i).meals.load();
+    cout << "\nAttach (us):";
+    for (int i = 0; i < N; i++) cout << " " << table.seat(i).attach_ns.load() / 1000;
+    cout << "\nForks recovered from dead holders: " << h.recoveries.load()
+         << ", adjacency violations: " << h.violations.load() << "\n";
+    shm_unlink(name.c_str());
+    cout << (killed ? "All surviving philosophers are full and the program has completed.\n"
+                    : "All philosophers are full and the program has completed.\n");
+}
+
+// One bench meal: forks held for one yield, so neighbours really contend even on one CPU.
+template <class Forks>
+void eat_meals(Forks &forks, int id, int meals) {
+    for (int m = 0; m < meals; m++) {
+        forks.pickup(id);
+        sched_yield();
+        forks.putdown(id);
+    }
+}
+
+void row(const char *variant, long meals, double secs, long violations) {
+    cout << left << setw(34) << variant << right << fixed << setprecision(0) << setw(11) << meals / secs
+         << setw(12) << violations << "\n";
+}
+
+void bench(int n, int meals) {
+    string name = "/dp_forks_" + to_string(getpid());
+    long total = (long)n * meals;
+    cout << "Benchmark: " << n << " philosophers x " << meals << " meals\n"
+         << "variant                               meals/s  violations\n";
+    vector<long> attach;
+    {
+        shm::Table table;
+        if (!table.create(name.c_str(), n)) exit(1);
+        vector<pid_t> pids = spawn(name, n, [meals](const string &nm, int id) {
+            auto t0 = Clock::now();
+            shm::Table t;
+            if (!t.attach(nm.c_str())) _exit(1);
+            t.set_attach_ns(id, since_ns(t0));
+            t.arrive();
+            eat_meals(t, id, meals);
+            _exit(0);
+        });
+        if (!table.start(n, pids)) {
+            for (pid_t pid : pids) kill(pid, SIGKILL);
+            reap(pids);
+            shm_unlink(name.c_str());
+            exit(1);
+        }
+        auto start = Clock::now();
+        reap(pids);
+        row("processes, shm robust mutexes", total, since_ns(start) / 1e9, table.header().violations);
+        for (int i = 0; i < n; i++) attach.push_back(table.seat(i).attach_ns.load());
+        shm_unlink(name.c_str());
+    }
+    {
+        shm::Table table;
+        if (!table.create(name.c_str(), n)) exit(1);
+        vector<thread> th;
+        for (int id = 0; id < n; id++)
+            th.emplace_back([&, id] {
+                table.arrive();
+                eat_meals(table, id, meals);
+            });
+        table.start(n);
+        auto start = Clock::now();
+        for (auto &t : th) t.join();
+        row("threads, shm robust mutexes", total, since_ns(start) / 1e9, table.header().violations);
+        shm_unlink(name.c_str());
+    }
+    {
+        dp::OrderedForks forks(n);
+        atomic<int> arrived{0};
+        atomic<bool> go{false};
+        vector<thread> th;
+        for (int id = 0; id < n; id++)
+            th.emplace_back([&, id] {
+                arrived++;
+                while (!go.load(memory_order_acquire)) sched_yield();
+                eat_meals(forks, id, meals);
+            });
+        while (arrived.load() < n) sched_yield();
+        go.store(true, memory_order_release);
+        auto start = Clock::now();
+        for (auto &t : th) t.join();
+        row("threads, std::mutex (Mutex.cpp)", total, since_ns(start) / 1e9, 0);
+    }
+    sort(attach.begin(), attach.end());
+    cout << setprecision(1) << "attach per process: median " << attach[n / 2] / 1000.0 << " us, max "
+         << attach.back() / 1000.0 << " us\n";
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        int n = argc > 2 ? atoi(argv[2]) : 16;
+        int meals = argc > 3 ? atoi(argv[3]) : 20000;
+        if (n < 2 || meals < 1) {
+            cerr << "usage: " << argv[0] << " --bench [philosophers>=2] [meals>=1]\n";
+            return 1;
+        }
+        bench(n, meals);
+        return 0;
+    }
+    int crash = -1;
+    if (argc > 1 && !(argc == 3 && string(argv[1]) == "--crash" && (crash = atoi(argv[2])) >= 0 && crash < N)) {
+        cerr << "usage: " << argv[0] << " [--crash id] | --bench [philosophers] [meals]\n";
+        return 1;
+    }
+    demo(crash);
+    return 0;
+}
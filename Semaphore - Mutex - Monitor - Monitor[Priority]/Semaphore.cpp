@@ -6,7 +6,13 @@
 // Compile (Linux/GCC):
 //   g++ -std=c++17 dining_semaphore_fixed.cpp -pthread -O2 -o dining_semaphore_fixed
 // Run:
-//   ./dining_semaphore_fixed
+//   ./dining_semaphore_fixed [--placement none|compact|scatter|ring] [--service uniform|mixed]
+//   DP_STATS=1 ./dining_semaphore_fixed     (publish live counters, see Tools/stats_watch.cpp)
+//
+// --service gives each philosopher a service class from common/service.h. With "mixed",
+// a meal lasts a tenth of the usual 80-200 ms times the class scale (8-20 ms short,
+// 80-200 ms medium, 800-2000 ms long). Either way the run ends with each philosopher's
+// eating and waiting time, and how evenly the room shared out the waiting.
 
 #include <iostream>
 #include <vector>
@@ -16,6 +22,12 @@
 #include <chrono>
 #include <random>
 #include <memory>
+#include <string>
+#include <iomanip>
+#include "../common/stats_page.h"
+#include "../common/placement.h"
+#include "../common/service.h"
+#include "../common/safety.h"
 
 class Semaphore {
 private:
@@ -50,9 +62,14 @@ Semaphore room(NUM_PHILOSOPHERS - 1);     // waiter semaphore
 
 std::mutex cout_mtx;
 
+bool report_service = false;                 // --service given
+service::Mix service_mix = service::Mix::UNIFORM;
+std::vector<double> eat_ms(NUM_PHILOSOPHERS), wait_ms(NUM_PHILOSOPHERS);
+
 void philosopher(int id) {
     std::mt19937 rng((unsigned)std::chrono::high_resolution_clock::now().time_since_epoch().count() + id);
     std::uniform_int_distribution<int> dist(80, 200);
+    stats::Page &st = stats::page();
 
     for (int iter = 0; iter < EAT_TIMES; ++iter) {
         { // thinking
@@ -62,10 +79,14 @@ void philosopher(int id) {
         std::this_thread::sleep_for(std::chrono::milliseconds(dist(rng)));
 
         // Request permission from waiter (arbitrator)
+        st.set_state(id, stats::HUNGRY);
+        auto hungry = std::chrono::steady_clock::now();
         room.wait();
 
         // pick up left fork
         forks[id]->wait();
+        st.fork_held(id);
+        st.set_state(id, stats::HOLDING_ONE_FORK);
         {
             std::lock_guard<std::mutex> lg(cout_mtx);
             std::cout << "Philosopher " << id << " picked up left fork " << id << ".\n";
@@ -74,15 +95,25 @@ void philosopher(int id) {
         // pick up right fork
         int right = (id + 1) % NUM_PHILOSOPHERS;
         forks[right]->wait();
+        st.fork_held(right);
+        safety::checker().eat(id);
+        st.set_state(id, stats::EATING);
         {
             std::lock_guard<std::mutex> lg(cout_mtx);
             std::cout << "Philosopher " << id << " picked up right fork " << right << ".\n";
             std::cout << "Philosopher " << id << " is eating (round " << iter+1 << ").\n";
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(dist(rng)));
+        auto eating = std::chrono::steady_clock::now();
+        int eat = dist(rng);
+        if (service_mix == service::Mix::MIXED)
+            eat = eat * service::class_of(service_mix, id).scale / 10;
+        std::this_thread::sleep_for(std::chrono::milliseconds(eat));
+        wait_ms[id] += std::chrono::duration<double, std::milli>(eating - hungry).count();
+        eat_ms[id] += eat;
 
         // put down right, then left
+        safety::checker().done(id);
         forks[right]->signal();
         {
             std::lock_guard<std::mutex> lg(cout_mtx);
@@ -95,6 +126,9 @@ void philosopher(int id) {
             std::cout << "Philosopher " << id << " is full for round " << iter+1 << ".\n";
         }
 
+        st.meal(id);
+        st.set_state(id, stats::THINKING);
+
         // leave room (signal waiter)
         room.signal();
 
@@ -106,9 +140,31 @@ void philosopher(int id) {
     std::cout << "Philosopher " << id << " has finished all " << EAT_TIMES << " rounds.\n";
 }
 
-int main() {
+int main(int argc, char **argv) {
+    placement::Policy policy = placement::Policy::NONE;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        std::string val = a + 1 < argc ? argv[++a] : "";
+        bool ok = false;
+        if (arg == "--placement")
+            ok = placement::parse_policy(val, policy);
+        else if (arg == "--service")
+            ok = report_service = service::parse_mix(val, service_mix);
+        if (!ok) {
+            std::cerr << "usage: " << argv[0] << " [--placement none|compact|scatter|ring]"
+                      << " [--service uniform|mixed]\n";
+            return 1;
+        }
+    }
+    std::vector<int> cpus = placement::plan(policy, NUM_PHILOSOPHERS);
+
     std::cout << "Dining Philosophers (Arbitrator/Semaphore)\n";
     std::cout << "Each philosopher will eat " << EAT_TIMES << " times.\n";
+    if (policy != placement::Policy::NONE)
+        placement::describe(std::cout, policy, cpus);
+
+    stats::page().open("semaphore", NUM_PHILOSOPHERS);
+    safety::checker().open("semaphore", NUM_PHILOSOPHERS);
 
     // initialize forks as unique_ptr<Semaphore>
     forks.reserve(NUM_PHILOSOPHERS);
@@ -121,11 +177,26 @@ int main() {
     threads.reserve(NUM_PHILOSOPHERS);
     for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
         threads.emplace_back(philosopher, i);
+        placement::pin(threads.back(), cpus[i]);
     }
 
     // join
     for (auto &t : threads) t.join();
 
+    if (report_service) {
+        std::cout << "\nService: " << service::mix_name(service_mix) << "\n"
+                  << "philosopher  class    eating ms  waiting ms  wait per meal ms\n";
+        std::vector<double> per_meal(NUM_PHILOSOPHERS);
+        for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
+            per_meal[i] = wait_ms[i] / EAT_TIMES;
+            std::cout << std::setw(11) << i << "  " << std::left << std::setw(7)
+                      << service::class_of(service_mix, i).name << std::right << std::fixed
+                      << std::setprecision(0) << std::setw(11) << eat_ms[i] << std::setw(12)
+                      << wait_ms[i] << std::setw(18) << per_meal[i] << "\n";
+        }
+        std::cout << "Jain(wait per meal): " << std::setprecision(3) << service::jain(per_meal) << "\n";
+    }
+
     std::cout << "All philosophers finished. Program exiting normally.\n";
     return 0;
 }
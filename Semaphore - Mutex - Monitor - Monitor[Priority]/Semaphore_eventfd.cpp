@@ -0,0 +1,470 @@
+// semaphore_eventfd.cpp
+// Dining Philosophers on one epoll thread, with eventfd semaphores and forks
+// Same algorithm as Semaphore.cpp (a room of n - 1 seats, then left fork, then right
+// fork, put down right, left, leave the room), but nobody blocks: the room and every
+// fork is an eventfd from common/eventfd_sync.h, registered once with one epoll
+// instance, edge-triggered. A philosopher that cannot take what it needs joins that
+// resource's FIFO and the reactor moves on; when the fd fires, the reactor hands out
+// units to the queue head with try_acquire() until the count runs dry. Meals take one
+// pass of the reactor, so thousands of philosophers are driven from a single thread.
+//
+// Compile: g++ -std=c++17 -O2 Semaphore_eventfd.cpp -pthread -o semaphore_eventfd
+// Run:     ./semaphore_eventfd [philosophers] [meals]           (default 2000 x 10)
+//          ./semaphore_eventfd --bench [philosophers] [meals]
+//
+// --bench runs the same table four ways, a meal being one reactor pass or one yield, and
+// reports meals/s, wake latency (release of the awaited fork or seat -> the waiter has
+// it), syscalls and context switches per meal:
+//   eventfd reactor    this program
+//   eventfd threads    one thread per philosopher, blocking in poll() on the same fds
+//   cv semaphore       one thread per philosopher, Semaphore.cpp's mutex + cv semaphore
+//   cv monitor         one thread per philosopher, Monitor.cpp's pickup/putdown
+// eventfd syscalls are counted exactly. A futex call cannot be seen from user space, so
+// the cv rows count sleeps and the notifies that reached a sleeper: a lower bound.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "../common/eventfd_sync.h"
+#include "../common/safety.h"
+
+using Clock = std::chrono::steady_clock;
+
+long now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+long context_switches() {
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_nvcsw + ru.ru_nivcsw;
+}
+
+// What one run measured, whichever way it ran.
+struct Result {
+    double seconds = 0;
+    long meals = 0;
+    long syscalls = 0;          // exact for eventfd, futex lower bound for cv
+    long context_switches = 0;
+    std::vector<long> wake_ns;  // one sample per acquire that had to wait
+};
+
+class Reactor {
+    // Resources 0..n-1 are the forks, n is the room.
+    enum Stage { THINKING, NEED_ROOM, NEED_LEFT, NEED_RIGHT, HAS_FORKS, EATING, FULL };
+
+    int n, meals_each;
+    int ep;
+    std::vector<std::unique_ptr<efd::Fork>> forks;
+    efd::Semaphore room;
+    std::vector<std::deque<int>> waiters;   // per resource, FIFO
+    std::vector<long> released_at;          // oldest release not yet handed to a waiter
+    std::vector<Stage> stage;
+    std::vector<int> eaten;
+    std::vector<int> next;                  // philosophers to move on the next pass
+    int full = 0;
+    safety::Checker &safe;
+    Result &out;
+
+    int right(int i) const { return (i + 1) % n; }
+
+    bool try_take(int r) { return r < n ? forks[r]->try_pickup() : room.try_acquire(); }
+
+    void give_back(int r) {
+        if (!released_at[r]) released_at[r] = now_ns();
+        if (r < n) forks[r]->putdown();
+        else room.release();
+    }
+
+    // Nobody may overtake a queued philosopher, so the fd is only tried when the queue
+    // is empty; otherwise the release that fills the queue head is still to come.
+    bool take(int p, int r) {
+        if (waiters[r].empty() && try_take(r)) {
+            if (r < n) released_at[r] = 0;   // that release is used up; the room may hold more
+            return true;
+        }
+        waiters[r].push_back(p);
+        return false;
+    }
+
+    void advance(int p) {
+        switch (stage[p]) {
+            case THINKING:
+                stage[p] = NEED_ROOM;
+                // fall through
+            case NEED_ROOM:
+                if (!take(p, n)) return;
+                stage[p] = NEED_LEFT;
+                // fall through
+            case NEED_LEFT:
+                if (!take(p, p)) return;
+                stage[p] = NEED_RIGHT;
+                // fall through
+            case NEED_RIGHT:
+                if (!take(p, right(p))) return;
+                stage[p] = HAS_FORKS;
+                // fall through
+            case HAS_FORKS:
+                safe.eat(p);
+                stage[p] = EATING;
+                next.push_back(p);
+                return;
+            case EATING:
+                safe.done(p);
+                give_back(right(p));
+                give_back(p);
+                give_back(n);
+                out.meals++;
+                if (++eaten[p] == meals_each) {
+                    stage[p] = FULL;
+                    full++;
+                } else {
+                    stage[p] = THINKING;
+                    next.push_back(p);
+                }
+                return;
+            case FULL:
+                return;
+        }
+    }
+
+    // r's fd fired: hand out what is there, oldest waiter first. A fork holds at most
+    // one unit, so it is not read again to find it empty.
+    void drain(int r) {
+        for (bool more = true; more && !waiters[r].empty() && try_take(r); more = r == n) {
+            int p = waiters[r].front();
+            waiters[r].pop_front();
+            if (released_at[r]) out.wake_ns.push_back(now_ns() - released_at[r]);
+            released_at[r] = 0;
+            stage[p] = Stage(stage[p] + 1);
+            advance(p);
+        }
+    }
+
+public:
+    Reactor(int n, int meals_each, safety::Checker &safe, Result &out)
+        : n(n), meals_each(meals_each), ep(epoll_create1(EPOLL_CLOEXEC)), room(n - 1), waiters(n + 1),
+          released_at(n + 1, 0), stage(n, THINKING), eaten(n, 0), safe(safe), out(out) {
+        if (ep < 0) {
+            std::perror("epoll_create1");
+            std::exit(1);
+        }
+        for (int i = 0; i < n; i++) forks.emplace_back(std::make_unique<efd::Fork>());
+        for (int r = 0; r <= n; r++) {
+            epoll_event ev = {};
+            ev.events = EPOLLIN | EPOLLET;
+            ev.data.u32 = r;
+            if (epoll_ctl(ep, EPOLL_CTL_ADD, r < n ? forks[r]->fd() : room.fd(), &ev) != 0) {
+                std::perror("epoll_ctl");
+                std::exit(1);
+            }
+        }
+        out.syscalls += n + 1;
+    }
+    ~Reactor() { close(ep); }
+
+    void run() {
+        std::vector<epoll_event> events(256);
+        for (int i = 0; i < n; i++) next.push_back(i);
+        while (full < n) {
+            std::vector<int> pass;
+            pass.swap(next);
+            for (int p : pass) advance(p);
+            // Block only when nobody is eating or thinking; someone always is until the
+            // last philosopher is full, or the room would be short of a seat.
+            int k = epoll_wait(ep, events.data(), (int)events.size(), next.empty() ? -1 : 0);
+            out.syscalls++;
+            for (int e = 0; e < k; e++) drain(events[e].data.u32);
+        }
+    }
+};
+
+Result run_reactor(int n, int meals) {
+    Result r;
+    safety::Checker safe("semaphore_eventfd", n, safety::Threads::ONE);
+    Reactor reactor(n, meals, safe, r);
+    efd::syscalls().reset();
+    long csw0 = context_switches();
+    auto start = Clock::now();
+    reactor.run();
+    r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    r.context_switches = context_switches() - csw0;
+    r.syscalls += efd::syscalls().total();
+    return r;
+}
+
+// Semaphore.cpp's semaphore, recording when it was released to a sleeper and how
+// many futex calls that took at least.
+class CvSemaphore {
+    std::mutex mtx;
+    std::condition_variable cv;
+    int count;
+    int sleepers = 0;
+    long released_at = 0;
+
+public:
+    static std::atomic<long> futex_calls;
+
+    explicit CvSemaphore(int initial_count) : count(initial_count) {}
+
+    // Release -> return latency if it had to sleep, else -1.
+    long wait() {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (count > 0) {
+            --count;
+            return -1;
+        }
+        sleepers++;
+        futex_calls.fetch_add(1, std::memory_order_relaxed);
+        cv.wait(lock, [this] { return count > 0; });
+        sleepers--;
+        --count;
+        long w = now_ns() - released_at;
+        released_at = 0;
+        return w;
+    }
+    void signal() {
+        std::unique_lock<std::mutex> lock(mtx);
+        ++count;
+        if (sleepers) {
+            if (!released_at) released_at = now_ns();
+            futex_calls.fetch_add(1, std::memory_order_relaxed);
+        }
+        cv.notify_one();
+    }
+};
+
+std::atomic<long> CvSemaphore::futex_calls{0};
+
+// Monitor.cpp without the console, stamping each grant made to a sleeper.
+class CvMonitor {
+    enum State { THINKING, HUNGRY, EATING };
+    int n;
+    std::mutex m;
+    std::vector<std::condition_variable> self;
+    std::vector<State> state;
+    std::vector<bool> sleeping;
+    std::vector<long> granted_at;
+
+    int left(int i) { return (i + n - 1) % n; }
+    int right(int i) { return (i + 1) % n; }
+
+    void test(int i) {
+        if (state[i] == HUNGRY && state[left(i)] != EATING && state[right(i)] != EATING) {
+            state[i] = EATING;
+            if (sleeping[i]) {
+                granted_at[i] = now_ns();
+                futex_calls.fetch_add(1, std::memory_order_relaxed);
+            }
+            self[i].notify_one();
+        }
+    }
+
+public:
+    static std::atomic<long> futex_calls;
+
+    explicit CvMonitor(int n) : n(n), self(n), state(n, THINKING), sleeping(n, false), granted_at(n, 0) {}
+
+    long pickup(int i) {
+        std::unique_lock<std::mutex> lk(m);
+        state[i] = HUNGRY;
+        test(i);
+        if (state[i] == EATING) return -1;
+        sleeping[i] = true;
+        futex_calls.fetch_add(1, std::memory_order_relaxed);
+        while (state[i] != EATING) self[i].wait(lk);
+        sleeping[i] = false;
+        return now_ns() - granted_at[i];
+    }
+
+    void putdown(int i) {
+        std::unique_lock<std::mutex> lk(m);
+        state[i] = THINKING;
+        test(left(i));
+        test(right(i));
+    }
+};
+
+std::atomic<long> CvMonitor::futex_calls{0};
+
+// Runs body(id, samples) on one thread per philosopher, all released together.
+template <class Body>
+Result run_threads(int n, Body body) {
+    Result r;
+    std::vector<std::vector<long>> lat(n);
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> th;
+    for (int id = 0; id < n; id++)
+        th.emplace_back([&, id] {
+            ready++;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            body(id, lat[id]);
+        });
+    while (ready.load() < n) std::this_thread::yield();
+    long csw0 = context_switches();
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto &t : th) t.join();
+    r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    r.context_switches = context_switches() - csw0;
+    for (auto &v : lat) r.wake_ns.insert(r.wake_ns.end(), v.begin(), v.end());
+    return r;
+}
+
+Result run_eventfd_threads(int n, int meals) {
+    std::vector<std::unique_ptr<efd::Fork>> forks;
+    for (int i = 0; i < n; i++) forks.emplace_back(std::make_unique<efd::Fork>());
+    efd::Semaphore room(n - 1);
+    std::vector<std::atomic<long>> released_at(n + 1);
+    for (auto &t : released_at) t = 0;
+    safety::Checker safe("semaphore_eventfd threads", n);
+
+    // Blocks only if the fast try fails; then samples release -> acquired.
+    auto take = [&](int r, std::vector<long> &lat) {
+        bool got = r < n ? forks[r]->try_pickup() : room.try_acquire();
+        if (got) return;
+        if (r < n) forks[r]->pickup();
+        else room.acquire();
+        long at = released_at[r].exchange(0);
+        if (at) lat.push_back(now_ns() - at);
+    };
+    auto give_back = [&](int r) {
+        long zero = 0;
+        released_at[r].compare_exchange_strong(zero, now_ns());
+        if (r < n) forks[r]->putdown();
+        else room.release();
+    };
+
+    efd::syscalls().reset();
+    Result r = run_threads(n, [&](int id, std::vector<long> &lat) {
+        int right = (id + 1) % n;
+        for (int meal = 0; meal < meals; meal++) {
+            take(n, lat);
+            take(id, lat);
+            take(right, lat);
+            safe.eat(id);
+            std::this_thread::yield();
+            safe.done(id);
+            give_back(right);
+            give_back(id);
+            give_back(n);
+        }
+    });
+    r.meals = (long)n * meals;
+    r.syscalls = efd::syscalls().total();
+    return r;
+}
+
+Result run_cv_semaphore(int n, int meals) {
+    std::vector<std::unique_ptr<CvSemaphore>> forks;
+    for (int i = 0; i < n; i++) forks.emplace_back(std::make_unique<CvSemaphore>(1));
+    CvSemaphore room(n - 1);
+    safety::Checker safe("cv semaphore", n);
+    CvSemaphore::futex_calls = 0;
+    Result r = run_threads(n, [&](int id, std::vector<long> &lat) {
+        int right = (id + 1) % n;
+        for (int meal = 0; meal < meals; meal++) {
+            for (CvSemaphore *s : {&room, forks[id].get(), forks[right].get()}) {
+                long w = s->wait();
+                if (w >= 0) lat.push_back(w);
+            }
+            safe.eat(id);
+            std::this_thread::yield();
+            safe.done(id);
+            forks[right]->signal();
+            forks[id]->signal();
+            room.signal();
+        }
+    });
+    r.meals = (long)n * meals;
+    r.syscalls = CvSemaphore::futex_calls;
+    return r;
+}
+
+Result run_cv_monitor(int n, int meals) {
+    CvMonitor mon(n);
+    safety::Checker safe("cv monitor", n);
+    CvMonitor::futex_calls = 0;
+    Result r = run_threads(n, [&](int id, std::vector<long> &lat) {
+        for (int meal = 0; meal < meals; meal++) {
+            long w = mon.pickup(id);
+            if (w >= 0) lat.push_back(w);
+            safe.eat(id);
+            std::this_thread::yield();
+            safe.done(id);
+            mon.putdown(id);
+        }
+    });
+    r.meals = (long)n * meals;
+    r.syscalls = CvMonitor::futex_calls;
+    return r;
+}
+
+long percentile(std::vector<long> &v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+void print_row(const char *name, Result r) {
+    std::cout << std::left << std::setw(18) << name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(11) << r.meals / r.seconds << std::setw(10) << r.wake_ns.size()
+              << std::setw(12) << percentile(r.wake_ns, 0.50) << std::setw(12) << percentile(r.wake_ns, 0.99)
+              << std::setprecision(2) << std::setw(15) << (double)r.syscalls / r.meals << std::setw(10)
+              << (double)r.context_switches / r.meals << "\n";
+}
+
+int main(int argc, char **argv) {
+    bool bench = argc > 1 && std::string(argv[1]) == "--bench";
+    int a = bench ? 2 : 1;
+    int n = argc > a ? std::atoi(argv[a]) : 2000;
+    int meals = argc > a + 1 ? std::atoi(argv[a + 1]) : (bench ? 20 : 10);
+    if (n < 2 || meals < 1) {
+        std::cerr << "usage: " << argv[0] << " [--bench] [philosophers>=2] [meals>=1]\n";
+        return 1;
+    }
+    // One eventfd per fork, plus the room and the epoll instance.
+    long limit = efd::raise_fd_limit();
+    if (limit >= 0 && n + 64 > limit) {
+        std::cerr << n << " philosophers need more than the " << limit << " descriptors allowed\n";
+        return 1;
+    }
+
+    if (!bench) {
+        std::cout << "Dining Philosophers (Semaphore on eventfd, one epoll thread)\n"
+                  << n << " philosophers, " << meals << " meals each\n";
+        Result r = run_reactor(n, meals);
+        std::cout << std::fixed << std::setprecision(3) << r.meals << " meals in " << r.seconds << " s ("
+                  << std::setprecision(0) << r.meals / r.seconds << " meals/s)\n"
+                  << r.wake_ns.size() << " waits, wake latency p50 " << percentile(r.wake_ns, 0.50)
+                  << " ns, p99 " << percentile(r.wake_ns, 0.99) << " ns\n"
+                  << std::setprecision(2) << (double)r.syscalls / r.meals << " syscalls per meal\n"
+                  << "All philosophers finished. Program exiting normally.\n";
+        return 0;
+    }
+
+    std::cout << "Benchmark: " << n << " philosophers x " << meals << " meals (room + forks, empty meals)\n"
+              << "variant               meals/s     waits  wake p50 ns  wake p99 ns  syscalls/meal  csw/meal\n";
+    print_row("eventfd reactor", run_reactor(n, meals));
+    print_row("eventfd threads", run_eventfd_threads(n, meals));
+    print_row("cv semaphore", run_cv_semaphore(n, meals));
+    print_row("cv monitor", run_cv_monitor(n, meals));
+    std::cout << "cv syscalls are futex sleeps and wakes of sleepers only (a lower bound)\n";
+    return 0;
+}
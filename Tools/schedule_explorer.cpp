@@ -0,0 +1,515 @@
+// schedule_explorer.cpp
+// Deterministic schedule exploration for the threaded variants. The primitives from
+// common/primitives.h are instantiated with the cooperative mutex / condition variable
+// from common/coop.h, every philosopher becomes a fiber, and a chooser decides who runs
+// at each lock, each start of a meal and each end of a meal. Every run is checked for
+//   - neighbours eating at the same time
+//   - deadlock (every unfinished philosopher blocked)
+// and the run with the longest hungry-to-eating wait (in scheduling steps) is kept as
+// the slowest schedule. Any run can be replayed with --replay and the printed trace
+// (the steps where the schedule left the current philosopher, and for whom), which
+// also prints every scheduling point.
+//
+// Scenarios:
+//   semaphore  arbitrator with a room semaphore of n - 1 and a semaphore per fork (Semaphore.cpp)
+//   monitor    Monitor::pickup/putdown (Monitor.cpp)
+//   priority   PriorityMonitor::pickup/putdown (Monitor_priority.cpp)
+//   mutex      ordered fork mutexes (Mutex.cpp)
+//   naive      every philosopher locks left then right (deadlock_thread.cpp); deadlocks
+// Strategies:
+//   pct        randomized priority scheduling with `depth` - 1 priority change points;
+//              run k uses seed + k, so --seed S --schedules 1 repeats a single run
+//   random     uniformly random runnable philosopher at every point
+//   dfs        every schedule with at most --preemptions preemptions (default n - 1,
+//              enough to move the schedule on at every philosopher around the ring),
+//              depth first, pruning states already reached (happens-before
+//              fingerprints, see coop.h). The bound is raised one at a time from 0 and
+//              each bound is searched in full first, so schedules needing the fewest
+//              preemptions come first and a large bound does not bury them
+//
+// Compile: g++ -std=c++17 -O2 schedule_explorer.cpp -o schedule_explorer
+// Run:     ./schedule_explorer [--scenario s] [--strategy pct|random|dfs] [--philosophers n]
+//                              [--meals m] [--schedules k] [--seed s] [--depth d]
+//                              [--preemptions c] [--no-cache] [--keep-going] [--replay trace]
+// Exits with status 2 when a run fails, so it can gate a merge.
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdlib>
+#include "../common/coop.h"
+#include "../common/primitives.h"
+
+using coop::Scheduler;
+using Bodies = std::vector<std::function<void()>>;
+
+// Harness-side view of the table, shared by every scenario.
+struct Table {
+    int n;
+    std::vector<int> eating;
+    std::vector<long> hungry_at;
+    std::vector<uint64_t> fork_hb;     // orders neighbouring meals for the fingerprint
+    long worst_wait = 0;
+    int worst_philosopher = -1;
+
+    explicit Table(int n) : n(n), eating(n, 0), hungry_at(n, 0), fork_hb(n, 0) {}
+
+    void hungry(int i) { hungry_at[i] = Scheduler::current()->steps(); }
+
+    void eat(int i) {
+        Scheduler &s = *Scheduler::current();
+        int left = (i + n - 1) % n, right = (i + 1) % n;
+        s.point("eat");
+        s.sync(fork_hb[i], 7);
+        s.sync(fork_hb[right], 7);
+        for (int j : {left, right})
+            if (eating[j])
+                s.fail("philosophers " + std::to_string(std::min(i, j)) + " and " +
+                       std::to_string(std::max(i, j)) + " eat at the same time");
+        eating[i] = 1;
+        long wait = s.steps() - hungry_at[i];
+        if (wait > worst_wait) {
+            worst_wait = wait;
+            worst_philosopher = i;
+        }
+        s.point("done eating");
+        s.sync(fork_hb[i], 8);
+        s.sync(fork_hb[right], 8);
+        eating[i] = 0;
+    }
+};
+
+// One run's table, the primitives under test and the philosopher bodies.
+struct Run {
+    Table table;
+    std::shared_ptr<void> keep;
+    Bodies bodies;
+
+    explicit Run(int n) : table(n) {}
+};
+
+template <class Forks>
+void pickup_putdown(Run &run, int meals) {
+    auto forks = std::make_shared<Forks>(run.table.n);
+    run.keep = forks;
+    for (int i = 0; i < run.table.n; i++)
+        run.bodies.push_back([&t = run.table, f = forks.get(), i, meals] {
+            for (int m = 0; m < meals; m++) {
+                t.hungry(i);
+                f->pickup(i);
+                t.eat(i);
+                f->putdown(i);
+            }
+        });
+}
+
+void semaphore_arbitrator(Run &run, int meals) {
+    using Semaphore = dp::BasicSemaphore<coop::Sync>;
+    struct Sems {
+        Semaphore room;
+        std::vector<std::unique_ptr<Semaphore>> forks;
+        explicit Sems(int n) : room(n - 1) {
+            for (int i = 0; i < n; i++) forks.emplace_back(new Semaphore(1));
+        }
+    };
+    int n = run.table.n;
+    auto sems = std::make_shared<Sems>(n);
+    run.keep = sems;
+    for (int i = 0; i < n; i++)
+        run.bodies.push_back([&t = run.table, s = sems.get(), i, n, meals] {
+            for (int m = 0; m < meals; m++) {
+                t.hungry(i);
+                s->room.wait();
+                s->forks[i]->wait();
+                s->forks[(i + 1) % n]->wait();
+                t.eat(i);
+                s->forks[(i + 1) % n]->signal();
+                s->forks[i]->signal();
+                s->room.signal();
+            }
+        });
+}
+
+void naive_forks(Run &run, int meals) {
+    int n = run.table.n;
+    auto forks = std::shared_ptr<coop::mutex[]>(new coop::mutex[n]);
+    run.keep = forks;
+    for (int i = 0; i < n; i++)
+        run.bodies.push_back([&t = run.table, f = forks.get(), i, n, meals] {
+            for (int m = 0; m < meals; m++) {
+                t.hungry(i);
+                f[i].lock();
+                f[(i + 1) % n].lock();
+                t.eat(i);
+                f[(i + 1) % n].unlock();
+                f[i].unlock();
+            }
+        });
+}
+
+struct Scenario {
+    const char *name;
+    void (*setup)(Run &, int meals);
+};
+
+const Scenario SCENARIOS[] = {
+    {"semaphore", semaphore_arbitrator},
+    {"monitor", pickup_putdown<dp::BasicMonitor<coop::Sync>>},
+    {"priority", pickup_putdown<dp::BasicPriorityMonitor<coop::Sync>>},
+    {"mutex", pickup_putdown<dp::BasicOrderedForks<coop::Sync>>},
+    {"naive", naive_forks},
+};
+
+// Keep running whoever reached the point; otherwise the lowest runnable id.
+int default_choice(const std::vector<int> &runnable, int last) {
+    return std::binary_search(runnable.begin(), runnable.end(), last) ? last : runnable[0];
+}
+
+class RandomChooser : public coop::Chooser {
+    std::mt19937_64 rng;
+
+public:
+    explicit RandomChooser(uint64_t seed) : rng(seed) {}
+    int choose(const std::vector<int> &runnable, int, long, uint64_t) override {
+        return runnable[std::uniform_int_distribution<size_t>(0, runnable.size() - 1)(rng)];
+    }
+};
+
+// PCT: distinct random priorities >= depth - 1, highest runnable goes first; at each of
+// depth - 1 random steps the philosopher that just ran drops to priority j.
+class PctChooser : public coop::Chooser {
+    std::vector<int> priority;
+    std::vector<long> change_at;
+
+public:
+    PctChooser(uint64_t seed, int n, int depth, long expected_steps) : priority(n) {
+        std::mt19937_64 rng(seed);
+        for (int i = 0; i < n; i++) priority[i] = depth - 1 + i;
+        std::shuffle(priority.begin(), priority.end(), rng);
+        std::uniform_int_distribution<long> step(1, expected_steps);
+        for (int j = 0; j + 1 < depth; j++) change_at.push_back(step(rng));
+    }
+
+    int choose(const std::vector<int> &runnable, int last, long step, uint64_t) override {
+        for (size_t j = 0; j < change_at.size(); j++)
+            if (change_at[j] == step && last >= 0) priority[last] = (int)j;
+        int best = runnable[0];
+        for (int f : runnable)
+            if (priority[f] > priority[best]) best = f;
+        return best;
+    }
+};
+
+// Depth-first enumeration of schedules with a preemption bound. Only points with a
+// real choice are kept on the stack; each new run replays the stack and extends it
+// with default choices. The bound goes from 0 up to `limit`; each round starts over
+// (repeating the schedules of the rounds before it) with an empty state cache, since
+// a state reached before had less budget left than it has now.
+class DfsChooser : public coop::Chooser {
+    struct Point {
+        std::vector<int> order;    // default choice first, then the other runnable ids
+        int last;
+        int preemptions;           // used before this point
+        size_t index = 0;
+    };
+
+    std::vector<Point> stack;
+    std::unordered_map<uint64_t, int> visited;
+    size_t pos = 0;
+    int preemptions = 0;
+    int bound = 0;
+    int limit;
+    bool cache;
+
+    static int cost(const Point &p, int choice) {
+        return p.last >= 0 && choice != p.last &&
+               std::find(p.order.begin(), p.order.end(), p.last) != p.order.end();
+    }
+
+public:
+    long pruned = 0;
+
+    DfsChooser(int limit, bool cache) : limit(limit), cache(cache) {}
+
+    int current_bound() const { return bound; }
+
+    int choose(const std::vector<int> &runnable, int last, long, uint64_t fingerprint) override {
+        if (pos < stack.size() && runnable.size() > 1) {
+            const Point &p = stack[pos++];
+            int c = p.order[p.index];
+            preemptions = p.preemptions + cost(p, c);
+            return c;
+        }
+        if (pos < stack.size()) return runnable[0];
+
+        if (cache) {
+            uint64_t key = coop::mix(fingerprint, (uint64_t)(last + 1));
+            auto it = visited.find(key);
+            if (it != visited.end() && it->second <= preemptions) {
+                pruned++;
+                return -1;
+            }
+            visited[key] = preemptions;
+        }
+        int d = default_choice(runnable, last);
+        if (runnable.size() == 1) return d;
+        Point p{{d}, last, preemptions};
+        for (int f : runnable)
+            if (f != d) p.order.push_back(f);
+        stack.push_back(p);
+        pos++;
+        return d;
+    }
+
+    // Moves to the next unexplored schedule; false when the search is complete.
+    bool advance() {
+        pos = 0;
+        preemptions = 0;
+        while (!stack.empty()) {
+            Point &p = stack.back();
+            while (++p.index < p.order.size())
+                if (p.preemptions + cost(p, p.order[p.index]) <= bound) return true;
+            stack.pop_back();
+        }
+        if (bound == limit) return false;
+        bound++;
+        visited.clear();
+        return true;
+    }
+};
+
+// Follows a recorded trace: the listed steps go to the listed philosopher, all others
+// take the default choice.
+class ReplayChooser : public coop::Chooser {
+    std::unordered_map<long, int> at;
+
+public:
+    explicit ReplayChooser(const std::vector<std::pair<long, int>> &trace) {
+        for (auto &e : trace) at[e.first] = e.second;
+    }
+    int choose(const std::vector<int> &runnable, int last, long step, uint64_t) override {
+        auto it = at.find(step);
+        if (it != at.end() && std::binary_search(runnable.begin(), runnable.end(), it->second))
+            return it->second;
+        return default_choice(runnable, last);
+    }
+};
+
+// Wraps a chooser and keeps the steps where it deviated from the default choice.
+class Recorder : public coop::Chooser {
+    coop::Chooser &inner;
+
+public:
+    std::vector<std::pair<long, int>> trace;
+
+    explicit Recorder(coop::Chooser &inner) : inner(inner) {}
+    int choose(const std::vector<int> &runnable, int last, long step, uint64_t fp) override {
+        int c = inner.choose(runnable, last, step, fp);
+        if (c >= 0 && c != default_choice(runnable, last)) trace.emplace_back(step, c);
+        return c;
+    }
+};
+
+std::string format_trace(const std::vector<std::pair<long, int>> &trace) {
+    if (trace.empty()) return "-";
+    std::ostringstream out;
+    for (size_t i = 0; i < trace.size(); i++)
+        out << (i ? "," : "") << trace[i].first << ":" << trace[i].second;
+    return out.str();
+}
+
+bool parse_trace(const std::string &s, std::vector<std::pair<long, int>> &out) {
+    if (s == "-") return true;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+        out.emplace_back(std::atol(item.substr(0, colon).c_str()), std::atoi(item.substr(colon + 1).c_str()));
+    }
+    return true;
+}
+
+struct Options {
+    const Scenario *scenario = &SCENARIOS[1];
+    std::string strategy = "pct";
+    int philosophers = 5;
+    int meals = 2;
+    long schedules = 2000;
+    uint64_t seed = 1;
+    int depth = 3;
+    int preemptions = -1;   // n - 1
+    bool cache = true;
+    bool keep_going = false;
+    bool replay = false;
+    std::vector<std::pair<long, int>> trace;
+};
+
+std::string replay_command(const Options &opt, const std::string &trace) {
+    std::ostringstream out;
+    out << "./schedule_explorer --scenario " << opt.scenario->name << " --philosophers "
+        << opt.philosophers << " --meals " << opt.meals << " --replay " << trace;
+    return out.str();
+}
+
+const char *outcome_name(coop::Outcome o) {
+    switch (o) {
+        case coop::Outcome::DONE:      return "completed";
+        case coop::Outcome::DEADLOCK:  return "deadlocked";
+        case coop::Outcome::FAILED:    return "failed";
+        case coop::Outcome::ABANDONED: return "abandoned";
+    }
+    return "?";
+}
+
+int replay(const Options &opt, Scheduler &sched) {
+    Run run(opt.philosophers);
+    opt.scenario->setup(run, opt.meals);
+    sched.trace = [](long step, int fiber, const char *what) {
+        std::cout << "step " << std::setw(5) << step << ": philosopher " << fiber << " " << what << "\n";
+    };
+    ReplayChooser chooser(opt.trace);
+    coop::Outcome o = sched.run(std::move(run.bodies), chooser);
+    std::cout << "Run " << outcome_name(o) << " after " << sched.steps() << " steps";
+    if (!sched.failure_message().empty()) std::cout << ": " << sched.failure_message();
+    std::cout << "\nLongest hungry-to-eating wait: " << run.table.worst_wait << " steps (philosopher "
+              << run.table.worst_philosopher << ")\n";
+    return o == coop::Outcome::DONE ? 0 : 2;
+}
+
+int explore(const Options &opt, Scheduler &sched) {
+    std::cout << "Scenario " << opt.scenario->name << ", " << opt.philosophers << " philosophers x "
+              << opt.meals << " meals, strategy " << opt.strategy;
+    if (opt.strategy == "pct") std::cout << " (depth " << opt.depth << ")";
+    if (opt.strategy == "dfs") std::cout << " (up to " << opt.preemptions << " preemptions"
+                                         << (opt.cache ? ", state cache" : "") << ")";
+    std::cout << ", seed " << opt.seed << "\n";
+
+    // PCT spreads its change points over the length of one default-order run, so that
+    // a seed alone pins down the schedule.
+    long expected_steps = 1;
+    {
+        Run run(opt.philosophers);
+        opt.scenario->setup(run, opt.meals);
+        ReplayChooser plain({});
+        sched.run(std::move(run.bodies), plain);
+        expected_steps = std::max(1L, sched.steps());
+    }
+
+    DfsChooser dfs(opt.preemptions, opt.cache);
+    std::unordered_set<uint64_t> distinct;
+    long runs = 0, failures = 0, worst_wait = -1;
+    std::string worst_trace;
+    uint64_t worst_seed = 0;
+    bool complete = false;
+
+    auto start = std::chrono::steady_clock::now();
+    for (long k = 0; k < opt.schedules; k++) {
+        Run run(opt.philosophers);
+        opt.scenario->setup(run, opt.meals);
+        uint64_t seed = opt.seed + k;
+        std::unique_ptr<coop::Chooser> owned;
+        coop::Chooser *inner = &dfs;
+        if (opt.strategy == "random") inner = (owned.reset(new RandomChooser(seed)), owned.get());
+        if (opt.strategy == "pct")
+            inner = (owned.reset(new PctChooser(seed, opt.philosophers, opt.depth, expected_steps)), owned.get());
+        Recorder rec(*inner);
+        coop::Outcome o = sched.run(std::move(run.bodies), rec);
+        runs++;
+        if (o != coop::Outcome::ABANDONED) distinct.insert(sched.fingerprint());
+        if (o == coop::Outcome::DEADLOCK || o == coop::Outcome::FAILED) {
+            failures++;
+            std::cout << "Schedule " << k;
+            if (opt.strategy != "dfs") std::cout << " (seed " << seed << ")";
+            std::cout << " " << outcome_name(o) << ": " << sched.failure_message() << "\n"
+                      << "  replay: " << replay_command(opt, format_trace(rec.trace)) << "\n";
+            if (!opt.keep_going) break;
+        }
+        if (run.table.worst_wait > worst_wait) {
+            worst_wait = run.table.worst_wait;
+            worst_trace = format_trace(rec.trace);
+            worst_seed = seed;
+        }
+        if (opt.strategy == "dfs" && !dfs.advance()) {
+            complete = true;
+            break;
+        }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(3) << runs << " schedules in " << secs << " s ("
+              << std::setprecision(0) << runs / std::max(secs, 1e-9) << "/s), "
+              << distinct.size() << " distinct end states, " << failures << " failures\n";
+    if (opt.strategy == "dfs")
+        std::cout << dfs.pruned << " cut short by the state cache, search "
+                  << (complete ? "complete" : failures && !opt.keep_going ? "stopped at the first failure"
+                                                                          : "stopped at --schedules")
+                  << " (preemption bound " << dfs.current_bound() << ")\n";
+    if (worst_wait >= 0) {
+        std::cout << "Slowest schedule: " << worst_wait << " steps from hungry to eating";
+        if (opt.strategy != "dfs") std::cout << " (seed " << worst_seed << ")";
+        std::cout << "\n  replay: " << replay_command(opt, worst_trace) << "\n";
+    }
+    return failures ? 2 : 0;
+}
+
+void usage(const char *prog) {
+    std::cerr << "usage: " << prog << " [--scenario semaphore|monitor|priority|mutex|naive]"
+              << " [--strategy pct|random|dfs] [--philosophers n] [--meals m] [--schedules k]"
+              << " [--seed s] [--depth d] [--preemptions c] [--no-cache] [--keep-going]"
+              << " [--replay trace]\n";
+    std::exit(1);
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--no-cache") { opt.cache = false; continue; }
+        if (arg == "--keep-going") { opt.keep_going = true; continue; }
+        if (a + 1 >= argc) usage(argv[0]);
+        std::string val = argv[++a];
+        if (arg == "--scenario") {
+            opt.scenario = nullptr;
+            for (const Scenario &s : SCENARIOS)
+                if (val == s.name) opt.scenario = &s;
+            if (!opt.scenario) usage(argv[0]);
+        } else if (arg == "--strategy") {
+            if (val != "pct" && val != "random" && val != "dfs") usage(argv[0]);
+            opt.strategy = val;
+        } else if (arg == "--philosophers") {
+            opt.philosophers = std::atoi(val.c_str());
+        } else if (arg == "--meals") {
+            opt.meals = std::atoi(val.c_str());
+        } else if (arg == "--schedules") {
+            opt.schedules = std::atol(val.c_str());
+        } else if (arg == "--seed") {
+            char *end;
+            opt.seed = std::strtoull(val.c_str(), &end, 10);
+            if (val.empty() || *end) usage(argv[0]);
+        } else if (arg == "--depth") {
+            opt.depth = std::atoi(val.c_str());
+        } else if (arg == "--preemptions") {
+            opt.preemptions = std::atoi(val.c_str());
+            if (opt.preemptions < 0) usage(argv[0]);
+        } else if (arg == "--replay") {
+            opt.replay = true;
+            if (!parse_trace(val, opt.trace)) usage(argv[0]);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (opt.philosophers < 2 || opt.meals < 1 || opt.schedules < 1 || opt.depth < 1) usage(argv[0]);
+    if (opt.preemptions < 0) opt.preemptions = opt.philosophers - 1;
+
+    Scheduler sched;
+    return opt.replay ? replay(opt, sched) : explore(opt, sched);
+}
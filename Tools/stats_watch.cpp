@@ -0,0 +1,142 @@
+// stats_watch.cpp
+// Attaches read-only to a running program's stats page (see common/stats_page.h)
+// and prints per-philosopher meal rates, states, fork hold counts and the turn number.
+// The watched program is never touched: the segment is mapped PROT_READ.
+//
+// Compile: g++ -std=c++17 -O2 stats_watch.cpp -o stats_watch
+// Run:     DP_STATS=1 ./monitor_output &        (prints "stats: publishing to /dp_stats_<pid>")
+//          ./stats_watch /dp_stats_<pid> [interval_ms] [samples]
+//          ./stats_watch --list
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <dirent.h>
+#include <signal.h>
+#include "../common/stats_page.h"
+
+// Prints every segment in /dev/shm that carries a stats page header.
+void list_segments() {
+    DIR *d = opendir("/dev/shm");
+    if (!d) {
+        std::perror("/dev/shm");
+        return;
+    }
+    while (dirent *e = readdir(d)) {
+        std::string name = std::string("/") + e->d_name;
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) continue;
+        stats::Header hdr;
+        bool ok = pread(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr) &&
+                  hdr.magic == stats::MAGIC;
+        close(fd);
+        if (ok)
+            std::cout << name << "  " << hdr.strategy << " (pid " << hdr.pid << ", "
+                      << hdr.philosophers << " philosophers)\n";
+    }
+    closedir(d);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <segment> [interval_ms] [samples]\n"
+                  << "       " << argv[0] << " --list\n";
+        return 1;
+    }
+    if (std::string(argv[1]) == "--list") {
+        list_segments();
+        return 0;
+    }
+    int interval_ms = argc > 2 ? std::atoi(argv[2]) : 1000;
+    int samples = argc > 3 ? std::atoi(argv[3]) : -1;   // -1: until the writer exits
+    if (interval_ms <= 0) interval_ms = 1000;
+
+    int fd = shm_open(argv[1], O_RDONLY, 0);
+    if (fd < 0) {
+        std::perror(argv[1]);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(stats::Header)) {
+        std::cerr << argv[1] << ": not a stats page\n";
+        return 1;
+    }
+    void *mem = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        std::perror("mmap");
+        return 1;
+    }
+
+    // A writer stamps magic and version as soon as the segment is sized, so anything
+    // but zero (not written yet) or MAGIC is someone else's segment: refuse it before
+    // waiting. Then give the writer up to a second to set ready.
+    stats::Header *hdr = static_cast<stats::Header *>(mem);
+    auto unsupported = [&] {
+        std::cerr << argv[1] << ": unsupported stats page\n";
+        return 1;
+    };
+    if (hdr->magic != 0 && (hdr->magic != stats::MAGIC || hdr->version != stats::VERSION)) return unsupported();
+    for (int tries = 0; !hdr->ready.load(std::memory_order_acquire) && tries < 100; tries++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (!hdr->ready.load(std::memory_order_acquire) || hdr->magic != stats::MAGIC ||
+        hdr->version != stats::VERSION || (size_t)st.st_size < stats::segment_size(hdr->philosophers))
+        return unsupported();
+
+    const uint32_t n = hdr->philosophers;
+    stats::PhilosopherSlot *phil = stats::philosopher_slots(hdr);
+    stats::ForkSlot *forks = stats::fork_slots(hdr);
+    std::cout << "Watching " << hdr->strategy << " (pid " << hdr->pid << ", "
+              << n << " philosophers)\n";
+
+    std::vector<uint64_t> last_meals(n), last_holds(n);
+    for (uint32_t i = 0; i < n; i++) {
+        last_meals[i] = phil[i].meals.load(std::memory_order_relaxed);
+        last_holds[i] = forks[i].holds.load(std::memory_order_relaxed);
+    }
+    uint64_t last_turn = hdr->turn.load(std::memory_order_relaxed);
+    uint64_t last_ns = stats::now_ns();
+
+    for (int s = 0; samples < 0 || s < samples; s++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+        uint64_t now = stats::now_ns();
+        double secs = (now - last_ns) / 1e9;
+        last_ns = now;
+
+        uint64_t turn = hdr->turn.load(std::memory_order_relaxed);
+        uint64_t total_meals = 0;
+        double total_rate = 0;
+        std::cout << "\n[t=" << std::fixed << std::setprecision(1)
+                  << (now - hdr->start_ns) / 1e9 << "s] turn " << turn
+                  << " (" << (turn - last_turn) / secs << " turns/s)\n";
+        last_turn = turn;
+
+        for (uint32_t i = 0; i < n; i++) {
+            uint64_t meals = phil[i].meals.load(std::memory_order_relaxed);
+            uint64_t holds = forks[i].holds.load(std::memory_order_relaxed);
+            double meal_rate = (meals - last_meals[i]) / secs;
+            double hold_rate = (holds - last_holds[i]) / secs;
+            std::cout << "  Philosopher " << std::setw(3) << i << " "
+                      << std::setw(8) << stats::state_name(phil[i].state.load(std::memory_order_relaxed))
+                      << "  meals " << std::setw(8) << meals
+                      << " (" << std::setw(8) << meal_rate << "/s)"
+                      << "  fork " << std::setw(3) << i << " holds " << std::setw(8) << holds
+                      << " (" << std::setw(8) << hold_rate << "/s)\n";
+            last_meals[i] = meals;
+            last_holds[i] = holds;
+            total_meals += meals;
+            total_rate += meal_rate;
+        }
+        std::cout << "  Total meals " << total_meals << " (" << total_rate << "/s)\n";
+
+        if (kill(hdr->pid, 0) != 0) {
+            std::cout << "Writer has exited.\n";
+            break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+// trace_convert.cpp
+// Builds a replay trace (common/trace.h) from CSV, one event per line:
+//   turn,philosopher,eat
+// the turn the philosopher gets hungry and its meal length in turns, sorted by turn.
+// A first line that does not start with a digit is taken as a header; blank lines and
+// lines starting with '#' are skipped. The CSV is mapped and parsed in place, straight
+// into the mapped output columns, so a 10^8-line file converts without holding either
+// in memory. Philosophers are counted from the largest index unless --philosophers
+// says otherwise.
+//
+// Compile: g++ -std=c++17 -O2 trace_convert.cpp -o trace_convert
+// Run:     ./trace_convert arrivals.csv arrivals.dptr [--philosophers n]
+//          (unsorted input: sort -t, -k1,1n arrivals.csv > sorted.csv first)
+
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "../common/trace.h"
+
+[[noreturn]] void fail(long line, const char *what) {
+    std::fprintf(stderr, "trace_convert: line %ld: %s\n", line, what);
+    std::exit(1);
+}
+
+// Reads an unsigned decimal at p, leaving p after it.
+bool number(const char *&p, const char *end, uint64_t &v) {
+    if (p == end || *p < '0' || *p > '9') return false;
+    v = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (v > (UINT64_MAX - 9) / 10) return false;
+        v = v * 10 + (uint64_t)(*p - '0');
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3 && !(argc == 5 && std::string(argv[3]) == "--philosophers")) {
+        std::cerr << "usage: " << argv[0] << " <in.csv> <out.dptr> [--philosophers n]\n";
+        return 1;
+    }
+    long philosophers = argc == 5 ? std::atol(argv[4]) : 0;
+    if (argc == 5 && (philosophers < 2 || philosophers > INT32_MAX)) {
+        std::cerr << argv[0] << ": --philosophers must be at least 2\n";
+        return 1;
+    }
+
+    int fd = open(argv[1], O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        std::perror(argv[1]);
+        return 1;
+    }
+    size_t bytes = st.st_size;
+    const char *csv = "";
+    if (bytes) {
+        void *m = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) {
+            std::perror("trace_convert: mmap");
+            return 1;
+        }
+        madvise(m, bytes, MADV_SEQUENTIAL);
+        csv = static_cast<const char *>(m);
+    }
+    close(fd);
+    const char *end = csv + bytes;
+
+    // Every line could be an event; the columns are sized for that.
+    size_t lines = 0;
+    for (const char *p = csv; (p = static_cast<const char *>(std::memchr(p, '\n', end - p))); p++) lines++;
+    if (bytes && end[-1] != '\n') lines++;
+
+    trace::Builder out(argv[2], lines);
+    uint64_t *turn = out.turns();
+    uint32_t *who = out.who(), *eat = out.eat();
+    size_t events = 0;
+    uint64_t last = 0, top = 0;
+    long line = 0;
+    for (const char *p = csv; p < end;) {
+        const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+        line++;
+        const char *q = p;
+        p = eol + 1;
+        if (eol > q && eol[-1] == '\r') eol--;
+        if (q == eol || *q == '#') continue;
+        if (line == 1 && (*q < '0' || *q > '9')) continue;   // header
+        uint64_t t, i, e;
+        if (!number(q, eol, t) || q == eol || *q++ != ',' || !number(q, eol, i) || q == eol || *q++ != ',' ||
+            !number(q, eol, e) || q != eol)
+            fail(line, "expected turn,philosopher,eat");
+        if (t < last) fail(line, "turns go backwards (sort by the first column)");
+        if (t > INT64_MAX / 2) fail(line, "turn out of range");
+        if (i >= INT32_MAX || (philosophers && i >= (uint64_t)philosophers)) fail(line, "philosopher out of range");
+        if (e > UINT32_MAX) fail(line, "meal length out of range");
+        last = t;
+        top = std::max(top, i);
+        turn[events] = t;
+        who[events] = (uint32_t)i;
+        eat[events] = (uint32_t)e;
+        events++;
+    }
+    if (!philosophers) philosophers = std::max<long>(2, (long)top + 1);
+    out.finish(events, (int)philosophers);
+    std::cout << argv[2] << ": " << events << " events, " << philosophers << " philosophers, turns "
+              << (events ? turn[0] : 0) << ".." << last << "\n";
+    return 0;
+}
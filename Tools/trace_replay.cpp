@@ -0,0 +1,98 @@
+// trace_replay.cpp
+// Replays a recorded workload (common/trace.h, built by trace_convert) through the
+// strategies, in place of their own arrival patterns: every philosopher gets hungry
+// when the trace says and eats for as long as it says. Strategies:
+//   waiter, hierarchy, asymmetric, chandy-misra, monitor, semaphore
+//                    the step kernels from common/table_kernels.h
+//   waiter-bounded   flat waiter with a bound of 8 turns (common/arbitrator.h)
+//   waiter-tree      combining-tree waiter, leaves of 64, fanout 8, bound of 8 turns
+//   coloring, rotation
+//                    static schedules with a dynamic fallback (common/ring_coloring.h)
+// Reported per strategy: turns to serve the whole trace, turns actually stepped (idle
+// stretches are skipped), meals, the mean and longest wait from arrival to eating,
+// arrivals the strategy never served (see common/trace.h), and events replayed per
+// second. --scan first streams the trace's columns with no strategy
+// at all, which is the rate the input can be delivered at.
+//
+// Compile: g++ -std=c++17 -O2 trace_replay.cpp -o trace_replay
+// Run:     ./trace_replay arrivals.dptr [--strategy name|all] [--scan]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include "../common/trace.h"
+#include "../common/ring_coloring.h"
+
+const char *const NAMES[] = {"waiter", "hierarchy", "asymmetric", "chandy-misra", "monitor", "semaphore",
+                             "waiter-bounded", "waiter-tree", "coloring", "rotation"};
+
+std::unique_ptr<kernels::Table> make(const std::string &name, int n) {
+    kernels::Strategy s;
+    if (kernels::parse_strategy(name, s)) return kernels::make_table(s, n);
+    if (name == "waiter-bounded") return std::make_unique<arbiter::FlatWaiter>(n, 8);
+    if (name == "waiter-tree") return std::make_unique<arbiter::TreeWaiter>(n, 64, 8);
+    coloring::Schedule c;
+    if (coloring::parse_schedule(name, c)) return std::make_unique<coloring::ScheduledTable>(n, c);
+    return nullptr;
+}
+
+// Touches every column value once; returns a sum so the loop is not optimized away.
+uint64_t scan(const trace::Trace &t, double &seconds) {
+    const uint64_t *turn = t.turns();
+    const uint32_t *who = t.who(), *eat = t.eat();
+    uint64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < t.size(); k++) sum += turn[k] + who[k] + eat[k];
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return sum;
+}
+
+void usage(const char *prog) {
+    std::cerr << "usage: " << prog << " <trace.dptr> [--strategy name|all] [--scan]\n"
+              << "strategies:";
+    for (const char *s : NAMES) std::cerr << " " << s;
+    std::cerr << "\n";
+    std::exit(1);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) usage(argv[0]);
+    std::string strategy = "all";
+    bool do_scan = false;
+    for (int a = 2; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--scan") do_scan = true;
+        else if (arg == "--strategy" && a + 1 < argc) strategy = argv[++a];
+        else usage(argv[0]);
+    }
+    std::vector<std::string> run;
+    for (const char *s : NAMES)
+        if (strategy == "all" || strategy == s) run.push_back(s);
+    if (run.empty()) usage(argv[0]);
+
+    trace::Trace t(argv[1]);
+    int n = t.philosophers();
+    std::cout << "Replay: " << argv[1] << ", " << t.size() << " events, " << n << " philosophers\n";
+    if (do_scan) {
+        double seconds;
+        uint64_t sum = scan(t, seconds);
+        double bytes = 16.0 * t.size();
+        std::cout << "scan: " << std::fixed << std::setprecision(2) << bytes / seconds / 1e9 << " GB/s, "
+                  << std::setprecision(0) << t.size() / seconds << " events/s (checksum " << sum % 1000000 << ")\n";
+    }
+    std::cout << "strategy               turns        steps        meals  mean wait  longest wait     unserved     events/s\n";
+    for (const std::string &name : run) {
+        std::unique_ptr<kernels::Table> table = make(name, n);
+        trace::Replayed r = trace::replay(t, *table);
+        std::cout << std::left << std::setw(15) << name << std::right << std::setw(13) << r.turns << std::setw(13)
+                  << r.steps << std::setw(13) << r.meals << std::fixed << std::setprecision(2) << std::setw(11)
+                  << (r.meals ? (double)r.waited / r.meals : 0.0) << std::setw(14) << r.longest_wait << std::setw(13) << r.unserved
+                  << std::setprecision(0) << std::setw(13) << (r.seconds > 0 ? r.events / r.seconds : 0.0) << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,265 @@
+// arbitrator.h
+// Waiters that hand a hungry philosopher both forks at once (Waiter.cpp's rule), as
+// turn-stepped tables on top of common/table_kernels.h:
+//   FlatWaiter   one arbitrator sees every request, as in Waiter.cpp
+//   TreeWaiter   a combining tree of arbitrators. The ring is cut into segments of
+//                `leaf` philosophers (the last segment takes the remainder), each with
+//                a leaf waiter that owns the segment's forks and grants its own
+//                philosophers. Only a segment's last philosopher needs a fork from
+//                another leaf (its right fork is the next segment's first). Each turn
+//                every leaf queues two items for a tree of `fanout`-way nodes: the
+//                status of its first fork, and its last philosopher's request with the
+//                status of that philosopher's left fork if it is hungry. A node takes
+//                its children's queues in ring order, so a request is followed by the
+//                next leaf's fork wherever both leaves are below it. It grants that pair
+//                from the two statuses alone, drops forks nobody asked for, and passes
+//                on only its first fork and last request. The root also settles the pair
+//                that wraps around the ring. A node therefore handles at most 2 x fanout
+//                items a turn whatever the ring size, where the flat waiter handles
+//                every hungry philosopher. Boundary grants come back down before the
+//                leaves grant locally. The tree waits boundedly by default: granting
+//                the boundaries first, in a fixed order, otherwise keeps some
+//                philosophers beside a boundary waiting for as long as the run lasts.
+// A turn: eaters put their forks down and think, thinkers get hungry, then the waiters
+// grant. Either way a philosopher eats only holding both forks, and the table's safety
+// checker sees every meal. With set_hunger(p) a thinker gets hungry with probability p
+// each turn instead of always (a saturated table); replay() (table_kernels.h) replaces
+// both with a recorded trace.
+//
+// Bounded wait (bound > 0): a philosopher hungry for `bound` turns or more claims its
+// forks. A fork claimed by both its users goes to the one waiting longer (lower index on
+// a tie), and nobody else is granted a claimed fork, so the longest waiter eats as soon
+// as its neighbours' meals end. Claims are settled as the turn starts, from the waits of
+// each fork's two users, and a fork's status counts a claim by anyone else as busy.
+// Granting in index order alone can keep a philosopher waiting for as long as its
+// neighbours keep getting hungry.
+
+#pragma once
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "table_kernels.h"
+
+namespace arbiter {
+
+// Per-turn load and waits, summed over the turns run.
+struct Load {
+    long requests = 0;      // hungry philosophers seen by any arbitrator
+    long hottest = 0;       // the busiest arbitrator's items, per turn
+    long root = 0;          // items handled by the top arbitrator
+    long escalated = 0;     // requests sent above a leaf
+    long longest_wait = 0;  // turns, among granted philosophers
+    long checks = 0;        // fork checks made before granting
+    long peak_eaters = 0;   // most philosophers eating in one turn
+};
+
+class Arbitrated : public kernels::Table {
+public:
+    Arbitrated(const char *name, int n, int bound)
+        : Table(name, n), bound(bound), hungry_since(n, 0), claim(bound > 0 ? n : 0, -1) {}
+
+    const Load &load() const { return totals; }
+
+    void set_hunger(double p, unsigned seed) {
+        hunger = p;
+        rng.seed(seed);
+    }
+
+    // Longest wait so far, counting philosophers still hungry.
+    long longest_wait() const {
+        long w = totals.longest_wait;
+        for (int i = 0; i < n; i++)
+            if (state[i] == kernels::HUNGRY) w = std::max(w, turn_ - hungry_since[i]);
+        return w;
+    }
+
+protected:
+    int bound;
+    std::vector<long> hungry_since;
+    std::vector<int> claim;   // fork -> claiming philosopher, -1 if none (bounded mode)
+    Load totals;
+    long eaters = 0;          // this turn
+    double hunger = 1;
+    std::mt19937 rng;
+
+    // Eaters finish, thinkers get hungry, and long waiters claim their forks.
+    void begin_turn() {
+        for (int i = 0; i < n; i++) {
+            if (state[i] == kernels::EATING) {
+                if (!meal_over(i)) continue;
+                hold_both(i, false);
+                set(i, kernels::THINKING);
+            } else if (state[i] == kernels::THINKING &&
+                       gets_hungry(i, hunger >= 1 || std::uniform_real_distribution<double>(0, 1)(rng) < hunger)) {
+                set(i, kernels::HUNGRY);
+                hungry_since[i] = turn_;
+            }
+        }
+        eaters = 0;
+        if (!bound) return;
+        auto overdue = [&](int i) { return state[i] == kernels::HUNGRY && turn_ - hungry_since[i] >= bound; };
+        for (int f = 0; f < n; f++) {
+            int a = left(f), b = f;   // fork f is a's right fork and b's left
+            bool wa = overdue(a), wb = overdue(b);
+            if (wa && wb)
+                claim[f] = hungry_since[a] < hungry_since[b] || (hungry_since[a] == hungry_since[b] && a < b) ? a : b;
+            else
+                claim[f] = wa ? a : wb ? b : -1;
+        }
+    }
+
+    // Fork f is free and nobody but philosopher p claims it.
+    bool usable(int f, int p) const { return !forks[f] && (!bound || claim[f] < 0 || claim[f] == p); }
+
+    bool grantable(int i) {
+        totals.checks++;
+        return usable(i, i) && usable(right(i), i);
+    }
+
+    void grant(int i) {
+        hold_both(i, true);
+        set(i, kernels::EATING);
+        totals.longest_wait = std::max(totals.longest_wait, turn_ - hungry_since[i]);
+        eaters++;
+    }
+
+    void end_turn() {
+        totals.peak_eaters = std::max(totals.peak_eaters, eaters);
+        turn_++;
+    }
+};
+
+class FlatWaiter : public Arbitrated {
+public:
+    FlatWaiter(int n, int bound = 0) : Arbitrated("waiter-flat", n, bound) {}
+
+    void step() override {
+        begin_turn();
+        long seen = 0;
+        for (int i = 0; i < n; i++) {
+            if (state[i] != kernels::HUNGRY) continue;
+            seen++;
+            if (grantable(i)) grant(i);
+        }
+        totals.requests += seen;
+        totals.hottest += seen;
+        totals.root += seen;
+        end_turn();
+    }
+};
+
+class TreeWaiter : public Arbitrated {
+    // What a leaf sends up about one of its boundaries.
+    struct Item {
+        int seg;        // the sending leaf
+        bool request;   // its last philosopher asks for the next leaf's first fork;
+                        // otherwise this is the status of the leaf's own first fork
+        bool usable;    // request: the philosopher's left fork is usable by it;
+                        // fork: usable by the previous leaf's last philosopher
+    };
+
+    int fanout;
+    std::vector<int> start;     // segment s is philosophers start[s] .. start[s + 1] - 1
+    std::vector<int> level_at;  // first node id of each level, then the node count; leaves are level 0
+    std::vector<std::vector<Item>> queue;   // per node: this turn's items, then what it passes on
+    std::vector<long> items;    // this turn, per node
+
+    int segments() const { return (int)start.size() - 1; }
+    int levels() const { return (int)level_at.size() - 1; }
+    int width(int level) const { return level_at[level + 1] - level_at[level]; }
+
+    // The pair a request and the next leaf's fork make: grant both forks if both are usable.
+    void settle(const Item &request, const Item &fork) {
+        totals.checks++;
+        if (request.usable && fork.usable) grant(start[request.seg + 1] - 1);
+    }
+
+    // Settles the pairs queued at node v and leaves in its queue what goes up: the first
+    // fork and the last request. A request that is not last is always followed by the
+    // next leaf's fork, since every leaf sends its fork.
+    void combine(int v, bool root) {
+        std::vector<Item> &q = queue[v];
+        items[v] += (long)q.size();
+        size_t up = 0;
+        for (size_t k = 0; k < q.size(); k++) {
+            if (q[k].request && k + 1 < q.size()) {
+                settle(q[k], q[k + 1]);
+                k++;
+            } else if (k == 0 || q[k].request) q[up++] = q[k];
+        }
+        q.resize(up);
+        if (root && up == 2 && !q[0].request && q[1].request) settle(q[1], q[0]);
+    }
+
+public:
+    static const int BOUND = 8;   // default bounded wait, turns
+
+    TreeWaiter(int n, int leaf, int fanout, int bound = BOUND)
+        : Arbitrated("waiter-tree", n, bound), fanout(std::max(2, fanout)) {
+        int segs = std::max(1, n / std::max(2, leaf));
+        for (int s = 0; s < segs; s++) start.push_back((int)((long)s * n / segs));
+        start.push_back(n);
+        int nodes = 0;
+        for (int w = segs;; w = (w + this->fanout - 1) / this->fanout) {
+            level_at.push_back(nodes);
+            nodes += w;
+            if (w == 1) break;
+        }
+        level_at.push_back(nodes);
+        queue.resize(nodes);
+        items.resize(nodes);
+    }
+
+    void step() override {
+        begin_turn();
+        std::fill(items.begin(), items.end(), 0);
+        const int segs = segments();
+
+        // Up: every leaf queues its first fork's status and, if its last philosopher is
+        // hungry, that philosopher's request; each level combines its children's queues.
+        if (segs > 1) {
+            for (int s = 0; s < segs; s++) {
+                std::vector<Item> &q = queue[s];
+                int f = start[s], c = start[s + 1] - 1;
+                q.clear();
+                q.push_back({s, false, usable(f, left(f))});
+                if (state[c] == kernels::HUNGRY) {
+                    q.push_back({s, true, usable(c, c)});
+                    totals.requests++;
+                    totals.escalated++;
+                }
+                combine(s, false);
+            }
+            for (int k = 1; k < levels(); k++)
+                for (int j = 0; j < width(k); j++) {
+                    std::vector<Item> &q = queue[level_at[k] + j];
+                    q.clear();
+                    for (int child = j * fanout; child < std::min((j + 1) * fanout, width(k - 1)); child++) {
+                        const std::vector<Item> &below = queue[level_at[k - 1] + child];
+                        q.insert(q.end(), below.begin(), below.end());
+                    }
+                    combine(level_at[k] + j, k == levels() - 1);
+                }
+        }
+
+        // Down: the leaves grant their own philosophers.
+        for (int s = 0; s < segs; s++) {
+            int last = segs > 1 ? start[s + 1] - 1 : start[s + 1];
+            for (int i = start[s]; i < last; i++) {
+                if (state[i] != kernels::HUNGRY) continue;
+                items[s]++;
+                totals.requests++;
+                if (grantable(i)) grant(i);
+            }
+        }
+
+        long busiest = 0;
+        for (long v : items) busiest = std::max(busiest, v);
+        totals.hottest += busiest;
+        totals.root += items.back();
+        end_turn();
+    }
+};
+
+} // namespace arbiter
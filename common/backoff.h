@@ -0,0 +1,119 @@
+// backoff.h
+// Retry policies for acquisitions that poll instead of blocking (try_lock loops,
+// turn-based philosophers re-checking a fork):
+//   fixed         always wait the same amount (starvation.cpp's original 50 ms sleep)
+//   spin          retry at once; threads execute a pause instruction first
+//   spin-yield    spin for the first few failures, then give up the CPU each time
+//   exponential   wait a uniformly random 0..min(cap, base * 2^failures) ("full jitter")
+//   proportional  wait about half the mean observed hold time of the contended resource
+// A Backoff yields delays in the caller's unit: nanoseconds for threads, turns for the
+// simulators. One unit is what spin-yield asks for after spinning: a yield for a thread,
+// skipping one turn for a simulated philosopher.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace backoff {
+
+enum class Policy { FIXED, SPIN, SPIN_YIELD, EXPONENTIAL, PROPORTIONAL };
+
+const Policy ALL[] = {Policy::FIXED, Policy::SPIN, Policy::SPIN_YIELD, Policy::EXPONENTIAL,
+                      Policy::PROPORTIONAL};
+
+inline bool parse_policy(const std::string &s, Policy &out) {
+    if (s == "fixed")             out = Policy::FIXED;
+    else if (s == "spin")         out = Policy::SPIN;
+    else if (s == "spin-yield")   out = Policy::SPIN_YIELD;
+    else if (s == "exponential")  out = Policy::EXPONENTIAL;
+    else if (s == "proportional") out = Policy::PROPORTIONAL;
+    else return false;
+    return true;
+}
+
+inline const char *policy_name(Policy p) {
+    switch (p) {
+        case Policy::FIXED:        return "fixed";
+        case Policy::SPIN:         return "spin";
+        case Policy::SPIN_YIELD:   return "spin-yield";
+        case Policy::EXPONENTIAL:  return "exponential";
+        case Policy::PROPORTIONAL: return "proportional";
+    }
+    return "?";
+}
+
+struct Config {
+    long fixed;        // fixed delay
+    long base;         // exponential: first window
+    long cap;          // exponential: largest window
+    int spin_limit;    // spin-yield: failures before yielding
+};
+
+// Moving average (weight 1/8) of how long a resource is held, fed by whoever releases it.
+class HoldTimes {
+    std::atomic<double> avg{0};
+
+public:
+    void record(double held) {
+        double a = avg.load(std::memory_order_relaxed);
+        avg.store(a == 0 ? held : a + (held - a) / 8, std::memory_order_relaxed);
+    }
+    double mean() const { return avg.load(std::memory_order_relaxed); }
+};
+
+class Backoff {
+    Policy policy;
+    Config cfg;
+    int failures = 0;
+    std::minstd_rand rng;
+
+public:
+    Backoff(Policy policy, Config cfg, unsigned seed) : policy(policy), cfg(cfg), rng(seed + 1) {}
+
+    // Delay before the next try after another failure; `hold` is the mean hold time
+    // of the resource that was busy (used by proportional only).
+    long next_delay(double hold) {
+        failures++;
+        switch (policy) {
+            case Policy::FIXED:
+                return cfg.fixed;
+            case Policy::SPIN:
+                return 0;
+            case Policy::SPIN_YIELD:
+                return failures <= cfg.spin_limit ? 0 : 1;
+            case Policy::EXPONENTIAL: {
+                long window = std::min(cfg.cap, cfg.base << std::min(failures, 40));
+                return std::uniform_int_distribution<long>(0, window)(rng);
+            }
+            case Policy::PROPORTIONAL:
+                return (long)(hold / 2);
+        }
+        return 0;
+    }
+
+    void reset() { failures = 0; }
+    Policy kind() const { return policy; }
+};
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Threads: carries out a delay in nanoseconds from Backoff::next_delay.
+inline void wait(long delay_ns) {
+    if (delay_ns <= 0)
+        cpu_relax();
+    else if (delay_ns == 1)
+        std::this_thread::yield();
+    else
+        std::this_thread::sleep_for(std::chrono::nanoseconds(delay_ns));
+}
+
+} // namespace backoff
@@ -0,0 +1,206 @@
+// banker.h
+// Multi-unit, multi-type resource allocation with Banker's-algorithm deadlock
+// avoidance. A philosopher is the special case of a process claiming one unit of each of
+// two fork types; a job here claims any number of units of any of R pools, up to a
+// maximum it declares, and a request is granted only if the state afterwards is safe
+// (every process can still get its full claim in some order).
+//
+// The check comes in three strengths, with identical verdicts:
+//   FULL         the textbook reduction: scan every process, let whoever fits in the
+//                working pool finish and return its units, repeat until all have
+//                finished or nobody fits: O(processes x resources) per pass
+//   INCREMENTAL  the state before a request is known to be safe, so the state after it
+//                is safe exactly when the requester itself can still finish (whatever
+//                finishes before it returns at least what the old state's reduction
+//                had at that point, and that one went on to finish everyone). The
+//                reduction stops as soon as the requester fits, and a requester that
+//                fits the available units straight away costs O(resources).
+//   BITSET       INCREMENTAL, with the "who fits" scan done 64 processes at a time: for
+//                each pool r and level v a bitset holds the processes needing at most v
+//                units of r, so the processes that fit the working pool are the AND of
+//                one bitset per pool. A grant or release moves a process only across
+//                the levels its need passed through, so keeping the bitsets costs as
+//                many bit flips as units moved.
+//
+// Allocator is single-threaded; Blocking puts it behind a mutex and condition variable
+// for threads that wait until their request can be granted.
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace banker {
+
+enum class Check { FULL, INCREMENTAL, BITSET };
+
+enum class Verdict { GRANTED, UNAVAILABLE, UNSAFE, OVER_CLAIM };
+
+class Allocator {
+    int P, R, words;
+    Check check;
+    std::vector<int> available;   // R
+    std::vector<int> top;         // R: largest claim of any process on pool r
+    std::vector<int> alloc, need; // P x R, process-major
+    std::vector<size_t> level_at; // R: first word of pool r's level bitsets
+    std::vector<uint64_t> levels; // pool r, level v: processes with need[p][r] <= v
+    std::vector<int> work;        // scratch for the reduction
+    std::vector<uint64_t> finished;
+    std::vector<char> done;
+
+    uint64_t *level(int r, int v) { return &levels[level_at[r] + (size_t)std::min(v, top[r]) * words]; }
+
+    // need[p][r] goes from `from` to `to` units.
+    void move_need(int p, int r, int from, int to) {
+        need[(size_t)p * R + r] = to;
+        if (check != Check::BITSET) return;
+        uint64_t bit = 1ull << (p % 64);
+        for (int v = std::min(from, to); v < std::max(from, to) && v <= top[r]; v++) {
+            if (to < from) level(r, v)[p / 64] |= bit;
+            else level(r, v)[p / 64] &= ~bit;
+        }
+    }
+
+    bool fits(int p, const std::vector<int> &pool) const {
+        for (int r = 0; r < R; r++)
+            if (need[(size_t)p * R + r] > pool[r]) return false;
+        return true;
+    }
+
+    void give_back(int p) {
+        for (int r = 0; r < R; r++) work[r] += alloc[(size_t)p * R + r];
+    }
+
+    // Whether the reduction finishes everyone (FULL) or at least p (the others).
+    bool safe(int p) {
+        if (check != Check::FULL && fits(p, available)) return true;
+        work = available;
+        if (check == Check::BITSET) return reduce_bitset(p);
+        done.assign(P, 0);
+        int left = P;
+        for (bool progress = true; progress;) {
+            progress = false;
+            for (int q = 0; q < P; q++) {
+                if (done[q] || !fits(q, work)) continue;
+                if (check == Check::INCREMENTAL && q == p) return true;
+                done[q] = 1;
+                left--;
+                give_back(q);
+                progress = true;
+            }
+        }
+        return left == 0;
+    }
+
+    bool reduce_bitset(int p) {
+        finished.assign(words, 0);
+        for (bool progress = true; progress;) {
+            progress = false;
+            for (int w = 0; w < words; w++) {
+                uint64_t fit = ~finished[w];
+                for (int r = 0; r < R && fit; r++) fit &= level(r, work[r])[w];
+                if (!fit) continue;
+                if (w == p / 64 && (fit >> (p % 64) & 1)) return true;
+                finished[w] |= fit;
+                for (; fit; fit &= fit - 1) give_back(w * 64 + __builtin_ctzll(fit));
+                progress = true;
+            }
+        }
+        return false;
+    }
+
+public:
+    // capacity[r] units in pool r; claim[p][r] <= capacity[r] is the most process p
+    // will ever hold. Later claims (release_all) may not exceed the largest initial
+    // claim on each pool, which sizes the level bitsets.
+    Allocator(const std::vector<int> &capacity, const std::vector<std::vector<int>> &claim,
+              Check check = Check::BITSET)
+        : P((int)claim.size()), R((int)capacity.size()), words((P + 63) / 64), check(check),
+          available(capacity), top(R, 0), alloc((size_t)P * R, 0), need((size_t)P * R, 0) {
+        for (int p = 0; p < P; p++)
+            for (int r = 0; r < R; r++) top[r] = std::max(top[r], claim[p][r]);
+        size_t at = 0;
+        for (int r = 0; r < R; r++) {
+            level_at.push_back(at);
+            at += (size_t)(top[r] + 1) * words;
+        }
+        if (check == Check::BITSET) levels.assign(at, 0);
+        for (int p = 0; p < P; p++)
+            for (int r = 0; r < R; r++) {
+                need[(size_t)p * R + r] = top[r] + 1;   // outside every level, then lowered
+                move_need(p, r, top[r] + 1, claim[p][r]);
+            }
+    }
+
+    int processes() const { return P; }
+    int resources() const { return R; }
+    int need_of(int p, int r) const { return need[(size_t)p * R + r]; }
+    int held_by(int p, int r) const { return alloc[(size_t)p * R + r]; }
+    int available_of(int r) const { return available[r]; }
+
+    // Grants req (R units) to p if it keeps the state safe; otherwise changes nothing.
+    Verdict request(int p, const int *req) {
+        for (int r = 0; r < R; r++)
+            if (req[r] > need[(size_t)p * R + r]) return Verdict::OVER_CLAIM;
+        for (int r = 0; r < R; r++)
+            if (req[r] > available[r]) return Verdict::UNAVAILABLE;
+        for (int r = 0; r < R; r++) {
+            available[r] -= req[r];
+            alloc[(size_t)p * R + r] += req[r];
+            move_need(p, r, need[(size_t)p * R + r], need[(size_t)p * R + r] - req[r]);
+        }
+        if (safe(p)) return Verdict::GRANTED;
+        for (int r = 0; r < R; r++) {
+            available[r] += req[r];
+            alloc[(size_t)p * R + r] -= req[r];
+            move_need(p, r, need[(size_t)p * R + r], need[(size_t)p * R + r] + req[r]);
+        }
+        return Verdict::UNSAFE;
+    }
+
+    // p gives back everything it holds and declares a new claim (a finished job makes
+    // room for the next one). Releasing never makes a safe state unsafe.
+    Verdict release_all(int p, const int *claim) {
+        for (int r = 0; r < R; r++)
+            if (claim[r] > top[r]) return Verdict::OVER_CLAIM;
+        for (int r = 0; r < R; r++) {
+            available[r] += alloc[(size_t)p * R + r];
+            alloc[(size_t)p * R + r] = 0;
+            move_need(p, r, need[(size_t)p * R + r], claim[r]);
+        }
+        return Verdict::GRANTED;
+    }
+};
+
+// Allocator for threads: acquire() waits until the request can be granted.
+class Blocking {
+    Allocator a;
+    std::mutex m;
+    std::condition_variable cv;
+
+public:
+    Blocking(const std::vector<int> &capacity, const std::vector<std::vector<int>> &claim) : a(capacity, claim) {}
+
+    // False if req exceeds p's remaining claim.
+    bool acquire(int p, const int *req) {
+        std::unique_lock<std::mutex> lk(m);
+        Verdict v;
+        cv.wait(lk, [&] { return (v = a.request(p, req)) == Verdict::GRANTED || v == Verdict::OVER_CLAIM; });
+        return v == Verdict::GRANTED;
+    }
+
+    bool release_all(int p, const int *claim) {
+        Verdict v;
+        {
+            std::lock_guard<std::mutex> lk(m);
+            v = a.release_all(p, claim);
+        }
+        cv.notify_all();
+        return v == Verdict::GRANTED;
+    }
+};
+
+} // namespace banker
@@ -0,0 +1,351 @@
+// checkpoint.h
+// Checkpoint and resume for the turn-based simulators in Other 4/:
+//   --checkpoint file       save the simulation to file every --checkpoint-every turns
+//   --checkpoint-every t    (default 1000)
+//   --resume file           start from the newest checkpoint in file instead of turn 0
+// Saves happen between turns. Each program appends its own state to a Writer (its
+// philosopher and fork arrays, request flags, RNG, the Worklist and TransitionHash),
+// and on resume reads it back in the same order, so a resumed run carries on exactly
+// where the saved one was, with the same output and the same transition hash.
+//
+// The file holds two slots, so the previous checkpoint stays intact while the next
+// one is written. A save packs the state into a staging buffer (plain memory copies;
+// the only pause the step loop sees), copies it into the older slot of the mmap'd file
+// with a checksum, then stamps the slot with the next sequence number and
+// msync(MS_ASYNC)s it, leaving the write-back to the kernel. A run killed at any
+// point leaves at least one slot whose checksum matches. Resume maps the file, takes
+// the newest intact slot and reads the arrays straight out of it: one pass over the
+// image, no replay.
+//
+// Layout: FileHeader | slot | slot, a slot being SlotHeader | payload. A slot that
+// outgrows its space is moved to the end of the file.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ckpt {
+
+const uint32_t MAGIC = 0x4b435044;   // "DPCK"
+const uint32_t VERSION = 1;
+const size_t PAGE = 4096;
+
+struct Slot {
+    uint64_t offset;                 // 0 until the slot is first written
+    uint64_t capacity;
+};
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    char program[32];
+    int64_t philosophers;
+    Slot slot[2];
+};
+
+struct SlotHeader {
+    uint64_t sequence;               // 0 while being written
+    int64_t turn;                    // turns run when the state was saved
+    uint64_t bytes;                  // payload size
+    uint64_t checksum;
+};
+
+// FNV-1a over 8-byte words, then the tail and the turn.
+inline uint64_t checksum(const char *p, size_t len, int64_t turn) {
+    uint64_t h = 1469598103934665603ull;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        h = (h ^ w) * 1099511628211ull;
+    }
+    for (; i < len; i++) h = (h ^ (unsigned char)p[i]) * 1099511628211ull;
+    return (h ^ (uint64_t)turn) * 1099511628211ull;
+}
+
+struct Options {
+    std::string path;                // --checkpoint
+    std::string resume;              // --resume
+    long every = 1000;
+};
+
+const char *const USAGE = " [--checkpoint file] [--checkpoint-every t] [--resume file]";
+
+// For a program's ExtraOption callback; false if flag is not a checkpoint flag.
+inline bool parse_option(const std::string &flag, const std::string &value, Options &o) {
+    if (flag == "--checkpoint") o.path = value;
+    else if (flag == "--resume") o.resume = value;
+    else if (flag == "--checkpoint-every") return (o.every = std::atol(value.c_str())) > 0;
+    else return false;
+    return true;
+}
+
+// Packs values and arrays back to back, with no padding or framing beyond array lengths.
+class Writer {
+    std::vector<char> buf;
+
+    void raw(const void *p, size_t len) {
+        size_t at = buf.size();
+        buf.resize(at + len);
+        if (len) std::memcpy(buf.data() + at, p, len);
+    }
+
+public:
+    void clear() { buf.clear(); }
+    const char *data() const { return buf.data(); }
+    size_t size() const { return buf.size(); }
+
+    template <class T> void put(const T &v) {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values are copied as bytes");
+        raw(&v, sizeof v);
+    }
+
+    template <class T> void array(const std::vector<T> &v) {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values are copied as bytes");
+        put((uint64_t)v.size());
+        raw(v.data(), v.size() * sizeof(T));
+    }
+
+    // count values, the i-th being f(i), converted to T (a compact on-disk type).
+    template <class T, class F> void each(size_t count, F f) {
+        size_t at = buf.size();
+        buf.resize(at + count * sizeof(T));
+        for (size_t i = 0; i < count; i++) {
+            T v = f(i);
+            std::memcpy(buf.data() + at + i * sizeof(T), &v, sizeof v);
+        }
+    }
+
+    void text(const std::string &s) {
+        put((uint64_t)s.size());
+        raw(s.data(), s.size());
+    }
+};
+
+// Reads what a Writer wrote, in the same order.
+class Reader {
+    const char *p, *end;
+
+    [[noreturn]] static void truncated() {
+        std::fprintf(stderr, "checkpoint: image is shorter than its program expects\n");
+        std::exit(1);
+    }
+
+    void raw(void *out, size_t len) {
+        if ((size_t)(end - p) < len) truncated();
+        if (len) std::memcpy(out, p, len);
+        p += len;
+    }
+
+public:
+    Reader(const char *data, size_t len) : p(data), end(data + len) {}
+
+    template <class T> T get() {
+        T v;
+        raw(&v, sizeof v);
+        return v;
+    }
+
+    template <class T> void array(std::vector<T> &v) {
+        uint64_t k = get<uint64_t>();
+        if (k > (uint64_t)(end - p) / sizeof(T)) truncated();
+        v.resize(k);
+        raw(v.data(), k * sizeof(T));
+    }
+
+    // Calls f(i, value) for count values written by Writer::each<T>.
+    template <class T, class F> void each(size_t count, F f) {
+        for (size_t i = 0; i < count; i++) f(i, get<T>());
+    }
+
+    std::string text() {
+        std::vector<char> s;
+        array(s);
+        return std::string(s.begin(), s.end());
+    }
+
+    bool done() const { return p == end; }
+};
+
+// A checkpoint file being written.
+class File {
+    int fd = -1;
+    char *mem = nullptr;
+    size_t bytes = 0;
+
+    FileHeader *hdr() { return reinterpret_cast<FileHeader *>(mem); }
+    SlotHeader *at(const Slot &s) { return reinterpret_cast<SlotHeader *>(mem + s.offset); }
+
+    void grow(size_t size) {
+        if (ftruncate(fd, (off_t)size) != 0) {
+            std::perror("checkpoint: ftruncate");
+            std::exit(1);
+        }
+        void *m = mem ? mremap(mem, bytes, size, MREMAP_MAYMOVE)
+                      : mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (m == MAP_FAILED) {
+            std::perror("checkpoint: mmap");
+            std::exit(1);
+        }
+        mem = static_cast<char *>(m);
+        bytes = size;
+    }
+
+public:
+    File() = default;
+    File(const File &) = delete;
+    File &operator=(const File &) = delete;
+    ~File() {
+        if (mem) munmap(mem, bytes);
+        if (fd >= 0) close(fd);
+    }
+
+    explicit operator bool() const { return mem != nullptr; }
+
+    // Opens path for program's checkpoints of n philosophers, creating it if needed.
+    // An existing file for the same run is kept (its newest slot stays valid until the
+    // next save has completed), so --checkpoint and --resume can name the same file.
+    void open(const std::string &path, const char *program, int n) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            std::perror(("checkpoint: " + path).c_str());
+            std::exit(1);
+        }
+        if ((size_t)st.st_size < sizeof(FileHeader)) {
+            grow(PAGE);
+            FileHeader *h = hdr();
+            h->magic = MAGIC;
+            h->version = VERSION;
+            std::strncpy(h->program, program, sizeof(h->program) - 1);
+            h->philosophers = n;
+            return;
+        }
+        grow(st.st_size);
+        FileHeader *h = hdr();
+        if (h->magic != MAGIC || h->version != VERSION || std::strcmp(h->program, program) != 0 ||
+            h->philosophers != n) {
+            std::fprintf(stderr, "checkpoint: %s holds checkpoints of another run\n", path.c_str());
+            std::exit(1);
+        }
+    }
+
+    // Writes the image in w as the checkpoint after `turn` turns, over the older slot.
+    void save(long turn, const Writer &w) {
+        FileHeader *h = hdr();
+        int s;
+        if (!h->slot[0].offset) s = 0;
+        else if (!h->slot[1].offset) s = 1;
+        else s = at(h->slot[0])->sequence <= at(h->slot[1])->sequence ? 0 : 1;
+        uint64_t sequence = 1;
+        for (const Slot &o : h->slot)
+            if (o.offset) sequence = std::max(sequence, at(o)->sequence + 1);
+
+        size_t need = sizeof(SlotHeader) + w.size();
+        if (h->slot[s].capacity < need) {
+            // Move to the end of the file; the other slot is untouched.
+            size_t cap = (need + need / 2 + PAGE - 1) / PAGE * PAGE;
+            size_t offset = bytes;
+            grow(bytes + cap);
+            h = hdr();
+            h->slot[s] = {offset, cap};
+        }
+        SlotHeader *sh = at(h->slot[s]);
+        sh->sequence = 0;
+        std::memcpy(sh + 1, w.data(), w.size());
+        sh->turn = turn;
+        sh->bytes = w.size();
+        sh->checksum = checksum(w.data(), w.size(), turn);
+        __atomic_store_n(&sh->sequence, sequence, __ATOMIC_RELEASE);
+        size_t start = h->slot[s].offset / PAGE * PAGE;
+        msync(mem, PAGE, MS_ASYNC);
+        msync(mem + start, h->slot[s].offset + need - start, MS_ASYNC);
+    }
+};
+
+// The newest intact checkpoint in a file, mapped read-only.
+class Image {
+    void *mem = MAP_FAILED;
+    size_t bytes = 0;
+    const SlotHeader *slot = nullptr;
+
+public:
+    // Exits with a message if path has no intact checkpoint of program with n philosophers.
+    Image(const std::string &path, const char *program, int n) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            std::perror(("checkpoint: " + path).c_str());
+            std::exit(1);
+        }
+        bytes = st.st_size;
+        if (bytes >= sizeof(FileHeader)) mem = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED) {
+            std::fprintf(stderr, "checkpoint: cannot map %s\n", path.c_str());
+            std::exit(1);
+        }
+        const char *base = static_cast<const char *>(mem);
+        const FileHeader *h = static_cast<const FileHeader *>(mem);
+        if (h->magic != MAGIC || h->version != VERSION) {
+            std::fprintf(stderr, "checkpoint: %s is not a checkpoint file\n", path.c_str());
+            std::exit(1);
+        }
+        if (std::strncmp(h->program, program, sizeof(h->program)) != 0 || h->philosophers != n) {
+            std::fprintf(stderr, "checkpoint: %s is a checkpoint of %.32s with %ld philosophers\n",
+                         path.c_str(), h->program, (long)h->philosophers);
+            std::exit(1);
+        }
+        for (const Slot &s : h->slot) {
+            if (!s.offset || s.offset + sizeof(SlotHeader) > bytes || s.capacity > bytes - s.offset) continue;
+            const SlotHeader *sh = reinterpret_cast<const SlotHeader *>(base + s.offset);
+            if (!sh->sequence || sh->bytes > s.capacity - sizeof(SlotHeader) ||
+                checksum(reinterpret_cast<const char *>(sh + 1), sh->bytes, sh->turn) != sh->checksum)
+                continue;
+            if (!slot || sh->sequence > slot->sequence) slot = sh;
+        }
+        if (!slot) {
+            std::fprintf(stderr, "checkpoint: %s has no intact checkpoint\n", path.c_str());
+            std::exit(1);
+        }
+    }
+    ~Image() { munmap(mem, bytes); }
+    Image(const Image &) = delete;
+    Image &operator=(const Image &) = delete;
+
+    long turn() const { return slot->turn; }
+    Reader reader() const { return Reader(reinterpret_cast<const char *>(slot + 1), slot->bytes); }
+};
+
+// Periodic saves for a simulation loop.
+class Saver {
+    const Options &opt;
+    File file;
+    Writer staging;
+
+public:
+    Saver(const Options &o, const char *program, int n) : opt(o) {
+        if (!o.path.empty()) file.open(o.path, program, n);
+    }
+
+    // Call between turns with the number of turns run; save(w) appends the program's state.
+    template <class Save> void tick(long turn, Save save) {
+        if (!file || turn % opt.every) return;
+        staging.clear();
+        save(staging);
+        file.save(turn, staging);
+    }
+};
+
+} // namespace ckpt
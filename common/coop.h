@@ -0,0 +1,254 @@
+// coop.h
+// Cooperative stand-ins for std::mutex and std::condition_variable, driven by a
+// single-threaded scheduler so that every interleaving is chosen, recorded and
+// replayable. Each "thread" is a fiber (ucontext) with its own stack; it runs until
+// it reaches a scheduling point (every mutex lock, plus whatever the caller marks
+// with Scheduler::point), and a Chooser then picks which runnable fiber goes next.
+//
+// For state caching the scheduler keeps a happens-before fingerprint: each sync
+// operation folds the fiber's hash and the object's hash together and stores the
+// result in both. Two schedules that only reorder independent operations end with
+// the same fingerprints, and for code whose shared data is only touched under these
+// mutexes, the same fingerprint means the same program state.
+//
+// Not modelled: spurious wakeups, and notify_one waking anyone but the oldest waiter.
+
+#pragma once
+
+#include <ucontext.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace coop {
+
+inline uint64_t mix(uint64_t a, uint64_t b) {
+    uint64_t x = a ^ (b + 0x9e3779b97f4a7c15ull + (a << 6) + (a >> 2));
+    x ^= x >> 31;
+    x *= 0x7fb5d329728ea185ull;
+    x ^= x >> 27;
+    x *= 0x81dadef4bc2dd44dull;
+    x ^= x >> 33;
+    return x;
+}
+
+// Picks the next fiber at each scheduling point. `runnable` is sorted, `last` is the
+// fiber that just stopped (it may be blocked or finished, -1 before the first step).
+// Returning -1 abandons the run.
+class Chooser {
+public:
+    virtual ~Chooser() = default;
+    virtual int choose(const std::vector<int> &runnable, int last, long step, uint64_t fingerprint) = 0;
+};
+
+enum class Outcome { DONE, DEADLOCK, FAILED, ABANDONED };
+
+class Scheduler {
+    struct Fiber {
+        ucontext_t ctx;
+        std::unique_ptr<char[]> stack;
+        std::function<void()> body;
+        bool done = false;
+        bool blocked = false;
+        uint64_t hb = 0;
+    };
+
+    std::vector<Fiber> fibers;
+    size_t stack_size;
+    ucontext_t main_ctx;
+    int running = -1;
+    long step = 0;
+    std::string failure;
+
+    static void trampoline() {
+        Scheduler &s = *current();
+        s.fibers[s.running].body();
+        s.fibers[s.running].done = true;
+        // uc_link returns to the scheduler.
+    }
+
+public:
+    std::function<void(long step, int fiber, const char *what)> trace;   // optional event log
+
+    static Scheduler *&current() {
+        static Scheduler *s = nullptr;
+        return s;
+    }
+
+    explicit Scheduler(size_t stack_size = 64 * 1024) : stack_size(stack_size) {}
+
+    // Runs `bodies` as fibers to completion, deadlock, failure or abandonment.
+    // Fibers left unfinished are dropped without unwinding their stacks.
+    Outcome run(std::vector<std::function<void()>> bodies, Chooser &chooser) {
+        current() = this;
+        fibers.resize(bodies.size());
+        for (size_t i = 0; i < bodies.size(); i++) {
+            Fiber &f = fibers[i];
+            if (!f.stack) f.stack.reset(new char[stack_size]);
+            f.body = std::move(bodies[i]);
+            f.done = f.blocked = false;
+            f.hb = mix(0, i);
+            getcontext(&f.ctx);
+            f.ctx.uc_stack.ss_sp = f.stack.get();
+            f.ctx.uc_stack.ss_size = stack_size;
+            f.ctx.uc_link = &main_ctx;
+            makecontext(&f.ctx, trampoline, 0);
+        }
+        running = -1;
+        step = 0;
+        failure.clear();
+
+        std::vector<int> runnable;
+        int last = -1;
+        for (;;) {
+            runnable.clear();
+            bool all_done = true;
+            for (size_t i = 0; i < fibers.size(); i++) {
+                if (!fibers[i].done) all_done = false;
+                if (!fibers[i].done && !fibers[i].blocked) runnable.push_back((int)i);
+            }
+            if (all_done) return Outcome::DONE;
+            if (runnable.empty()) {
+                failure = "every unfinished fiber is blocked";
+                return Outcome::DEADLOCK;
+            }
+            int next = chooser.choose(runnable, last, step, fingerprint());
+            if (next < 0) return Outcome::ABANDONED;
+            running = next;
+            step++;
+            swapcontext(&main_ctx, &fibers[next].ctx);
+            if (!failure.empty()) return Outcome::FAILED;
+            last = next;
+        }
+    }
+
+    // Hands control back to the scheduler; the fiber stays runnable.
+    void point(const char *what) {
+        if (trace) trace(step, running, what);
+        swapcontext(&fibers[running].ctx, &main_ctx);
+    }
+
+    // The running fiber cannot continue until someone calls wake() on it.
+    void block(const char *what) {
+        fibers[running].blocked = true;
+        point(what);
+    }
+
+    void wake(int fiber) { fibers[fiber].blocked = false; }
+
+    // Ends the run as FAILED; the calling fiber is never resumed.
+    void fail(const std::string &why) {
+        failure = why;
+        swapcontext(&fibers[running].ctx, &main_ctx);
+    }
+
+    // Records a sync operation `op` by the running fiber on an object whose
+    // happens-before hash is `object`.
+    void sync(uint64_t &object, uint64_t op) {
+        uint64_t h = mix(mix(fibers[running].hb, object), op);
+        fibers[running].hb = object = h;
+    }
+
+    uint64_t fingerprint() const {
+        uint64_t h = 0;
+        for (const Fiber &f : fibers) h = mix(h, f.hb * 4 + f.done * 2 + f.blocked);
+        return h;
+    }
+
+    int self() const { return running; }
+    long steps() const { return step; }
+    const std::string &failure_message() const { return failure; }
+};
+
+class mutex {
+    int owner = -1;
+    std::deque<int> waiters;
+    uint64_t hb = 0;
+
+public:
+    mutex() = default;
+    mutex(const mutex&) = delete;
+    mutex& operator=(const mutex&) = delete;
+
+    void lock() {
+        Scheduler &s = *Scheduler::current();
+        s.point("lock");
+        while (owner != -1) {
+            s.sync(hb, 6);
+            waiters.push_back(s.self());
+            s.block("wait for lock");
+        }
+        owner = s.self();
+        s.sync(hb, 1);
+    }
+
+    bool try_lock() {
+        Scheduler &s = *Scheduler::current();
+        s.point("try_lock");
+        if (owner != -1) return false;
+        owner = s.self();
+        s.sync(hb, 1);
+        return true;
+    }
+
+    void unlock() {
+        Scheduler &s = *Scheduler::current();
+        s.sync(hb, 2);
+        owner = -1;
+        if (!waiters.empty()) {
+            s.wake(waiters.front());
+            waiters.pop_front();
+        }
+    }
+};
+
+class condition_variable {
+    std::deque<int> waiters;
+    uint64_t hb = 0;
+
+public:
+    condition_variable() = default;
+    condition_variable(const condition_variable&) = delete;
+    condition_variable& operator=(const condition_variable&) = delete;
+
+    void wait(std::unique_lock<mutex> &lk) {
+        Scheduler &s = *Scheduler::current();
+        s.sync(hb, 3);
+        waiters.push_back(s.self());
+        lk.unlock();
+        s.block("wait");
+        lk.lock();
+    }
+
+    template <class Predicate>
+    void wait(std::unique_lock<mutex> &lk, Predicate pred) {
+        while (!pred()) wait(lk);
+    }
+
+    void notify_one() {
+        Scheduler &s = *Scheduler::current();
+        s.sync(hb, 4);
+        if (waiters.empty()) return;
+        s.wake(waiters.front());
+        waiters.pop_front();
+    }
+
+    void notify_all() {
+        Scheduler &s = *Scheduler::current();
+        s.sync(hb, 5);
+        for (int w : waiters) s.wake(w);
+        waiters.clear();
+    }
+};
+
+// Sync policy for the dp:: primitives in common/primitives.h.
+struct Sync {
+    using mutex = coop::mutex;
+    using condition_variable = coop::condition_variable;
+};
+
+} // namespace coop
@@ -0,0 +1,115 @@
+// eventfd_sync.h
+// Semaphores and forks backed by eventfd(2) in semaphore mode, for code that runs on
+// an epoll reactor and cannot park a thread in Semaphore::wait() or Monitor::pickup().
+// Each object owns one non-blocking eventfd and the count lives in the kernel:
+// release() is one write() adding to it, try_acquire() is one read() that takes
+// exactly one unit (EFD_SEMAPHORE) or fails with EAGAIN. fd() polls readable while
+// the count is above zero. A reactor can register it once, edge-triggered (every
+// release is a new edge), and retry try_acquire() for its queued waiters when it fires.
+// acquire() blocks in poll() for callers that do have a thread to spare.
+//
+// Every syscall made here is counted in syscalls(), so benchmarks can report them
+// per meal. Running out of descriptors is fatal (perror and exit), as in stats_page.h;
+// a reactor with thousands of forks should raise RLIMIT_NOFILE first (raise_fd_limit).
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace efd {
+
+struct Syscalls {
+    std::atomic<long> reads{0}, writes{0}, polls{0};
+
+    long total() const { return reads + writes + polls; }
+    void reset() { reads = writes = polls = 0; }
+};
+
+inline Syscalls &syscalls() {
+    static Syscalls s;
+    return s;
+}
+
+// Soft descriptor limit up to the hard one; returns the new soft limit.
+inline long raise_fd_limit() {
+    rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) return -1;
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    getrlimit(RLIMIT_NOFILE, &rl);
+    return (long)rl.rlim_cur;
+}
+
+class Semaphore {
+    int fd_;
+
+public:
+    explicit Semaphore(unsigned initial_count)
+        : fd_(eventfd(initial_count, EFD_SEMAPHORE | EFD_NONBLOCK | EFD_CLOEXEC)) {
+        if (fd_ < 0) {
+            std::perror("eventfd");
+            std::exit(1);
+        }
+    }
+    ~Semaphore() { close(fd_); }
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+
+    int fd() const { return fd_; }
+
+    // Takes one unit if the count is above zero; never blocks.
+    bool try_acquire() {
+        uint64_t one;
+        for (;;) {
+            syscalls().reads.fetch_add(1, std::memory_order_relaxed);
+            if (read(fd_, &one, sizeof one) == sizeof one) return true;
+            if (errno == EAGAIN) return false;
+            if (errno != EINTR) {
+                std::perror("eventfd read");
+                std::exit(1);
+            }
+        }
+    }
+
+    // Blocks in poll() until a unit can be taken.
+    void acquire() {
+        while (!try_acquire()) {
+            pollfd p = {fd_, POLLIN, 0};
+            syscalls().polls.fetch_add(1, std::memory_order_relaxed);
+            poll(&p, 1, -1);
+        }
+    }
+
+    void release(unsigned n = 1) {
+        uint64_t add = n;
+        for (;;) {
+            syscalls().writes.fetch_add(1, std::memory_order_relaxed);
+            if (write(fd_, &add, sizeof add) == sizeof add) return;
+            if (errno != EINTR) {
+                std::perror("eventfd write");
+                std::exit(1);
+            }
+        }
+    }
+};
+
+// A fork is a semaphore of one: readable while it lies on the table.
+class Fork {
+    Semaphore s{1};
+
+public:
+    int fd() const { return s.fd(); }
+    bool try_pickup() { return s.try_acquire(); }
+    void pickup() { s.acquire(); }
+    void putdown() { s.release(); }
+};
+
+} // namespace efd
@@ -0,0 +1,97 @@
+// lease.h
+// Fork leases over any strategy with pickup(id)/putdown(id) (dp::Monitor,
+// dp::OrderedForks, a Semaphore.cpp room and forks, ...). A philosopher that has eaten
+// keeps its forks, still held under the strategy's own protocol, and its next meal
+// starts without any synchronization, until
+//   - a neighbour asks for them: a neighbour that has to go through the full protocol
+//     counts itself as waiting in both neighbours' seats for as long as it is inside
+//     the protocol, and the holder checks its own count between meals (one relaxed
+//     load; neighbours write that line only on their way through the protocol, and
+//     the owner's bookkeeping sits on the next line, out of their way). The count, unlike a one-shot flag, stays up until the
+//     neighbour is through, so a holder that gives the forks up and wins them straight
+//     back (a barging lock) still sees it and gives them up again; or
+//   - the lease has run its length.
+// No lease is started or kept while a neighbour waits; a lease that reaches its length
+// with a neighbour waiting counts as revoked.
+// The length adapts per philosopher: it doubles (up to max_length) each time a lease
+// runs out unrevoked, and halves (down to 1) each time one is revoked, so an idle
+// neighbourhood amortizes one acquisition over many meals while a contended one is back
+// to acquiring every meal.
+//
+// A revoked lease is handed back at the holder's next putdown() or pickup(), so a
+// neighbour can wait for the holder's thinking time. A philosopher that stops eating
+// must leave() to give back a lease it still holds.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace lease {
+
+struct alignas(64) Seat {
+    std::atomic<int> waiting{0};       // neighbours inside the full protocol
+    // Owner only:
+    alignas(64) bool held = false;
+    int used = 0;                      // meals in the current lease
+    int length = 1;                    // current lease length
+    long meals = 0;
+    long acquisitions = 0;             // runs of the full protocol
+    long revoked = 0;                  // leases cut short by a neighbour
+};
+
+template <class Forks>
+class Leased {
+    Forks &inner;
+    int n;
+    int max_length;
+    std::unique_ptr<Seat[]> seats;
+
+    void end_lease(int i, bool revoked) {
+        Seat &s = seats[i];
+        s.length = revoked ? std::max(1, s.length / 2) : std::min(max_length, s.length * 2);
+        s.revoked += revoked;
+        s.held = false;
+        inner.putdown(i);
+    }
+
+public:
+    Leased(Forks &inner, int n, int max_length = 64)
+        : inner(inner), n(n), max_length(std::max(1, max_length)), seats(new Seat[n]) {}
+
+    void pickup(int i) {
+        Seat &s = seats[i];
+        s.meals++;
+        if (s.held) {
+            if (!s.waiting.load(std::memory_order_relaxed)) {
+                s.used++;
+                return;
+            }
+            end_lease(i, true);
+        }
+        Seat &l = seats[(i + n - 1) % n], &r = seats[(i + 1) % n];
+        l.waiting.fetch_add(1);
+        r.waiting.fetch_add(1);
+        inner.pickup(i);
+        l.waiting.fetch_sub(1);
+        r.waiting.fetch_sub(1);
+        s.acquisitions++;
+        s.held = true;
+        s.used = 1;
+    }
+
+    void putdown(int i) {
+        Seat &s = seats[i];
+        if (s.waiting.load(std::memory_order_relaxed)) end_lease(i, true);
+        else if (s.used >= s.length) end_lease(i, false);
+    }
+
+    void leave(int i) {
+        if (seats[i].held) end_lease(i, false);
+    }
+
+    const Seat &seat(int i) const { return seats[i]; }
+};
+
+} // namespace lease
@@ -0,0 +1,153 @@
+// perf_counters.h
+// Per-thread kernel and hardware counters for the benchmarks, through perf_event_open:
+//   ctx-switches   software event PERF_COUNT_SW_CONTEXT_SWITCHES
+//   cache-misses   PERF_COUNT_HW_CACHE_MISSES (last-level)
+//   cycles         PERF_COUNT_HW_CPU_CYCLES
+//   instructions   PERF_COUNT_HW_INSTRUCTIONS
+//   futex          tracepoint syscalls:sys_enter_futex (needs tracefs to find its id)
+// Each counter is opened on its own, so one the kernel refuses (perf_event_paranoid,
+// no PMU inside a VM, tracefs not mounted) is simply missing from the Reading and its
+// reason is kept. When kernel-side counting is not allowed, hardware counters fall back
+// to user-space-only counts; context switches and futex calls are then missing, since
+// they only happen in the kernel. getrusage(RUSAGE_THREAD) voluntary and involuntary
+// switches are always taken as well, as the fallback for ctx-switches.
+//
+// When there are more hardware events than PMU counters the kernel multiplexes them,
+// and each one only counts for part of the time it is enabled. Every event reads its
+// enabled and running times along with its count, and the count is scaled up by
+// enabled / running; Reading::scaled says which ones were. An event that never got a
+// counter at all is missing from the Reading, like one that could not be opened.
+//
+// Usage: make a ThreadCounters on the thread to be measured, start(), run, stop().
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace perf {
+
+enum Counter { CONTEXT_SWITCHES, CACHE_MISSES, CYCLES, INSTRUCTIONS, FUTEX, COUNTERS };
+
+const char *const NAMES[COUNTERS] = {"ctx-switches", "cache-misses", "cycles", "instructions", "futex"};
+
+struct Reading {
+    long value[COUNTERS] = {};
+    bool have[COUNTERS] = {};
+    bool scaled[COUNTERS] = {};             // multiplexed: estimated from part of the run
+    long voluntary = 0, involuntary = 0;   // getrusage
+
+    Reading &operator+=(const Reading &r) {
+        for (int c = 0; c < COUNTERS; c++) {
+            value[c] += r.value[c];
+            have[c] = have[c] || r.have[c];
+            scaled[c] = scaled[c] || r.scaled[c];
+        }
+        voluntary += r.voluntary;
+        involuntary += r.involuntary;
+        return *this;
+    }
+};
+
+// Tracepoint id of syscalls:sys_enter_futex, or -1.
+inline long futex_tracepoint() {
+    static long id = [] {
+        for (const char *dir : {"/sys/kernel/tracing", "/sys/kernel/debug/tracing"}) {
+            std::ifstream f(std::string(dir) + "/events/syscalls/sys_enter_futex/id");
+            long v;
+            if (f >> v) return v;
+        }
+        return -1L;
+    }();
+    return id;
+}
+
+class ThreadCounters {
+    int fd[COUNTERS];
+    std::string why[COUNTERS];
+    rusage begin = {};
+
+    static int open_event(uint32_t type, uint64_t config, bool exclude_kernel) {
+        perf_event_attr a;
+        std::memset(&a, 0, sizeof a);
+        a.size = sizeof a;
+        a.type = type;
+        a.config = config;
+        a.disabled = 1;
+        a.exclude_hv = 1;
+        a.exclude_kernel = exclude_kernel;
+        a.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return (int)syscall(SYS_perf_event_open, &a, 0, -1, -1, 0);   // this thread, any CPU
+    }
+
+    void open(Counter c, uint32_t type, uint64_t config, bool kernel_only) {
+        fd[c] = open_event(type, config, false);
+        if (fd[c] < 0 && (errno == EACCES || errno == EPERM) && !kernel_only)
+            fd[c] = open_event(type, config, true);
+        if (fd[c] < 0) why[c] = std::strerror(errno);
+    }
+
+public:
+    // Opens the counters for the calling thread; they count only between start() and stop().
+    ThreadCounters() {
+        open(CONTEXT_SWITCHES, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, true);
+        open(CACHE_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, false);
+        open(CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, false);
+        open(INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, false);
+        long futex = futex_tracepoint();
+        if (futex >= 0) {
+            open(FUTEX, PERF_TYPE_TRACEPOINT, (uint64_t)futex, true);
+        } else {
+            fd[FUTEX] = -1;
+            why[FUTEX] = "tracefs not mounted";
+        }
+    }
+    ~ThreadCounters() {
+        for (int f : fd)
+            if (f >= 0) close(f);
+    }
+    ThreadCounters(const ThreadCounters &) = delete;
+    ThreadCounters &operator=(const ThreadCounters &) = delete;
+
+    bool have(Counter c) const { return fd[c] >= 0; }
+    // Why counter c could not be opened ("" if it was).
+    const std::string &unavailable(Counter c) const { return why[c]; }
+
+    void start() {
+        for (int f : fd)
+            if (f >= 0) {
+                ioctl(f, PERF_EVENT_IOC_RESET, 0);
+                ioctl(f, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        getrusage(RUSAGE_THREAD, &begin);
+    }
+
+    Reading stop() {
+        Reading r;
+        for (int c = 0; c < COUNTERS; c++) {
+            if (fd[c] < 0) continue;
+            ioctl(fd[c], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t v[3];   // count, time enabled, time running
+            if (read(fd[c], v, sizeof v) != sizeof v || (v[1] && !v[2])) continue;
+            r.have[c] = true;
+            r.scaled[c] = v[2] < v[1];
+            r.value[c] = r.scaled[c] ? (long)((double)v[0] * v[1] / v[2]) : (long)v[0];
+        }
+        rusage end;
+        getrusage(RUSAGE_THREAD, &end);
+        r.voluntary = end.ru_nvcsw - begin.ru_nvcsw;
+        r.involuntary = end.ru_nivcsw - begin.ru_nivcsw;
+        return r;
+    }
+};
+
+} // namespace perf
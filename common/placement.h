@@ -0,0 +1,185 @@
+// placement.h
+// Topology-aware placement of philosopher threads.
+// Reads /sys/devices/system/cpu to find which CPUs share an L2 / L3 cache and a
+// package, then maps philosopher i of an n-ring to a CPU under one of the policies:
+//   none     no pinning, the OS decides (what the programs did before)
+//   compact  philosopher i -> i-th CPU in topology order, wrapping around
+//   scatter  philosopher i -> i-th CPU when packages/L3s/L2s are taken round-robin
+//   ring     contiguous ring segments -> contiguous CPUs in topology order, so
+//            neighbours share L2/L3 and only segment boundaries cross a cache domain.
+//            A ring no larger than one L2 domain goes on that domain's CPUs, one
+//            philosopher each; else one L3 domain, else one package. Only a ring
+//            larger than a package spreads over the machine, and a ring larger than
+//            the machine gets equal segments of consecutive philosophers per CPU.
+
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+namespace placement {
+
+enum class Policy { NONE, COMPACT, SCATTER, RING };
+
+inline bool parse_policy(const std::string &s, Policy &out) {
+    if (s == "none")         out = Policy::NONE;
+    else if (s == "compact") out = Policy::COMPACT;
+    else if (s == "scatter") out = Policy::SCATTER;
+    else if (s == "ring")    out = Policy::RING;
+    else return false;
+    return true;
+}
+
+inline const char *policy_name(Policy p) {
+    switch (p) {
+        case Policy::NONE:    return "none";
+        case Policy::COMPACT: return "compact";
+        case Policy::SCATTER: return "scatter";
+        case Policy::RING:    return "ring";
+    }
+    return "?";
+}
+
+struct Cpu {
+    int id;
+    int package;
+    int core;
+    int l2;   // lowest CPU sharing this CPU's L2, or the CPU itself
+    int l3;   // likewise for L3
+};
+
+inline int read_int(const std::string &path, int fallback) {
+    std::ifstream in(path);
+    int v;
+    return (in >> v) ? v : fallback;
+}
+
+// First CPU of a list such as "0-3,8-11".
+inline int first_cpu(const std::string &path, int fallback) {
+    std::ifstream in(path);
+    std::string s;
+    if (!(in >> s)) return fallback;
+    std::stringstream ss(s);
+    int v;
+    return (ss >> v) ? v : fallback;
+}
+
+// The CPUs this process may run on, sorted so that CPUs sharing a package,
+// then an L3, then an L2, then a core are adjacent.
+inline std::vector<Cpu> topology() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    sched_getaffinity(0, sizeof(set), &set);
+
+    std::vector<Cpu> cpus;
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (!CPU_ISSET(c, &set)) continue;
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(c);
+        Cpu cpu{c, read_int(base + "/topology/physical_package_id", 0),
+                read_int(base + "/topology/core_id", c), c, c};
+        for (int k = 0; k < 8; k++) {
+            std::string idx = base + "/cache/index" + std::to_string(k);
+            int level = read_int(idx + "/level", -1);
+            if (level < 0) break;
+            if (level == 2) cpu.l2 = first_cpu(idx + "/shared_cpu_list", c);
+            if (level == 3) cpu.l3 = first_cpu(idx + "/shared_cpu_list", c);
+        }
+        cpus.push_back(cpu);
+    }
+    if (cpus.empty()) cpus.push_back({0, 0, 0, 0, 0});
+    std::sort(cpus.begin(), cpus.end(), [](const Cpu &a, const Cpu &b) {
+        return std::tie(a.package, a.l3, a.l2, a.core, a.id) <
+               std::tie(b.package, b.l3, b.l2, b.core, b.id);
+    });
+    return cpus;
+}
+
+// Topology order re-sorted so consecutive entries are as far apart as possible:
+// first by sibling rank within the L2, then L2 rank within the L3, then L3 rank
+// within the package, then package.
+inline std::vector<Cpu> scatter_order(const std::vector<Cpu> &topo) {
+    std::map<int, int> seen_in_l2, seen_l2_in_l3, seen_l3_in_pkg;
+    std::map<int, int> l2_rank, l3_rank;
+    std::vector<std::tuple<int, int, int, int, int>> keys;
+    for (size_t i = 0; i < topo.size(); i++) {
+        const Cpu &c = topo[i];
+        if (!l3_rank.count(c.l3)) l3_rank[c.l3] = seen_l3_in_pkg[c.package]++;
+        if (!l2_rank.count(c.l2)) l2_rank[c.l2] = seen_l2_in_l3[c.l3]++;
+        int sibling = seen_in_l2[c.l2]++;
+        keys.emplace_back(sibling, l2_rank[c.l2], l3_rank[c.l3], c.package, (int)i);
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<Cpu> out;
+    for (auto &k : keys) out.push_back(topo[std::get<4>(k)]);
+    return out;
+}
+
+// First index in topology order of the smallest cache domain (an L2, else an L3,
+// else a package) with at least n CPUs; 0 if none is that large.
+inline int ring_start(const std::vector<Cpu> &topo, int n) {
+    auto same = [](const Cpu &a, const Cpu &b, int level) {
+        return a.package == b.package && (level > 1 || a.l3 == b.l3) && (level > 0 || a.l2 == b.l2);
+    };
+    for (int level = 0; level < 3; level++) {
+        for (size_t b = 0, e; b < topo.size(); b = e) {
+            for (e = b; e < topo.size() && same(topo[e], topo[b], level); e++) {}
+            if (e - b >= (size_t)n) return (int)b;
+        }
+    }
+    return 0;
+}
+
+// cpu[i] for philosopher i, or -1 for "do not pin".
+inline std::vector<int> plan(Policy policy, int n) {
+    std::vector<int> out(n, -1);
+    if (policy == Policy::NONE) return out;
+    std::vector<Cpu> topo = topology();
+    if (policy == Policy::SCATTER) topo = scatter_order(topo);
+    int c = (int)topo.size();
+    int start = policy == Policy::RING && n <= c ? ring_start(topo, n) : 0;
+    for (int i = 0; i < n; i++) {
+        int slot;
+        if (policy != Policy::RING) slot = i % c;
+        else if (n <= c) slot = start + i;
+        else slot = (int)((long long)i * c / n);
+        out[i] = topo[slot].id;
+    }
+    return out;
+}
+
+inline void pin(std::thread &t, int cpu) {
+    if (cpu < 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+}
+
+inline void pin_self(int cpu) {
+    if (cpu < 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+inline void describe(std::ostream &out, Policy policy, const std::vector<int> &cpus) {
+    out << "Placement " << policy_name(policy) << ":";
+    for (size_t i = 0; i < cpus.size(); i++) {
+        out << " " << i << "->";
+        if (cpus[i] < 0) out << "any";
+        else out << "cpu" << cpus[i];
+    }
+    out << "\n";
+}
+
+} // namespace placement
@@ -0,0 +1,166 @@
+// primitives.h
+// Quiet, runtime-sized copies of the synchronization building blocks used by the
+// demo programs, for benchmarks and tools that need to drive them in a loop:
+//   Semaphore        - as in Semaphore.cpp
+//   Monitor          - as in Monitor.cpp (test()/notify_one under m)
+//   PriorityMonitor  - as in Monitor_priority.cpp (FIFO waitQ)
+//   OrderedForks     - std::mutex per fork, last philosopher takes right first (Mutex.cpp)
+// The algorithms are kept line-for-line with the originals; only the console output
+// and the compile-time table size are gone.
+//
+// Each class takes a Sync policy naming its mutex and condition variable types.
+// The plain names use std::mutex / std::condition_variable; Tools/schedule_explorer.cpp
+// instantiates the same code with the cooperative shims from common/coop.h.
+
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+
+namespace dp {
+
+enum State { THINKING, HUNGRY, EATING };
+
+struct StdSync {
+    using mutex = std::mutex;
+    using condition_variable = std::condition_variable;
+};
+
+template <class Sync = StdSync>
+class BasicSemaphore {
+    typename Sync::mutex mtx;
+    typename Sync::condition_variable cv;
+    int count;
+
+public:
+    explicit BasicSemaphore(int initial_count) : count(initial_count) {}
+    BasicSemaphore(const BasicSemaphore&) = delete;
+    BasicSemaphore& operator=(const BasicSemaphore&) = delete;
+
+    void wait() {
+        std::unique_lock<typename Sync::mutex> lock(mtx);
+        cv.wait(lock, [this] { return count > 0; });
+        --count;
+    }
+    void signal() {
+        std::unique_lock<typename Sync::mutex> lock(mtx);
+        ++count;
+        cv.notify_one();
+    }
+};
+
+template <class Sync = StdSync>
+class BasicMonitor {
+    int n;
+    typename Sync::mutex m;
+    std::vector<typename Sync::condition_variable> self;
+    std::vector<State> state;
+
+    int left(int i) { return (i + n - 1) % n; }
+    int right(int i) { return (i + 1) % n; }
+
+    void test(int i) {
+        if (state[i] == HUNGRY &&
+            state[left(i)] != EATING &&
+            state[right(i)] != EATING) {
+            state[i] = EATING;
+            self[i].notify_one();
+        }
+    }
+
+public:
+    explicit BasicMonitor(int n) : n(n), self(n), state(n, THINKING) {}
+
+    void pickup(int i) {
+        std::unique_lock<typename Sync::mutex> lk(m);
+        state[i] = HUNGRY;
+        test(i);
+        while (state[i] != EATING)
+            self[i].wait(lk);
+    }
+
+    void putdown(int i) {
+        std::unique_lock<typename Sync::mutex> lk(m);
+        state[i] = THINKING;
+        test(left(i));
+        test(right(i));
+    }
+};
+
+template <class Sync = StdSync>
+class BasicPriorityMonitor {
+    int n;
+    typename Sync::mutex m;
+    std::vector<typename Sync::condition_variable> cond;
+    std::vector<State> state;
+    std::deque<int> waitQ;
+
+    int left(int i) { return (i + n - 1) % n; }
+    int right(int i) { return (i + 1) % n; }
+
+    bool canEat(int i) {
+        return state[i] == HUNGRY &&
+               state[left(i)] != EATING &&
+               state[right(i)] != EATING;
+    }
+
+public:
+    explicit BasicPriorityMonitor(int n) : n(n), cond(n), state(n, THINKING) {}
+
+    void pickup(int i) {
+        std::unique_lock<typename Sync::mutex> lk(m);
+        state[i] = HUNGRY;
+        waitQ.push_back(i);
+        while (!(waitQ.front() == i && canEat(i)))
+            cond[i].wait(lk);
+        waitQ.pop_front();
+        state[i] = EATING;
+    }
+
+    void putdown(int i) {
+        std::unique_lock<typename Sync::mutex> lk(m);
+        state[i] = THINKING;
+        for (int pid : waitQ) {
+            if (canEat(pid)) {
+                cond[pid].notify_one();
+                break;
+            }
+        }
+    }
+};
+
+// Fork i is philosopher i's left fork; the last philosopher reaches right first.
+template <class Sync = StdSync>
+class BasicOrderedForks {
+    int n;
+    std::unique_ptr<typename Sync::mutex[]> forks;
+
+public:
+    explicit BasicOrderedForks(int n) : n(n), forks(new typename Sync::mutex[n]) {}
+
+    void pickup(int id) {
+        int left = id, right = (id + 1) % n;
+        if (id == n - 1) {
+            forks[right].lock();
+            forks[left].lock();
+        } else {
+            forks[left].lock();
+            forks[right].lock();
+        }
+    }
+
+    void putdown(int id) {
+        forks[id].unlock();
+        forks[(id + 1) % n].unlock();
+    }
+};
+
+using Semaphore = BasicSemaphore<>;
+using Monitor = BasicMonitor<>;
+using PriorityMonitor = BasicPriorityMonitor<>;
+using OrderedForks = BasicOrderedForks<>;
+
+} // namespace dp
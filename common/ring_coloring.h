@@ -0,0 +1,82 @@
+// ring_coloring.h
+// Static eating schedules from colorings of the ring's conflict graph (philosopher i
+// conflicts with i - 1 and i + 1, the other users of its forks):
+//   coloring   an optimal proper coloring: 2 colors for even n (Asymmetric.cpp's
+//              odd/even split), 3 for odd n, where one philosopher gets a color of its
+//              own. Turn t runs class t mod colors.
+//   rotation   for odd n = 2k + 1, n classes of k philosophers {r, r + 2, ..., r + 2k - 2};
+//              every class is a largest conflict-free set and each philosopher is in k
+//              of the n. This is an optimal k-fold coloring, so a saturated table gets
+//              k meals a turn where 3 colors give n / 3. For even n it is the 2-coloring.
+// A scheduled philosopher eats in its class's turn with no fork checks at all: classes
+// are conflict-free and every meal of the turn before has ended. A class member that is
+// not hungry leaves its slot free, and only then does the dynamic fallback run: hungry
+// philosophers outside the class eat, in index order, if both their forks are free.
+// The table's safety checker still sees every meal. Replayed meals can outlast a turn
+// (table_kernels.h), so only in replay does a class member check its forks: one whose
+// neighbour is still eating waits, and its slot counts as unused.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "arbitrator.h"
+
+namespace coloring {
+
+enum class Schedule { COLORING, ROTATION };
+
+inline bool parse_schedule(const std::string &s, Schedule &out) {
+    if (s == "coloring")      out = Schedule::COLORING;
+    else if (s == "rotation") out = Schedule::ROTATION;
+    else return false;
+    return true;
+}
+
+inline const char *schedule_name(Schedule s) {
+    return s == Schedule::COLORING ? "coloring" : "rotation";
+}
+
+// Number of classes in the schedule for a ring of n (n >= 2).
+inline int class_count(int n, Schedule s) {
+    if (n % 2 == 0) return 2;
+    return s == Schedule::ROTATION ? n : 3;
+}
+
+// Whether philosopher i is in class c; membership is arithmetic, so a schedule costs
+// no memory even when it has n classes.
+inline bool in_class(int n, Schedule s, int i, int c) {
+    if (n % 2 == 0) return i % 2 == c;
+    if (s == Schedule::COLORING) return (i == n - 1 ? 2 : i % 2) == c;
+    int d = ((i - c) % n + n) % n;   // class c is c, c + 2, ..., c + n - 3
+    return d % 2 == 0 && d < n - 1;
+}
+
+class ScheduledTable : public arbiter::Arbitrated {
+    Schedule schedule;
+    int classes;
+
+public:
+    ScheduledTable(int n, Schedule s)
+        : Arbitrated(schedule_name(s), n, 0), schedule(s), classes(class_count(n, s)) {}
+
+    int colors() const { return classes; }
+
+    void step() override {
+        begin_turn();
+        int c = (int)(turn_ % classes);
+        bool idle = false;
+        for (int i = 0; i < n; i++) {
+            if (!in_class(n, schedule, i, c)) continue;
+            if (state[i] == kernels::HUNGRY && (!in_replay() || both_free(i))) grant(i);
+            else idle = true;
+        }
+        // Dynamic fallback, only when a slot went unused.
+        if (idle)
+            for (int i = 0; i < n; i++)
+                if (state[i] == kernels::HUNGRY && !in_class(n, schedule, i, c) && grantable(i)) grant(i);
+        end_turn();
+    }
+};
+
+} // namespace coloring
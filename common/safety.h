@@ -0,0 +1,224 @@
+// safety.h
+// Always-on check that two neighbours never eat at the same time.
+// Every program reports eat(i) once philosopher i holds both forks and done(i) before
+// it lets go of the first one. The checker keeps the eaters as a bitmask of atomic
+// words: eat(i) sets bit i with one fetch_or and ANDs the old word with i's neighbour
+// bits (the bit rotated one place each way around the ring). Only when a neighbour
+// sits in another word (rings over 64, at word edges) is there a second load, and
+// then both sides use seq_cst so that of two racing neighbours at least one sees the
+// other. A checker opened with Threads::ONE is only called from one thread and uses
+// plain loads and stores instead: the single-threaded simulators (Other 4, deadlock,
+// deadlock_), the table kernels, Semaphore_eventfd and Chandy_Misra_distributed open
+// it that way. Everything else runs a thread per philosopher and opens Threads::MANY.
+//
+// When threads share the checker, each philosopher keeps its recent events in a small
+// ring of its own so that a violation can be reported with the trace window that led
+// to it. A Threads::ONE checker only keeps each seat's last start and last stop, one
+// plain store per event, and reports those for the seats near the violation.
+//
+// DP_SAFETY (environment) picks what a violation does:
+//   unset     print the report to stderr and abort()
+//   count     print the first few reports and keep going; violations() has the total
+//   off       no checking at all
+// Stamps only order the trace window. By default they are time-stamp counter ticks on
+// x86 (a clock read costs more than the check itself) and nanoseconds elsewhere; the
+// turn-based simulators pass the turn instead. A Threads::ONE checker never reads the
+// clock: without a stamp it numbers the events it sees.
+
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace safety {
+
+enum Event : uint8_t { EAT = 1, DONE = 2 };
+
+enum class Threads { MANY, ONE };
+
+class Checker {
+    static const int RING = 7;    // events kept per philosopher (History fills one cache line)
+
+    struct alignas(64) History {
+        std::atomic<uint32_t> head{0};
+        std::atomic<uint64_t> entry[RING] = {};   // stamp << 8 | event
+    };
+
+    struct Last {
+        uint64_t eat = 0, done = 0;   // stamp + 1 of the seat's last event of each kind, 0: none
+    };
+
+    struct Line {
+        uint64_t stamp;
+        int who;
+        Event e;
+    };
+
+    enum Mode { ABORT, COUNT, OFF };
+
+    int n = 0;
+    Mode mode = ABORT;
+    bool single = false;
+    std::string strategy;
+    std::unique_ptr<std::atomic<uint64_t>[]> eaters;
+    std::unique_ptr<History[]> history;   // Threads::MANY
+    std::unique_ptr<Last[]> last;         // Threads::ONE
+    uint64_t events = 0;                  // Threads::ONE stamp when the caller passes none
+    std::atomic<long> found{0};
+    uint64_t start = 0;
+
+    static uint64_t clock() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    uint64_t now() const { return clock() - start; }
+
+    void remember(int i, Event e, uint64_t stamp) {
+        History &h = history[i];
+        uint32_t k = h.head.load(std::memory_order_relaxed);
+        h.entry[k % RING].store(stamp << 8 | e, std::memory_order_relaxed);
+        h.head.store(k + 1, std::memory_order_relaxed);
+    }
+
+    // Philosophers up to 3 seats from i.
+    std::vector<int> seats(int i) const {
+        std::vector<int> seats;
+        for (int d = -3; d <= 3; d++) {
+            int p = ((i + d) % n + n) % n;
+            if (std::find(seats.begin(), seats.end(), p) == seats.end()) seats.push_back(p);
+        }
+        return seats;
+    }
+
+    // Events of philosophers up to 3 seats from i, oldest first.
+    std::vector<Line> window(int i) const {
+        std::vector<Line> lines;
+        for (int p : seats(i)) {
+            if (single) {
+                if (last[p].eat) lines.push_back({last[p].eat - 1, p, EAT});
+                if (last[p].done) lines.push_back({last[p].done - 1, p, DONE});
+                continue;
+            }
+            History &h = history[p];
+            uint32_t head = h.head.load(std::memory_order_relaxed);
+            for (uint32_t c = head > RING ? head - RING : 0; c < head; c++) {
+                uint64_t v = h.entry[c % RING].load(std::memory_order_relaxed);
+                lines.push_back({v >> 8, p, (Event)(v & 0xff)});
+            }
+        }
+        std::stable_sort(lines.begin(), lines.end(), [](const Line &a, const Line &b) { return a.stamp < b.stamp; });
+        return lines;
+    }
+
+    // Both neighbours of i sit in i's word, next to bit i.
+    bool inside(int i) const { return i % 64 != 0 && i % 64 != 63 && i + 1 < n; }
+
+    void eat_shared(int i, long stamp) {
+        if (stamp < 0) stamp = (long)now();
+        remember(i, EAT, stamp);
+        uint64_t b = uint64_t(1) << (i % 64), old = eaters[i / 64].fetch_or(b, std::memory_order_seq_cst);
+        if (inside(i) && !(old & (b >> 1 | b << 1))) return;
+        neighbours(i, old, stamp);
+    }
+
+    // The slow end of eat(i): old is i's word before bit i was set. Neighbours in
+    // another word (at word edges and around the end of the ring) take a second load.
+    void neighbours(int i, uint64_t old, long stamp) {
+        int l = i ? i - 1 : n - 1, r = i + 1 < n ? i + 1 : 0, w = i / 64;
+        auto eating = [&](int j) {
+            uint64_t word = j / 64 == w ? old : eaters[j / 64].load(single ? std::memory_order_relaxed
+                                                                           : std::memory_order_seq_cst);
+            return (word >> (j % 64) & 1) != 0;
+        };
+        if (eating(l)) report(i, l, stamp);
+        if (r != l && eating(r)) report(i, r, stamp);
+    }
+
+    // stamp < 0: read the clock now.
+    void report(int i, int j, long stamp) {
+        long k = found.fetch_add(1) + 1;
+        if (mode == COUNT && k > 3) return;
+        std::fprintf(stderr, "safety: %s: philosophers %d and %d are eating at once (stamp %llu)\n",
+                     strategy.c_str(), i, j, (unsigned long long)(stamp < 0 ? now() : (uint64_t)stamp));
+        std::fprintf(stderr, "safety: trace window (up to 3 seats either side of %d%s):\n", i,
+                     single ? ", last start and stop of each" : "");
+        for (const Line &l : window(i))
+            std::fprintf(stderr, "  %12llu  philosopher %d %s\n", (unsigned long long)l.stamp, l.who,
+                         l.e == EAT ? "starts eating" : "done eating");
+        if (mode == ABORT) std::abort();
+    }
+
+public:
+    Checker() = default;
+    Checker(const char *strategy, int n, Threads t = Threads::MANY) { open(strategy, n, t); }
+    Checker(const Checker &) = delete;
+    Checker &operator=(const Checker &) = delete;
+
+    // Call before any philosopher starts.
+    void open(const char *name, int philosophers, Threads t = Threads::MANY) {
+        n = philosophers;
+        single = t == Threads::ONE;
+        strategy = name;
+        const char *env = std::getenv("DP_SAFETY");
+        mode = env && !std::strcmp(env, "off") ? OFF : env && !std::strcmp(env, "count") ? COUNT : ABORT;
+        int words = (n + 63) / 64;
+        eaters.reset(new std::atomic<uint64_t>[words]);
+        for (int w = 0; w < words; w++) eaters[w].store(0, std::memory_order_relaxed);
+        if (single) last.reset(new Last[n]);
+        else history.reset(new History[n]);
+        events = 0;
+        start = clock();
+    }
+
+    // Philosopher i now holds both forks.
+    void eat(int i, long stamp = -1) {
+        if (mode == OFF || !n) return;
+        if (!single) return eat_shared(i, stamp);
+        if (stamp < 0) stamp = (long)events++;
+        last[i].eat = (uint64_t)stamp + 1;
+        std::atomic<uint64_t> &word = eaters[i / 64];
+        uint64_t b = uint64_t(1) << (i % 64), old = word.load(std::memory_order_relaxed);
+        word.store(old | b, std::memory_order_relaxed);
+        if (inside(i) && !(old & (b >> 1 | b << 1))) return;
+        neighbours(i, old, stamp);
+    }
+
+    // Philosopher i is about to put its forks down.
+    void done(int i, long stamp = -1) {
+        if (mode == OFF || !n) return;
+        if (single) last[i].done = (stamp < 0 ? events++ : (uint64_t)stamp) + 1;
+        else remember(i, DONE, stamp < 0 ? now() : (uint64_t)stamp);
+        std::atomic<uint64_t> &word = eaters[i / 64];
+        uint64_t clear = ~(uint64_t(1) << (i % 64));
+        if (single)
+            word.store(word.load(std::memory_order_relaxed) & clear, std::memory_order_relaxed);
+        else
+            word.fetch_and(clear, std::memory_order_release);
+    }
+
+    long violations() const { return found.load(); }
+};
+
+// Process-wide checker for programs with a single table; main() opens it.
+inline Checker &checker() {
+    static Checker c;
+    return c;
+}
+
+} // namespace safety
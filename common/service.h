@@ -0,0 +1,55 @@
+// service.h
+// Per-philosopher service-time classes for runs where meals are not all alike:
+//   uniform  every philosopher is "unit" (the program's original eat time)
+//   mixed    philosophers cycle short, medium, long by index; their mean meals are
+//            1x, 10x and 100x a unit meal
+// A class's scale multiplies the caller's unit (turns in the simulators, milliseconds
+// for threads). Its weight is its share under weighted fair-share scheduling: a long
+// eater gets more table time than a short one, though not 100x more.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace service {
+
+struct Class {
+    const char *name;
+    int scale;     // mean meal length in units
+    int weight;    // fair-share weight
+};
+
+const Class UNIT   = {"unit", 1, 1};
+const Class SHORT  = {"short", 1, 1};
+const Class MEDIUM = {"medium", 10, 2};
+const Class LONG   = {"long", 100, 4};
+
+enum class Mix { UNIFORM, MIXED };
+
+inline bool parse_mix(const std::string &s, Mix &out) {
+    if (s == "uniform")    out = Mix::UNIFORM;
+    else if (s == "mixed") out = Mix::MIXED;
+    else return false;
+    return true;
+}
+
+inline const char *mix_name(Mix m) { return m == Mix::MIXED ? "mixed" : "uniform"; }
+
+inline const Class &class_of(Mix m, int philosopher) {
+    if (m == Mix::UNIFORM) return UNIT;
+    static const Class *const cycle[] = {&SHORT, &MEDIUM, &LONG};
+    return *cycle[philosopher % 3];
+}
+
+// Jain's fairness index: 1 when every x is equal, 1/n when one philosopher gets it all.
+inline double jain(const std::vector<double> &x) {
+    double sum = 0, sq = 0;
+    for (double v : x) {
+        sum += v;
+        sq += v * v;
+    }
+    return sq == 0 ? 1 : sum * sum / (x.size() * sq);
+}
+
+} // namespace service
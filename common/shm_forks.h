@@ -0,0 +1,253 @@
+// shm_forks.h
+// A fork table that separate processes can share: one POSIX shared-memory segment
+// holding a process-shared, robust pthread mutex per fork, plus a seat per philosopher.
+// Philosophers take forks in Mutex.cpp's order (the last one takes its right fork first).
+//
+// The creator sizes the segment, initialises every mutex and sets ready last. Any
+// other process attaches by name with one shm_open, one fstat and one mmap, and reads n
+// from the header, so attaching costs the same at 5 philosophers as at 100000.
+//
+// If a process dies holding a fork, the next process to lock that fork gets
+// EOWNERDEAD. It clears the dead holder's eating flag, marks the mutex consistent
+// (exiting if that fails) and carries on with the fork. The holder field is set just after the lock and reset
+// just before the unlock, so it names the dead process's philosopher, or nobody if
+// the process died in between. Recoveries are counted in the header.
+//
+// Seats also carry an eating flag for a cross-process adjacency check (the
+// safety.h checker lives in one process's memory, so it cannot see the neighbours).
+// Layout: Header | Fork[n] | Seat[n], every slot on its own cache line.
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace shm {
+
+const uint32_t MAGIC = 0x4b524f46;   // "FORK"
+const uint32_t VERSION = 1;
+
+struct alignas(64) Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t philosophers;
+    int32_t creator;                     // pid
+    std::atomic<uint32_t> arrived;       // start barrier, see arrive()/start()
+    std::atomic<uint32_t> go;
+    std::atomic<uint64_t> recoveries;    // forks taken over from dead holders
+    std::atomic<uint64_t> violations;    // neighbours seen eating together
+    std::atomic<uint32_t> ready;         // set last; attach() waits for it
+};
+
+struct alignas(64) Fork {
+    pthread_mutex_t mtx;
+    std::atomic<int32_t> holder;         // philosopher, -1 while on the table
+};
+
+// Written by the philosopher sitting there, read by its neighbours.
+struct alignas(64) Seat {
+    std::atomic<uint32_t> eating;
+    std::atomic<int32_t> pid;
+    std::atomic<uint64_t> meals;
+    std::atomic<int64_t> attach_ns;      // how long this philosopher's attach() took
+};
+
+inline size_t segment_size(uint32_t n) {
+    return sizeof(Header) + n * sizeof(Fork) + n * sizeof(Seat);
+}
+
+class Table {
+    Header *hdr = nullptr;
+    Fork *forks = nullptr;
+    Seat *seats = nullptr;
+    size_t bytes = 0;
+    int n = 0;
+
+    void map(void *mem) {
+        hdr = static_cast<Header *>(mem);
+        n = (int)hdr->philosophers;
+        forks = reinterpret_cast<Fork *>(hdr + 1);
+        seats = reinterpret_cast<Seat *>(forks + n);
+    }
+
+    void lock(int f, int id) {
+        Fork &fk = forks[f];
+        int rc = pthread_mutex_lock(&fk.mtx);
+        if (rc == EOWNERDEAD) {
+            int dead = fk.holder.load();
+            if (dead >= 0) seats[dead].eating.store(0);
+            if ((rc = pthread_mutex_consistent(&fk.mtx)) != 0) {
+                errno = rc;
+                std::perror("shm: pthread_mutex_consistent");
+                std::exit(1);
+            }
+            hdr->recoveries.fetch_add(1);
+        } else if (rc != 0) {
+            errno = rc;
+            std::perror("shm: pthread_mutex_lock");
+            std::exit(1);
+        }
+        fk.holder.store(id, std::memory_order_relaxed);
+    }
+
+    void report(int i, int j) {
+        hdr->violations.fetch_add(1);
+        std::fprintf(stderr, "shm: philosophers %d and %d are eating at once\n", i, j);
+    }
+
+    void unlock(int f) {
+        forks[f].holder.store(-1, std::memory_order_relaxed);
+        pthread_mutex_unlock(&forks[f].mtx);
+    }
+
+public:
+    Table() = default;
+    Table(const Table &) = delete;
+    Table &operator=(const Table &) = delete;
+    ~Table() {
+        if (hdr) munmap(hdr, bytes);
+    }
+
+    // Makes a fresh segment for n philosophers; fails if the name is taken.
+    bool create(const char *name, int philosophers) {
+        bytes = segment_size((uint32_t)philosophers);
+        int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            std::perror("shm: shm_open");
+            return false;
+        }
+        void *mem = ftruncate(fd, (off_t)bytes) == 0
+                        ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                        : MAP_FAILED;
+        close(fd);
+        if (mem == MAP_FAILED) {
+            std::perror("shm: ftruncate/mmap");
+            shm_unlink(name);
+            return false;
+        }
+
+        // The segment is zero-filled, which is a valid all-zero state for the atomics.
+        Header *h = static_cast<Header *>(mem);
+        h->magic = MAGIC;
+        h->version = VERSION;
+        h->philosophers = (uint32_t)philosophers;
+        h->creator = (int32_t)getpid();
+        map(mem);
+
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        for (int f = 0; f < n; f++) {
+            pthread_mutex_init(&forks[f].mtx, &attr);
+            forks[f].holder.store(-1, std::memory_order_relaxed);
+        }
+        pthread_mutexattr_destroy(&attr);
+        hdr->ready.store(1, std::memory_order_release);
+        return true;
+    }
+
+    // Maps a segment made by create(), in another process or this one. Waits up to a
+    // second for the creator to finish initialising it.
+    bool attach(const char *name) {
+        int fd = shm_open(name, O_RDWR, 0);
+        if (fd < 0) {
+            std::perror("shm: shm_open");
+            return false;
+        }
+        struct stat st;
+        for (int tries = 0; fstat(fd, &st) == 0 && (size_t)st.st_size < sizeof(Header); tries++) {
+            if (tries == 1000) break;
+            usleep(1000);
+        }
+        void *mem = (size_t)st.st_size >= sizeof(Header)
+                        ? mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                        : MAP_FAILED;
+        close(fd);
+        if (mem == MAP_FAILED) {
+            std::perror("shm: mmap");
+            return false;
+        }
+        bytes = st.st_size;
+        Header *h = static_cast<Header *>(mem);
+        for (int tries = 0; !h->ready.load(std::memory_order_acquire); tries++) {
+            if (tries == 1000) break;
+            usleep(1000);
+        }
+        if (!h->ready.load(std::memory_order_acquire) || h->magic != MAGIC || h->version != VERSION ||
+            bytes < segment_size(h->philosophers)) {
+            std::fprintf(stderr, "shm: %s is not a fork table\n", name);
+            munmap(mem, bytes);
+            return false;
+        }
+        map(mem);
+        return true;
+    }
+
+    int size() const { return n; }
+    Header &header() { return *hdr; }
+    const Seat &seat(int i) const { return seats[i]; }
+
+    // Mutex.cpp's order: the last philosopher takes its right fork first.
+    void pickup(int id) {
+        int left = id, right = (id + 1) % n;
+        if (id == n - 1) {
+            lock(right, id);
+            lock(left, id);
+        } else {
+            lock(left, id);
+            lock(right, id);
+        }
+        seats[id].pid.store((int32_t)getpid(), std::memory_order_relaxed);
+        seats[id].eating.store(1);
+        int l = (id + n - 1) % n;
+        if (seats[l].eating.load()) report(id, l);
+        if (right != l && seats[right].eating.load()) report(id, right);
+    }
+
+    void putdown(int id) {
+        int left = id, right = (id + 1) % n;
+        seats[id].eating.store(0, std::memory_order_release);
+        seats[id].meals.store(seats[id].meals.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        unlock(left);
+        unlock(right);
+    }
+
+    // Start barrier for timed runs: every philosopher arrive()s, and the launcher
+    // start()s once the expected number have. Given the philosophers' processes,
+    // start() also watches them (without reaping) and returns false, leaving the
+    // barrier shut, if one exits before it arrives, e.g. because its attach() failed.
+    void arrive() {
+        hdr->arrived.fetch_add(1);
+        while (!hdr->go.load(std::memory_order_acquire)) sched_yield();
+    }
+    bool start(int expected, const std::vector<pid_t> &children = {}) {
+        for (long spins = 1; hdr->arrived.load() < (uint32_t)expected; spins++) {
+            if (spins % 1024 == 0)
+                for (pid_t pid : children) {
+                    siginfo_t info = {};
+                    if (waitid(P_PID, (id_t)pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == pid) {
+                        std::fprintf(stderr, "shm: process %d exited before the start\n", (int)pid);
+                        return false;
+                    }
+                }
+            sched_yield();
+        }
+        hdr->go.store(1, std::memory_order_release);
+        return true;
+    }
+    void set_attach_ns(int id, int64_t ns) { seats[id].attach_ns.store(ns, std::memory_order_relaxed); }
+};
+
+} // namespace shm
@@ -0,0 +1,86 @@
+// sim_options.h
+// Command line shared by the turn-based simulators in Other 4/:
+//   --philosophers n        ring size (default: the program's NUM_PHILOSOPHERS)
+//   --turns t               turn cutoff (default: the program's own limit)
+//   --stepping full|worklist
+//                           full scans every philosopher each turn (the original loop);
+//                           worklist only re-evaluates philosophers whose own state or
+//                           neighbouring forks changed, with identical output
+//   --quiet                 no per-turn log, just the closing summary
+// A program can take flags of its own through the `extra` callback.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+struct SimOptions {
+    int philosophers;
+    long max_turns;
+    bool worklist = false;
+    bool quiet = false;
+};
+
+inline void sim_usage(const char *prog, const char *extra_usage = "") {
+    std::cerr << "usage: " << prog << " [--philosophers n] [--turns t]"
+              << " [--stepping full|worklist] [--quiet]" << extra_usage << "\n";
+    std::exit(1);
+}
+
+// Handles "flag value" pairs the common parser does not know; false rejects them.
+using ExtraOption = std::function<bool(const std::string &flag, const std::string &value)>;
+
+inline SimOptions parse_sim_options(int argc, char **argv, int default_philosophers, long default_turns,
+                                    const ExtraOption &extra = nullptr, const char *extra_usage = "") {
+    SimOptions opt;
+    opt.philosophers = default_philosophers;
+    opt.max_turns = default_turns;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        bool has_value = a + 1 < argc;
+        if (arg == "--quiet") {
+            opt.quiet = true;
+        } else if (arg == "--philosophers" && has_value) {
+            opt.philosophers = std::atoi(argv[++a]);
+        } else if (arg == "--turns" && has_value) {
+            opt.max_turns = std::atol(argv[++a]);
+        } else if (arg == "--stepping" && has_value) {
+            std::string mode = argv[++a];
+            if (mode != "full" && mode != "worklist") sim_usage(argv[0], extra_usage);
+            opt.worklist = mode == "worklist";
+        } else if (extra && has_value && extra(arg, argv[a + 1])) {
+            a++;
+        } else {
+            sim_usage(argv[0], extra_usage);
+        }
+    }
+    if (opt.philosophers < 2 || opt.max_turns < 0) sim_usage(argv[0], extra_usage);
+    return opt;
+}
+
+// Order-sensitive fingerprint of every state transition (FNV-1a), printed by --quiet
+// runs so full and worklist stepping can be compared on rings too big to diff logs.
+class TransitionHash {
+    uint64_t h = 1469598103934665603ull;
+
+    void mix(uint64_t v) {
+        for (int b = 0; b < 8; b++) {
+            h ^= (v >> (8 * b)) & 0xff;
+            h *= 1099511628211ull;
+        }
+    }
+
+public:
+    void add(long turn, int philosopher, int state) {
+        mix((uint64_t)turn);
+        mix((uint64_t)philosopher);
+        mix((uint64_t)state);
+    }
+    uint64_t value() const { return h; }
+
+    template <class Writer> void save(Writer &w) const { w.put(h); }
+    template <class Reader> void load(Reader &r) { h = r.template get<uint64_t>(); }
+};
@@ -0,0 +1,158 @@
+// stats_page.h
+// Live counters for the dining-philosophers programs, published in a POSIX
+// shared-memory segment so Tools/stats_watch can attach read-only while a run is going.
+//
+// Publishing is switched on by the DP_STATS environment variable:
+//   DP_STATS=1            segment is named /dp_stats_<pid>
+//   DP_STATS=/my_run      segment is named /my_run
+// Without it the counters go to private anonymous memory, so the hot path is the
+// same either way: relaxed atomic stores into a slot only one thread writes at a
+// time. No locks and no syscalls after open().
+//
+// Layout: Header | PhilosopherSlot[n] | ForkSlot[n], every slot on its own cache line.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace stats {
+
+const uint32_t MAGIC = 0x54535044;   // "DPST"
+const uint32_t VERSION = 1;
+
+// Common state codes; each program maps its own enum onto these.
+enum State : uint32_t { THINKING = 0, HUNGRY = 1, HOLDING_ONE_FORK = 2, EATING = 3 };
+
+inline const char *state_name(uint32_t s) {
+    switch (s) {
+        case THINKING:         return "THINKING";
+        case HUNGRY:           return "HUNGRY";
+        case HOLDING_ONE_FORK: return "ONE_FORK";
+        case EATING:           return "EATING";
+    }
+    return "?";
+}
+
+inline uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+struct alignas(64) Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t philosophers;
+    int32_t pid;
+    uint64_t start_ns;                   // CLOCK_MONOTONIC at open()
+    char strategy[32];
+    std::atomic<uint64_t> turn;          // turn-based runners only
+    std::atomic<uint32_t> ready;         // set last; readers wait for it
+};
+
+// Written only by the philosopher that owns it.
+struct alignas(64) PhilosopherSlot {
+    std::atomic<uint64_t> meals;
+    std::atomic<uint32_t> state;
+};
+
+// Written only by whoever currently holds the fork.
+struct alignas(64) ForkSlot {
+    std::atomic<uint64_t> holds;
+};
+
+inline size_t segment_size(uint32_t n) {
+    return sizeof(Header) + n * sizeof(PhilosopherSlot) + n * sizeof(ForkSlot);
+}
+
+inline PhilosopherSlot *philosopher_slots(Header *h) {
+    return reinterpret_cast<PhilosopherSlot *>(h + 1);
+}
+inline ForkSlot *fork_slots(Header *h) {
+    return reinterpret_cast<ForkSlot *>(philosopher_slots(h) + h->philosophers);
+}
+
+// Single-writer increment: a load and a store, no locked read-modify-write.
+inline void bump(std::atomic<uint64_t> &c) {
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+class Page {
+    Header *hdr = nullptr;
+    PhilosopherSlot *phil = nullptr;
+    ForkSlot *forks = nullptr;
+    size_t bytes = 0;
+    std::string shm_name;
+
+public:
+    Page() = default;
+    Page(const Page &) = delete;
+    Page &operator=(const Page &) = delete;
+
+    ~Page() {
+        if (hdr) munmap(hdr, bytes);
+        if (!shm_name.empty()) shm_unlink(shm_name.c_str());
+    }
+
+    // Call once from main() before any philosopher starts.
+    void open(const char *strategy, int n) {
+        bytes = segment_size((uint32_t)n);
+        void *mem = MAP_FAILED;
+        const char *env = std::getenv("DP_STATS");
+        if (env && *env) {
+            shm_name = env[0] == '/' ? std::string(env) : "/dp_stats_" + std::to_string(getpid());
+            int fd = shm_open(shm_name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+            if (fd >= 0 && ftruncate(fd, (off_t)bytes) == 0)
+                mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (fd >= 0) close(fd);
+            if (mem == MAP_FAILED) {
+                std::perror("stats: shm_open/mmap");
+                shm_unlink(shm_name.c_str());
+                shm_name.clear();
+            } else {
+                std::fprintf(stderr, "stats: publishing to %s\n", shm_name.c_str());
+            }
+        }
+        if (mem == MAP_FAILED)
+            mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            std::perror("stats: mmap");
+            std::exit(1);
+        }
+
+        // Fresh mappings are zero-filled, which is a valid all-zero state for the atomics.
+        hdr = static_cast<Header *>(mem);
+        hdr->magic = MAGIC;
+        hdr->version = VERSION;
+        hdr->philosophers = (uint32_t)n;
+        hdr->pid = (int32_t)getpid();
+        hdr->start_ns = now_ns();
+        std::strncpy(hdr->strategy, strategy, sizeof(hdr->strategy) - 1);
+        phil = philosopher_slots(hdr);
+        forks = fork_slots(hdr);
+        hdr->ready.store(1, std::memory_order_release);
+    }
+
+    void set_state(int i, State s) { phil[i].state.store(s, std::memory_order_relaxed); }
+    void meal(int i) { bump(phil[i].meals); }
+    void fork_held(int f) { bump(forks[f].holds); }
+    void set_turn(uint64_t t) { hdr->turn.store(t, std::memory_order_relaxed); }
+};
+
+// Process-wide page; main() opens it, philosophers write through it.
+inline Page &page() {
+    static Page p;
+    return p;
+}
+
+} // namespace stats
@@ -0,0 +1,411 @@
+// table_kernels.h
+// One dining table as a quiet, step-at-a-time state machine, for programs that host
+// many tables or drive tables from outside (Other 4/Many_tables.cpp and later tools).
+// Every strategy in the repo has a kernel here; step() advances one turn and visits
+// the philosophers in index order, with the same rules as the full-scan simulators:
+//   waiter        Waiter.cpp: a hungry philosopher gets both forks at once if both are free
+//   hierarchy     Resource_hierarchy.cpp: lower-numbered fork first, both or nothing
+//   asymmetric    Asymmetric.cpp: odd philosophers take left first, even right first,
+//                 one fork per turn; thinkers get hungry every (i + 2) turns
+//   chandy-misra  Chandy_Misra.cpp: fork transfers on request, then philosopher visits,
+//                 with the clean/dirty rule Chandy_Misra.cpp leaves out: forks start
+//                 dirty with the lower-numbered user, a hungry owner keeps a clean fork,
+//                 and a requested fork goes to the neighbour that uses it (fork k's right
+//                 user is k - 1, where Chandy_Misra.cpp's rule looks at k + 1)
+//   monitor       Monitor.cpp's pickup/test/putdown: putting down grants neighbours at once
+//   semaphore     Semaphore.cpp: a room of n - 1 seats, then left fork, then right fork
+// Tables share nothing, so a runtime can step different tables on different threads.
+// Each table runs its own single-threaded safety checker (common/safety.h), stamped
+// with the turn.
+//
+// replay() swaps a strategy's own arrival pattern for a recorded one (common/trace.h):
+// a thinker then gets hungry only on an arrival passed to arrive(), taking arrivals in
+// order, and eats for the arrival's duration in turns instead of one turn. Arrivals
+// for a philosopher who is still hungry or eating wait their turn.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "safety.h"
+
+namespace kernels {
+
+enum class Strategy { WAITER, HIERARCHY, ASYMMETRIC, CHANDY_MISRA, MONITOR, SEMAPHORE };
+
+const Strategy ALL[] = {Strategy::WAITER, Strategy::HIERARCHY, Strategy::ASYMMETRIC,
+                        Strategy::CHANDY_MISRA, Strategy::MONITOR, Strategy::SEMAPHORE};
+
+inline bool parse_strategy(const std::string &s, Strategy &out) {
+    if (s == "waiter")            out = Strategy::WAITER;
+    else if (s == "hierarchy")    out = Strategy::HIERARCHY;
+    else if (s == "asymmetric")   out = Strategy::ASYMMETRIC;
+    else if (s == "chandy-misra") out = Strategy::CHANDY_MISRA;
+    else if (s == "monitor")      out = Strategy::MONITOR;
+    else if (s == "semaphore")    out = Strategy::SEMAPHORE;
+    else return false;
+    return true;
+}
+
+inline const char *strategy_name(Strategy s) {
+    switch (s) {
+        case Strategy::WAITER:       return "waiter";
+        case Strategy::HIERARCHY:    return "hierarchy";
+        case Strategy::ASYMMETRIC:   return "asymmetric";
+        case Strategy::CHANDY_MISRA: return "chandy-misra";
+        case Strategy::MONITOR:      return "monitor";
+        case Strategy::SEMAPHORE:    return "semaphore";
+    }
+    return "?";
+}
+
+enum State : unsigned char { THINKING, HUNGRY, HOLDING_ONE_FORK, EATING };
+
+class Table {
+public:
+    Table(const char *name, int n, State initial = THINKING)
+        : n(n), state(n, initial), forks(n, false), safe(name, n, safety::Threads::ONE), until(n, 0) {}
+    virtual ~Table() = default;
+
+    // Advance one turn.
+    virtual void step() = 0;
+
+    int size() const { return n; }
+    long turn() const { return turn_; }
+    long meals() const { return meals_; }
+    State state_of(int i) const { return state[i]; }
+
+    // Replay mode; call before the first step. Everyone starts out thinking.
+    void replay() {
+        replaying = true;
+        state.assign(n, THINKING);
+        head.assign(n, -1);
+        tail.assign(n, -1);
+        eat_for.assign(n, 1);
+        arrived.assign(n, 0);
+    }
+
+    // Philosopher i gets hungry now, to eat for `eat` turns (at least one).
+    void arrive(int i, uint32_t eat) {
+        int k = free_arrival;
+        if (k >= 0) free_arrival = arrivals[k].next;
+        else {
+            k = (int)arrivals.size();
+            arrivals.emplace_back();
+        }
+        arrivals[k] = {turn_, std::max<uint32_t>(eat, 1), -1};
+        (tail[i] >= 0 ? arrivals[tail[i]].next : head[i]) = k;
+        tail[i] = k;
+        backlog++;
+    }
+
+    // Replaying, with no arrival waiting and everyone thinking: nothing happens until
+    // the next arrival, so the caller may skip_to() it.
+    bool quiet() const { return replaying && !backlog && !busy; }
+    bool in_replay() const { return replaying; }
+    long pending() const { return backlog; }
+    void skip_to(long turn) { turn_ = std::max(turn_, turn); }
+
+    // Turns from arrival to eating, over replayed meals.
+    long waited() const { return wait_total; }
+    long longest_wait() const { return wait_max; }
+
+protected:
+    int n;
+    long turn_ = 0;
+    long meals_ = 0;
+    std::vector<State> state;
+    std::vector<bool> forks;   // held?
+    safety::Checker safe;
+
+    int left(int i) const { return (i + n - 1) % n; }
+    int right(int i) const { return (i + 1) % n; }
+
+    // Whether thinker i gets hungry this turn: `own` under the strategy's own pattern,
+    // the next waiting arrival when replaying.
+    bool gets_hungry(int i, bool own) {
+        if (!replaying) return own;
+        int k = head[i];
+        if (k < 0) return false;
+        head[i] = arrivals[k].next;
+        if (head[i] < 0) tail[i] = -1;
+        eat_for[i] = arrivals[k].eat;
+        arrived[i] = arrivals[k].turn;
+        arrivals[k].next = free_arrival;
+        free_arrival = k;
+        backlog--;
+        return true;
+    }
+
+    // Whether eater i's meal is over. Outside replay meals take one turn, so a
+    // philosopher granted its forks during this turn's scan (a monitor putdown
+    // granting the next philosopher) eats until the next turn, not for zero turns.
+    bool meal_over(int i) const { return turn_ >= until[i]; }
+
+    // Every state change goes through here.
+    void set(int i, State s) {
+        if (state[i] == EATING && s != EATING) {
+            safe.done(i, turn_);
+            meals_++;
+        } else if (s == EATING && state[i] != EATING) {
+            safe.eat(i, turn_);
+            until[i] = turn_ + (replaying ? eat_for[i] : 1);
+            if (replaying) {
+                wait_total += turn_ - arrived[i];
+                wait_max = std::max(wait_max, turn_ - arrived[i]);
+            }
+        }
+        if (replaying && (state[i] == THINKING) != (s == THINKING)) busy += s == THINKING ? -1 : 1;
+        state[i] = s;
+    }
+
+    bool both_free(int i) const { return !forks[i] && !forks[right(i)]; }
+    void hold_both(int i, bool held) { forks[i] = forks[right(i)] = held; }
+
+private:
+    // Replay: waiting arrivals, a FIFO per philosopher threaded through one pool.
+    struct Arrival {
+        long turn;
+        uint32_t eat;
+        int next;
+    };
+    bool replaying = false;
+    std::vector<Arrival> arrivals;
+    int free_arrival = -1;
+    std::vector<int> head, tail;
+    std::vector<uint32_t> eat_for;   // the current meal's length
+    std::vector<long> until;         // turn the current meal ends (also outside replay)
+    std::vector<long> arrived;       // turn the current hunger arrived
+    long backlog = 0;                // arrivals waiting
+    long busy = 0;                   // philosophers not thinking
+    long wait_total = 0, wait_max = 0;
+};
+
+// Waiter and resource hierarchy: both take the two forks in one step when both are
+// free, so in a single-threaded turn they behave alike.
+class BothForksTable : public Table {
+public:
+    BothForksTable(const char *name, int n) : Table(name, n) {}
+
+    void step() override {
+        for (int i = 0; i < n; i++) {
+            switch (state[i]) {
+                case THINKING:
+                    if (gets_hungry(i, true)) set(i, HUNGRY);
+                    break;
+                case HUNGRY:
+                    if (both_free(i)) {
+                        hold_both(i, true);
+                        set(i, EATING);
+                    }
+                    break;
+                case EATING:
+                    if (!meal_over(i)) break;
+                    hold_both(i, false);
+                    set(i, THINKING);
+                    break;
+                default:
+                    break;
+            }
+        }
+        turn_++;
+    }
+};
+
+class AsymmetricTable : public Table {
+public:
+    explicit AsymmetricTable(int n) : Table("asymmetric", n, HUNGRY) {}
+
+    void step() override {
+        for (int i = 0; i < n; i++) {
+            int first = i % 2 != 0 ? i : right(i);
+            int second = i % 2 != 0 ? right(i) : i;
+            switch (state[i]) {
+                case THINKING:
+                    if (gets_hungry(i, turn_ % (i + 2) == 0)) set(i, HUNGRY);
+                    break;
+                case HUNGRY:
+                    if (!forks[first]) {
+                        forks[first] = true;
+                        set(i, HOLDING_ONE_FORK);
+                    }
+                    break;
+                case HOLDING_ONE_FORK:
+                    if (!forks[second]) {
+                        forks[second] = true;
+                        set(i, EATING);
+                    }
+                    break;
+                case EATING:
+                    if (!meal_over(i)) break;
+                    hold_both(i, false);
+                    set(i, THINKING);
+                    break;
+            }
+        }
+        turn_++;
+    }
+};
+
+class ChandyMisraTable : public Table {
+    std::vector<int> owner;
+    std::vector<bool> clean, wants_left, wants_right;
+
+public:
+    // Forks start dirty with the lower-numbered of their two users, so the precedence
+    // graph is acyclic.
+    explicit ChandyMisraTable(int n) : Table("chandy-misra", n), owner(n), clean(n, false), wants_left(n), wants_right(n) {
+        for (int k = 0; k < n; k++) owner[k] = k == 0 ? 0 : k - 1;
+    }
+
+    void step() override {
+        // A requested fork moves unless its owner is eating, or is hungry and has not
+        // used it yet (clean).
+        for (int k = 0; k < n; k++) {
+            int l = left(k);   // fork k is k's left fork and k - 1's right fork
+            State o = state[owner[k]];
+            if (o == EATING || (o != THINKING && clean[k])) continue;
+            if (owner[k] != k && wants_left[k]) {
+                owner[k] = k;
+                wants_left[k] = false;
+                clean[k] = true;
+            } else if (owner[k] != l && wants_right[l]) {
+                owner[k] = l;
+                wants_right[l] = false;
+                clean[k] = true;
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            int l = i, r = right(i);
+            switch (state[i]) {
+                case THINKING:
+                    if (gets_hungry(i, turn_ % (i + 2) == 0)) set(i, HUNGRY);
+                    break;
+                case HUNGRY: {
+                    bool has_left = owner[l] == i, has_right = owner[r] == i;
+                    if (has_left && has_right) {
+                        set(i, EATING);
+                        clean[l] = clean[r] = false;
+                    } else {
+                        if (!has_left) wants_left[i] = true;
+                        if (!has_right) wants_right[i] = true;
+                    }
+                    break;
+                }
+                case EATING: {
+                    if (!meal_over(i)) break;
+                    set(i, THINKING);
+                    int ln = left(i), rn = right(i);
+                    if (wants_right[ln]) {
+                        owner[l] = ln;
+                        wants_right[ln] = false;
+                        clean[l] = true;
+                    }
+                    if (wants_left[rn]) {
+                        owner[r] = rn;
+                        wants_left[rn] = false;
+                        clean[r] = true;
+                    }
+                    wants_left[i] = wants_right[i] = false;
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        turn_++;
+    }
+};
+
+class MonitorTable : public Table {
+    void test(int i) {
+        if (state[i] == HUNGRY && state[left(i)] != EATING && state[right(i)] != EATING) {
+            hold_both(i, true);
+            set(i, EATING);
+        }
+    }
+
+public:
+    explicit MonitorTable(int n) : Table("monitor", n) {}
+
+    void step() override {
+        for (int i = 0; i < n; i++) {
+            switch (state[i]) {
+                case THINKING:   // pickup()
+                    if (!gets_hungry(i, true)) break;
+                    set(i, HUNGRY);
+                    test(i);
+                    break;
+                case EATING:     // putdown()
+                    if (!meal_over(i)) break;
+                    hold_both(i, false);
+                    set(i, THINKING);
+                    test(left(i));
+                    test(right(i));
+                    break;
+                default:         // waiting to be granted by a neighbour's putdown()
+                    break;
+            }
+        }
+        turn_++;
+    }
+};
+
+class SemaphoreTable : public Table {
+    int room;                     // free seats
+    std::vector<bool> seated;
+
+public:
+    explicit SemaphoreTable(int n) : Table("semaphore", n), room(n - 1), seated(n) {}
+
+    void step() override {
+        for (int i = 0; i < n; i++) {
+            switch (state[i]) {
+                case THINKING:
+                    if (gets_hungry(i, true)) set(i, HUNGRY);
+                    break;
+                case HUNGRY:
+                    if (!seated[i] && room > 0) {
+                        room--;
+                        seated[i] = true;
+                    }
+                    if (seated[i] && !forks[i]) {
+                        forks[i] = true;
+                        set(i, HOLDING_ONE_FORK);
+                    }
+                    break;
+                case HOLDING_ONE_FORK:
+                    if (!forks[right(i)]) {
+                        forks[right(i)] = true;
+                        set(i, EATING);
+                    }
+                    break;
+                case EATING:
+                    if (!meal_over(i)) break;
+                    hold_both(i, false);
+                    seated[i] = false;
+                    room++;
+                    set(i, THINKING);
+                    break;
+            }
+        }
+        turn_++;
+    }
+};
+
+inline std::unique_ptr<Table> make_table(Strategy s, int n) {
+    switch (s) {
+        case Strategy::WAITER:
+        case Strategy::HIERARCHY:    return std::make_unique<BothForksTable>(strategy_name(s), n);
+        case Strategy::ASYMMETRIC:   return std::make_unique<AsymmetricTable>(n);
+        case Strategy::CHANDY_MISRA: return std::make_unique<ChandyMisraTable>(n);
+        case Strategy::MONITOR:      return std::make_unique<MonitorTable>(n);
+        case Strategy::SEMAPHORE:    return std::make_unique<SemaphoreTable>(n);
+    }
+    return nullptr;
+}
+
+} // namespace kernels
@@ -0,0 +1,217 @@
+// trace.h
+// Recorded workloads for replay through any step kernel (table_kernels.h, and the
+// waiters and schedules built on it): each event is a philosopher getting hungry at a
+// turn and how many turns its meal lasts. The file is columnar and is mapped, not read:
+//   Header | turn column | who column | eat column
+// each column a plain array at a page-aligned offset, events sorted by turn:
+//   turn  uint64  the turn the philosopher gets hungry
+//   who   uint32  the philosopher, below Header::philosophers
+//   eat   uint32  meal length in turns (0 counts as 1)
+// Replay walks the three arrays in step: three sequential loads an event and no parsing,
+// with the kernel told to read ahead (MADV_SEQUENTIAL), so the trace streams in at
+// memory bandwidth and the strategy's own step is what costs. Tools/trace_convert builds
+// a trace from CSV; Tools/trace_replay runs one through the strategies.
+//
+// A table replays from its first turn. Events due at turn t arrive before step t, and
+// while the table is quiet (nothing hungry, eating or waiting) it skips ahead to the
+// next event instead of stepping through idle turns. After the last event it steps
+// until every arrival has eaten. A strategy that starves a philosopher once its
+// neighbours stop getting hungry would keep that going forever, so a replay that goes
+// longer than any meal and a lap of fork passing without a meal ending, with someone
+// hungry, stops there and reports the arrivals left unserved.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "table_kernels.h"
+
+namespace trace {
+
+const uint32_t MAGIC = 0x52545044;   // "DPTR"
+const uint32_t VERSION = 1;
+const size_t PAGE = 4096;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    int64_t philosophers;
+    uint64_t events;
+    uint64_t turn_at, who_at, eat_at;   // column offsets
+};
+
+inline size_t page_up(size_t b) { return (b + PAGE - 1) / PAGE * PAGE; }
+
+// A new trace file of up to `capacity` events, mapped for writing. Fill the columns,
+// then finish() with the number of events written; the header goes last, so a file
+// left half-written is not a valid trace.
+class Builder {
+    int fd = -1;
+    char *mem = nullptr;
+    size_t bytes = 0;
+    Header *hdr() { return reinterpret_cast<Header *>(mem); }
+
+public:
+    Builder(const std::string &path, size_t capacity) {
+        size_t turn_at = PAGE, who_at = page_up(turn_at + capacity * 8), eat_at = page_up(who_at + capacity * 4);
+        bytes = page_up(eat_at + capacity * 4);
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0 || ftruncate(fd, (off_t)bytes) != 0) {
+            std::perror(("trace: " + path).c_str());
+            std::exit(1);
+        }
+        void *m = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (m == MAP_FAILED) {
+            std::perror("trace: mmap");
+            std::exit(1);
+        }
+        mem = static_cast<char *>(m);
+        hdr()->turn_at = turn_at;
+        hdr()->who_at = who_at;
+        hdr()->eat_at = eat_at;
+    }
+    ~Builder() {
+        if (mem) munmap(mem, bytes);
+        if (fd >= 0) close(fd);
+    }
+    Builder(const Builder &) = delete;
+    Builder &operator=(const Builder &) = delete;
+
+    uint64_t *turns() { return reinterpret_cast<uint64_t *>(mem + hdr()->turn_at); }
+    uint32_t *who() { return reinterpret_cast<uint32_t *>(mem + hdr()->who_at); }
+    uint32_t *eat() { return reinterpret_cast<uint32_t *>(mem + hdr()->eat_at); }
+
+    void finish(size_t events, int philosophers) {
+        Header *h = hdr();
+        h->philosophers = philosophers;
+        h->events = events;
+        h->version = VERSION;
+        h->magic = MAGIC;
+        if (msync(mem, bytes, MS_SYNC) != 0) {
+            std::perror("trace: msync");
+            std::exit(1);
+        }
+    }
+};
+
+// A trace file, mapped read-only.
+class Trace {
+    void *mem = MAP_FAILED;
+    size_t bytes = 0;
+    const Header *h = nullptr;
+
+public:
+    // Exits with a message if path is not a trace.
+    explicit Trace(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            std::perror(("trace: " + path).c_str());
+            std::exit(1);
+        }
+        bytes = st.st_size;
+        if (bytes >= sizeof(Header)) mem = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED) {
+            std::fprintf(stderr, "trace: cannot map %s\n", path.c_str());
+            std::exit(1);
+        }
+        h = static_cast<const Header *>(mem);
+        uint64_t e = h->events;
+        auto fits = [&](uint64_t at, uint64_t width) { return at <= bytes && e <= (bytes - at) / width; };
+        if (h->magic != MAGIC || h->version != VERSION || h->philosophers < 1 || h->philosophers > INT32_MAX ||
+            !fits(h->turn_at, 8) || !fits(h->who_at, 4) || !fits(h->eat_at, 4)) {
+            std::fprintf(stderr, "trace: %s is not a trace file\n", path.c_str());
+            std::exit(1);
+        }
+        madvise(mem, bytes, MADV_SEQUENTIAL);
+    }
+    ~Trace() { munmap(mem, bytes); }
+    Trace(const Trace &) = delete;
+    Trace &operator=(const Trace &) = delete;
+
+    size_t size() const { return h->events; }
+    int philosophers() const { return (int)h->philosophers; }
+    size_t file_bytes() const { return bytes; }
+    const uint64_t *turns() const { return reinterpret_cast<const uint64_t *>((const char *)mem + h->turn_at); }
+    const uint32_t *who() const { return reinterpret_cast<const uint32_t *>((const char *)mem + h->who_at); }
+    const uint32_t *eat() const { return reinterpret_cast<const uint32_t *>((const char *)mem + h->eat_at); }
+};
+
+struct Replayed {
+    long events = 0;       // delivered to the table
+    long steps = 0;        // turns stepped, not counting skipped idle turns
+    long turns = 0;        // the table's turn at the end
+    long meals = 0;
+    long waited = 0;       // turns from arrival to eating, summed over meals
+    long longest_wait = 0;
+    long unserved = 0;     // arrivals that never got to eat
+    double seconds = 0;
+};
+
+// Streams t through table, which must be fresh (not stepped) and have t's size.
+inline Replayed replay(const Trace &t, kernels::Table &table) {
+    const int n = table.size();
+    if (t.philosophers() != n) {
+        std::fprintf(stderr, "trace: recorded for %d philosophers, table has %d\n", t.philosophers(), n);
+        std::exit(1);
+    }
+    const uint64_t *turn = t.turns();
+    const uint32_t *who = t.who(), *eat = t.eat();
+    const size_t events = t.size();
+    Replayed r;
+    // Stuck: no meal has ended for longer than the longest meal so far and a lap of
+    // fork passing, with someone hungry.
+    uint32_t longest_meal = 1;
+    long meals = 0, last_meal = 0;
+    auto stuck = [&] {
+        if (table.meals() != meals || table.quiet()) {
+            meals = table.meals();
+            last_meal = table.turn();
+            return false;
+        }
+        return table.turn() - last_meal > (long)longest_meal + 2L * n + 64;
+    };
+    auto start = std::chrono::steady_clock::now();
+    table.replay();
+    size_t k = 0;
+    while (k < events || !table.quiet()) {
+        if (table.quiet()) {
+            table.skip_to((long)turn[k]);
+            last_meal = table.turn();
+        }
+        long now = table.turn();
+        for (; k < events && (long)turn[k] <= now; k++) {
+            if (who[k] >= (uint32_t)n) {
+                std::fprintf(stderr, "trace: event %zu names philosopher %u of %d\n", k, who[k], n);
+                std::exit(1);
+            }
+            longest_meal = std::max(longest_meal, eat[k]);
+            table.arrive((int)who[k], eat[k]);
+        }
+        table.step();
+        r.steps++;
+        if (stuck()) {
+            r.unserved = table.pending() + (long)(events - k);
+            for (int i = 0; i < n; i++) r.unserved += table.state_of(i) != kernels::THINKING;
+            break;
+        }
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    r.events = (long)k;
+    r.turns = table.turn();
+    r.meals = table.meals();
+    r.waited = table.waited();
+    r.longest_wait = table.longest_wait();
+    return r;
+}
+
+} // namespace trace
@@ -0,0 +1,210 @@
+// worklist.h
+// Dirty-worklist stepping for the turn-based simulators.
+//
+// A full-scan turn visits philosophers 0..n-1 in order, and each visit sees every
+// change made earlier in the same turn. Visiting a philosopher whose inputs did not
+// change since its last visit does nothing, so it is enough to visit, in index order,
+// the philosophers that might act. When the philosopher at `position` changes
+// something philosopher k depends on, k is queued for this turn if the scan has not
+// reached it yet (k > position) and for the next turn otherwise. Per-turn cost is then
+// proportional to the number of queued philosophers instead of n.
+//
+// When a turn has marked a large share of the ring (a busy table), keeping the queue
+// costs more than the visits it saves, so the next turn is a plain scan: scan() tells
+// the caller it may visit everyone with its own loop (pop() also returns everyone),
+// and mark() only counts. While the
+// count stays high the turns after are scans too. Once it drops, nothing is known about
+// who changed, so one turn queues everyone (pop() walks the ring in index order, keeping
+// track again) before sparse turns resume. A busy table therefore costs a plain scan
+// plus one counter increment per change. Wake-ups are kept on every turn.
+//
+// Between turns all there is to a Worklist is who is queued for the next turn and the
+// pending wake-ups; save() and load() carry just that through a checkpoint (see
+// common/checkpoint.h).
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+class Worklist {
+    std::vector<long> in_current;   // turn for which i is queued in `current`
+    std::vector<long> in_next;      // turn for which i is queued in `next`
+    std::vector<int> current;       // min-heap of this turn's philosophers (sparse turns)
+    std::vector<int> next;
+
+    struct Wake {
+        long turn;
+        int k;
+        // Heap order: earliest turn, then lowest index, on top.
+        bool operator<(const Wake &o) const { return turn != o.turn ? turn > o.turn : k > o.k; }
+    };
+    std::vector<Wake> timers;       // heap of wake_at() calls
+    long turn = 0;
+    bool dense = false;             // everyone is queued this turn
+    bool scanning = false;          // this turn is a plain scan
+    long changes = 0;               // mark() calls this turn
+    int cursor = -1;                // last index returned by pop() on a dense or scan turn
+
+    bool busy(long queued) const { return queued * 8 > (long)in_current.size(); }
+
+    void push_current(int k) {
+        if (in_current[k] == turn) return;
+        in_current[k] = turn;
+        if (dense) return;
+        current.push_back(k);
+        std::push_heap(current.begin(), current.end(), std::greater<int>());
+    }
+
+public:
+    // Everyone is queued for turn 0.
+    explicit Worklist(int n) : in_current(n, -1), in_next(n, -1) {
+        for (int i = 0; i < n; i++) {
+            in_next[i] = 0;
+            next.push_back(i);
+        }
+    }
+
+    void begin_turn(long t) {
+        turn = t;
+        current.clear();
+        cursor = -1;
+        while (!timers.empty() && timers.front().turn <= t) {
+            next.push_back(timers.front().k);
+            std::pop_heap(timers.begin(), timers.end());
+            timers.pop_back();
+        }
+        bool was_scan = scanning;
+        scanning = busy(std::max(changes, (long)next.size()));
+        changes = 0;
+        dense = was_scan && !scanning;
+        if (dense) std::fill(in_current.begin(), in_current.end(), turn);
+        else if (!scanning)
+            for (int k : next) push_current(k);
+        next.clear();
+    }
+
+    // This turn visits everyone with the caller's own loop and keeps no queue.
+    bool scan() const { return scanning; }
+    // This turn visits everyone: a scan, or the turn after the last one.
+    bool everyone() const { return scanning || dense; }
+
+    // Philosopher k's inputs changed while the scan was at `position`
+    // (-1 when the change happened before any philosopher was visited this turn).
+    void mark(int k, int position) {
+        changes++;
+        if (scanning) return;
+        if (k > position) {
+            push_current(k);
+        } else if (in_next[k] != turn + 1) {
+            in_next[k] = turn + 1;
+            next.push_back(k);
+        }
+    }
+
+    // Re-evaluate k at the start of turn t regardless of its neighbours.
+    void wake_at(int k, long t) {
+        timers.push_back({t, k});
+        std::push_heap(timers.begin(), timers.end());
+    }
+
+    bool pop(int &i) {
+        if (scanning) {
+            if (++cursor >= (int)in_current.size()) return false;
+            i = cursor;
+            return true;
+        }
+        if (dense) {
+            while (++cursor < (int)in_current.size())
+                if (in_current[cursor] == turn) {
+                    i = cursor;
+                    return true;
+                }
+            return false;
+        }
+        if (current.empty()) return false;
+        std::pop_heap(current.begin(), current.end(), std::greater<int>());
+        i = current.back();
+        current.pop_back();
+        return true;
+    }
+
+    bool queued(int i) const { return scanning || in_current[i] == turn; }
+
+    // Only between turns: after the last pop() of one, before the next begin_turn().
+    // After a scan everyone is saved as queued, which resumes with a scan.
+    template <class Writer> void save(Writer &w) const {
+        w.put(turn);
+        if (scanning) {
+            std::vector<int> all(in_current.size());
+            for (int k = 0; k < (int)all.size(); k++) all[k] = k;
+            w.array(all);
+        } else {
+            w.array(next);
+        }
+        w.array(timers);
+    }
+
+    template <class Reader> void load(Reader &r) {
+        turn = r.template get<long>();
+        r.array(next);
+        r.array(timers);
+        std::fill(in_current.begin(), in_current.end(), -1);
+        std::fill(in_next.begin(), in_next.end(), -1);
+        for (int k : next) in_next[k] = turn + 1;
+        current.clear();
+        dense = false;
+        scanning = false;
+        changes = 0;
+        cursor = -1;
+    }
+};
+
+// Unordered "needs another look next phase" set, drained in index order.
+class DirtySet {
+    std::vector<char> member;
+    std::vector<int> items;
+
+public:
+    explicit DirtySet(int n, bool all = false) : member(n, all) {
+        if (all)
+            for (int i = 0; i < n; i++) items.push_back(i);
+    }
+
+    void add(int k) {
+        if (member[k]) return;
+        member[k] = 1;
+        items.push_back(k);
+    }
+
+    void clear() {
+        for (int k : items) member[k] = 0;
+        items.clear();
+    }
+
+    std::vector<int> drain() {
+        std::vector<int> out;
+        if (items.size() * 8 > member.size()) {
+            // Busy: a linear pass is cheaper than sorting.
+            out.reserve(items.size());
+            for (int k = 0; k < (int)member.size(); k++)
+                if (member[k]) out.push_back(k);
+            items.clear();
+        } else {
+            out.swap(items);
+            std::sort(out.begin(), out.end());
+        }
+        for (int k : out) member[k] = 0;
+        return out;
+    }
+
+    template <class Writer> void save(Writer &w) const { w.array(member); }
+
+    template <class Reader> void load(Reader &r) {
+        r.array(member);
+        items.clear();
+        for (int k = 0; k < (int)member.size(); k++)
+            if (member[k]) items.push_back(k);
+    }
+};